@@ -57,6 +57,8 @@
 #include "gedit-plugins-engine.h"
 #include "gedit-commands.h"
 #include "gedit-preferences-dialog.h"
+#include "gedit-recovery.h"
+#include "gedit-trace.h"
 
 #ifndef ENABLE_GVFS_METADATA
 #include "gedit-metadata-manager.h"
@@ -87,6 +89,9 @@ struct _GeditAppPrivate
 	GSettings         *window_settings;
 
 	PeasExtensionSet  *extensions;
+
+	gchar             *trace_filename;
+	guint              trace_registration_id;
 };
 
 static gboolean help = FALSE;
@@ -105,6 +110,7 @@ static GInputStream *stdin_stream = NULL;
 static GSList *file_list = NULL;
 static gint line_position = 0;
 static gint column_position = 0;
+static gchar *trace_filename = NULL;
 static GApplicationCommandLine *command_line = NULL;
 
 static const GOptionEntry options[] =
@@ -184,6 +190,14 @@ static const GOptionEntry options[] =
 		NULL
 	},
 
+	/* Write the timings of opening and saving files on exit */
+	{
+		"trace", '\0', 0, G_OPTION_ARG_FILENAME,
+		&trace_filename,
+		N_("Write the time taken by each phase of loading and saving files to FILE on exit"),
+		N_("FILE")
+	},
+
 	/* collects file arguments */
 	{
 		G_OPTION_REMAINING, '\0', 0, G_OPTION_ARG_FILENAME_ARRAY,
@@ -215,6 +229,9 @@ gedit_app_dispose (GObject *object)
 
 	g_clear_object (&app->priv->engine);
 
+	g_free (app->priv->trace_filename);
+	app->priv->trace_filename = NULL;
+
 	G_OBJECT_CLASS (gedit_app_parent_class)->dispose (object);
 }
 
@@ -777,6 +794,8 @@ gedit_app_activate (GApplication *application)
 	}
 
 	gtk_window_present (GTK_WINDOW (window));
+
+	_gedit_recovery_offer (window);
 }
 
 static GOptionContext *
@@ -801,6 +820,7 @@ clear_options (void)
 	g_free (encoding_charset);
 	g_strfreev (remaining_args);
 	g_free (geometry);
+	g_free (trace_filename);
 	g_clear_object (&stdin_stream);
 	g_slist_free_full (file_list, g_object_unref);
 
@@ -818,6 +838,7 @@ clear_options (void)
 	file_list = NULL;
 	line_position = 0;
 	column_position = 0;
+	trace_filename = NULL;
 	command_line = NULL;
 }
 
@@ -894,6 +915,20 @@ gedit_app_command_line (GApplication            *application,
 			g_free (encoding_charset);
 		}
 
+		if (trace_filename)
+		{
+			GeditApp *app = GEDIT_APP (application);
+			GFile *file;
+
+			/* Relative to the directory of the command line */
+			file = g_application_command_line_create_file_for_arg (cl, trace_filename);
+
+			g_free (app->priv->trace_filename);
+			app->priv->trace_filename = g_file_get_path (file);
+
+			g_object_unref (file);
+		}
+
 		/* Parse filenames */
 		if (remaining_args)
 		{
@@ -1125,6 +1160,96 @@ save_print_settings (GeditApp *app)
 	g_free (filename);
 }
 
+static const gchar trace_introspection_xml[] =
+	"<node>"
+	"  <interface name='org.gnome.gedit.Trace'>"
+	"    <method name='Dump'>"
+	"      <arg type='s' name='trace' direction='out'/>"
+	"    </method>"
+	"  </interface>"
+	"</node>";
+
+static void
+trace_method_call (GDBusConnection       *connection,
+		   const gchar           *sender,
+		   const gchar           *object_path,
+		   const gchar           *interface_name,
+		   const gchar           *method_name,
+		   GVariant              *parameters,
+		   GDBusMethodInvocation *invocation,
+		   gpointer               user_data)
+{
+	if (g_strcmp0 (method_name, "Dump") == 0)
+	{
+		gchar *json;
+
+		json = gedit_trace_to_json ();
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new ("(s)", json));
+		g_free (json);
+	}
+}
+
+static const GDBusInterfaceVTable trace_vtable =
+{
+	trace_method_call,
+	NULL,
+	NULL
+};
+
+static gboolean
+gedit_app_dbus_register (GApplication     *application,
+			 GDBusConnection  *connection,
+			 const gchar      *object_path,
+			 GError          **error)
+{
+	GeditApp *app = GEDIT_APP (application);
+	GDBusNodeInfo *info;
+
+	if (!G_APPLICATION_CLASS (gedit_app_parent_class)->dbus_register (application,
+									 connection,
+									 object_path,
+									 error))
+	{
+		return FALSE;
+	}
+
+	/* Lets the load and save timings of a running instance be dumped */
+	info = g_dbus_node_info_new_for_xml (trace_introspection_xml, NULL);
+
+	app->priv->trace_registration_id =
+		g_dbus_connection_register_object (connection,
+						   object_path,
+						   info->interfaces[0],
+						   &trace_vtable,
+						   NULL,
+						   NULL,
+						   error);
+
+	g_dbus_node_info_unref (info);
+
+	return app->priv->trace_registration_id != 0;
+}
+
+static void
+gedit_app_dbus_unregister (GApplication    *application,
+			   GDBusConnection *connection,
+			   const gchar     *object_path)
+{
+	GeditApp *app = GEDIT_APP (application);
+
+	if (app->priv->trace_registration_id != 0)
+	{
+		g_dbus_connection_unregister_object (connection,
+						     app->priv->trace_registration_id);
+		app->priv->trace_registration_id = 0;
+	}
+
+	G_APPLICATION_CLASS (gedit_app_parent_class)->dbus_unregister (application,
+								       connection,
+								       object_path);
+}
+
 static void
 gedit_app_shutdown (GApplication *app)
 {
@@ -1143,6 +1268,17 @@ gedit_app_shutdown (GApplication *app)
 
 	gedit_dirs_shutdown ();
 
+	if (GEDIT_APP (app)->priv->trace_filename != NULL)
+	{
+		GError *error = NULL;
+
+		if (!gedit_trace_write_file (GEDIT_APP (app)->priv->trace_filename, &error))
+		{
+			g_warning ("Could not write the trace: %s", error->message);
+			g_error_free (error);
+		}
+	}
+
 	G_APPLICATION_CLASS (gedit_app_parent_class)->shutdown (app);
 }
 
@@ -1223,6 +1359,8 @@ gedit_app_class_init (GeditAppClass *klass)
 	app_class->command_line = gedit_app_command_line;
 	app_class->local_command_line = gedit_app_local_command_line;
 	app_class->shutdown = gedit_app_shutdown;
+	app_class->dbus_register = gedit_app_dbus_register;
+	app_class->dbus_unregister = gedit_app_dbus_unregister;
 
 	klass->show_help = gedit_app_show_help_impl;
 	klass->help_link_id = gedit_app_help_link_id_impl;
@@ -1032,8 +1032,7 @@ _gedit_cmd_file_save_documents_list (GeditWindow *window,
 		g_return_if_fail (state != GEDIT_TAB_STATE_CLOSING);
 
 		if ((state == GEDIT_TAB_STATE_NORMAL) ||
-		    (state == GEDIT_TAB_STATE_SHOWING_PRINT_PREVIEW) ||
-		    (state == GEDIT_TAB_STATE_GENERIC_NOT_EDITABLE))
+		    (state == GEDIT_TAB_STATE_SHOWING_PRINT_PREVIEW))
 		{
 			if (_gedit_document_needs_saving (doc))
 			{
@@ -1047,7 +1046,9 @@ _gedit_cmd_file_save_documents_list (GeditWindow *window,
 				}
 				else
 				{
-					_gedit_cmd_file_save_tab (t, window);
+					/* The save scheduler shows the progress of
+					 * all the saves in the statusbar */
+					_gedit_tab_save (t);
 				}
 			}
 		}
@@ -1063,6 +1064,8 @@ _gedit_cmd_file_save_documents_list (GeditWindow *window,
 			     two operations using the message area at the same time (may be we can remove
 			     this limitation in the future). Note that SaveAll, ClosAll
 			     and Quit are unsensitive if the window state is PRINTING.
+			   - GEDIT_TAB_STATE_GENERIC_NOT_EDITABLE: the document is being changed, e.g.
+			     by Replace All, and can not be saved until it is done
 			   - GEDIT_TAB_STATE_GENERIC_ERROR: we do not save since the document contains
 			     errors (I don't think this is a very frequent case, we should probably remove
 			     this state)
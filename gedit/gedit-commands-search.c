@@ -47,9 +47,13 @@
 #include "gedit-window-private.h"
 #include "gedit-utils.h"
 #include "gedit-replace-dialog.h"
+#include "gedit-search-panel.h"
+#include "gedit-progress-info-bar.h"
+#include "gedit-tab.h"
 
 #define GEDIT_REPLACE_DIALOG_KEY	"gedit-replace-dialog-key"
 #define GEDIT_LAST_SEARCH_DATA_KEY	"gedit-last-search-data-key"
+#define GEDIT_REPLACE_ALL_DATA_KEY	"gedit-replace-all-data-key"
 
 typedef struct _LastSearchData LastSearchData;
 struct _LastSearchData
@@ -380,9 +384,79 @@ run_backward_search (GeditWindow *window,
 	}
 }
 
+static GFile *
+get_file_browser_root (GeditWindow *window)
+{
+	GeditMessageBus *bus;
+	GeditMessage *message;
+	GFile *root = NULL;
+
+	bus = gedit_window_get_message_bus (window);
+
+	if (!gedit_message_bus_is_registered (bus, "/plugins/filebrowser", "get_root"))
+	{
+		return NULL;
+	}
+
+	message = gedit_message_bus_send_sync (bus, "/plugins/filebrowser", "get_root", NULL);
+
+	if (message != NULL)
+	{
+		g_object_get (message, "location", &root, NULL);
+		g_object_unref (message);
+	}
+
+	return root;
+}
+
 static void
-do_find (GeditReplaceDialog *dialog,
-	 GeditWindow        *window)
+find_in_all_documents (GeditReplaceDialog *dialog,
+		       GeditWindow        *window)
+{
+	GeditDocument *doc;
+	GtkSourceSearchContext *search_context;
+	GtkWidget *panel;
+	GFile *root = NULL;
+
+	doc = gedit_window_get_active_document (window);
+
+	if (doc == NULL)
+	{
+		return;
+	}
+
+	/* The dialog already set the search settings of the active document */
+	search_context = _gedit_document_get_search_context (doc);
+
+	if (search_context == NULL)
+	{
+		return;
+	}
+
+	if (gedit_replace_dialog_get_include_browser_root (dialog))
+	{
+		root = get_file_browser_root (window);
+	}
+
+	panel = _gedit_window_get_search_panel (window);
+
+	gedit_search_panel_search (GEDIT_SEARCH_PANEL (panel),
+				   gtk_source_search_context_get_settings (search_context),
+				   root);
+
+	gtk_stack_set_visible_child (GTK_STACK (gedit_window_get_bottom_panel (window)),
+				     panel);
+	gtk_widget_show (window->priv->bottom_panel_box);
+
+	if (root != NULL)
+	{
+		g_object_unref (root);
+	}
+}
+
+static void
+find_in_active_document (GeditReplaceDialog *dialog,
+			 GeditWindow        *window)
 {
 	if (gedit_replace_dialog_get_backwards (dialog))
 	{
@@ -394,6 +468,20 @@ do_find (GeditReplaceDialog *dialog,
 	}
 }
 
+static void
+do_find (GeditReplaceDialog *dialog,
+	 GeditWindow        *window)
+{
+	if (gedit_replace_dialog_get_all_documents (dialog))
+	{
+		find_in_all_documents (dialog, window);
+	}
+	else
+	{
+		find_in_active_document (dialog, window);
+	}
+}
+
 static void
 do_replace (GeditReplaceDialog *dialog,
 	    GeditWindow        *window)
@@ -413,6 +501,12 @@ do_replace (GeditReplaceDialog *dialog,
 		return;
 	}
 
+	/* Wait for Replace All to be done with this document */
+	if (g_object_get_data (G_OBJECT (doc), GEDIT_REPLACE_ALL_DATA_KEY) != NULL)
+	{
+		return;
+	}
+
 	search_context = _gedit_document_get_search_context (doc);
 
 	if (search_context == NULL)
@@ -443,23 +537,301 @@ do_replace (GeditReplaceDialog *dialog,
 		g_error_free (error);
 	}
 
-	do_find (dialog, window);
+	find_in_active_document (dialog, window);
+}
+
+/* Replace All is done in chunks from an idle so that huge documents do not
+ * freeze the window. Every chunk works for at most REPLACE_ALL_TIME_SLICE
+ * seconds, and all the chunks are grouped in a single user action, so that
+ * the whole operation (even when cancelled) is undone in one step.
+ */
+#define REPLACE_ALL_TIME_SLICE 0.010
+
+typedef struct _ReplaceAllData ReplaceAllData;
+struct _ReplaceAllData
+{
+	GeditWindow *window;
+	GeditReplaceDialog *dialog;
+	GeditTab *tab;
+	GeditDocument *doc;
+	GtkSourceSearchContext *search_context;
+	gchar *replace_text;
+
+	/* Where the next search starts, it is kept after the replaced text
+	 * thanks to its right gravity.
+	 */
+	GtkTextMark *position;
+
+	GtkWidget *info_bar;
+	GTimer *timer;
+	GCancellable *cancellable;
+
+	gint count;
+};
+
+/* The search settings can change while Replace All runs, e.g. when typing
+ * in the search entry, so it works with a copy of them */
+static GtkSourceSearchContext *
+create_replace_all_context (GeditDocument           *doc,
+			    GtkSourceSearchSettings *settings)
+{
+	GtkSourceSearchSettings *copy;
+	GtkSourceSearchContext *search_context;
+
+	copy = gtk_source_search_settings_new ();
+
+	gtk_source_search_settings_set_case_sensitive (copy,
+						       gtk_source_search_settings_get_case_sensitive (settings));
+	gtk_source_search_settings_set_at_word_boundaries (copy,
+							   gtk_source_search_settings_get_at_word_boundaries (settings));
+	gtk_source_search_settings_set_regex_enabled (copy,
+						      gtk_source_search_settings_get_regex_enabled (settings));
+	gtk_source_search_settings_set_wrap_around (copy,
+						    gtk_source_search_settings_get_wrap_around (settings));
+	gtk_source_search_settings_set_search_text (copy,
+						    gtk_source_search_settings_get_search_text (settings));
+
+	search_context = gtk_source_search_context_new (GTK_SOURCE_BUFFER (doc), copy);
+	gtk_source_search_context_set_highlight (search_context, FALSE);
+
+	g_object_unref (copy);
+
+	return search_context;
+}
+
+static void
+replace_all_data_free (ReplaceAllData *data)
+{
+	if (data->window != NULL)
+	{
+		g_object_remove_weak_pointer (G_OBJECT (data->window),
+					      (gpointer *) &data->window);
+	}
+
+	if (data->dialog != NULL)
+	{
+		g_object_remove_weak_pointer (G_OBJECT (data->dialog),
+					      (gpointer *) &data->dialog);
+	}
+
+	gtk_text_buffer_delete_mark (GTK_TEXT_BUFFER (data->doc), data->position);
+
+	g_object_unref (data->tab);
+	g_object_unref (data->doc);
+	g_object_unref (data->search_context);
+	g_object_unref (data->cancellable);
+	g_timer_destroy (data->timer);
+	g_free (data->replace_text);
+
+	g_slice_free (ReplaceAllData, data);
+}
+
+static void
+replace_all_cancelled (GtkWidget      *info_bar,
+		       gint            response_id,
+		       ReplaceAllData *data)
+{
+	g_cancellable_cancel (data->cancellable);
+}
+
+static void
+replace_all_update_progress (ReplaceAllData *data)
+{
+	GtkTextIter iter;
+	gint total;
+
+	if (data->info_bar == NULL)
+	{
+		gchar *name;
+		gchar *name_markup;
+		gchar *msg;
+
+		name = gedit_document_get_short_name_for_display (data->doc);
+		name_markup = g_markup_printf_escaped ("<b>%s</b>", name);
+
+		/* Translators: %s is a file name (e.g. test.txt) */
+		msg = g_strdup_printf (_("Replacing all occurrences in %s"),
+				       name_markup);
+
+		data->info_bar = gedit_progress_info_bar_new (GTK_STOCK_FIND_AND_REPLACE,
+							      msg,
+							      TRUE);
+
+		g_signal_connect (data->info_bar,
+				  "response",
+				  G_CALLBACK (replace_all_cancelled),
+				  data);
+
+		gedit_tab_set_info_bar (data->tab, data->info_bar);
+
+		g_free (msg);
+		g_free (name_markup);
+		g_free (name);
+	}
+
+	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (data->doc),
+					  &iter,
+					  data->position);
+
+	total = gtk_text_buffer_get_char_count (GTK_TEXT_BUFFER (data->doc));
+
+	gedit_progress_info_bar_set_fraction (GEDIT_PROGRESS_INFO_BAR (data->info_bar),
+					      total > 0 ? (gdouble) gtk_text_iter_get_offset (&iter) / total : 1.0);
+}
+
+static void
+replace_all_finished (ReplaceAllData *data,
+		      GError         *error)
+{
+	gedit_debug_message (DEBUG_COMMANDS, "Replaced %d occurrences", data->count);
+
+	gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (data->doc));
+
+	_gedit_tab_set_generic_not_editable (data->tab, FALSE);
+
+	if (data->info_bar != NULL)
+	{
+		gedit_tab_set_info_bar (data->tab, NULL);
+	}
+
+	g_object_set_data (G_OBJECT (data->doc), GEDIT_REPLACE_ALL_DATA_KEY, NULL);
+
+	if (data->window != NULL)
+	{
+		if (data->count > 0)
+		{
+			text_found (data->window, data->count);
+		}
+		else if (error == NULL && data->dialog != NULL)
+		{
+			text_not_found (data->window, data->dialog);
+		}
+	}
+
+	if (error != NULL)
+	{
+		if (data->dialog != NULL)
+		{
+			gedit_replace_dialog_set_replace_error (data->dialog, error->message);
+		}
+
+		g_error_free (error);
+	}
+
+	replace_all_data_free (data);
+}
+
+/* Returns TRUE when there is nothing left to replace */
+static gboolean
+replace_all_chunk (ReplaceAllData  *data,
+		   GError         **error)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (data->doc);
+
+	g_timer_start (data->timer);
+
+	do
+	{
+		GtkTextIter iter;
+		GtkTextIter match_start;
+		GtkTextIter match_end;
+		gboolean empty_match;
+
+		gtk_text_buffer_get_iter_at_mark (buffer, &iter, data->position);
+
+		if (!gtk_source_search_context_forward (data->search_context,
+							&iter,
+							&match_start,
+							&match_end))
+		{
+			return TRUE;
+		}
+
+		/* The search wraps around, stop when we are back to the start */
+		if (gtk_text_iter_compare (&match_start, &iter) < 0)
+		{
+			return TRUE;
+		}
+
+		empty_match = gtk_text_iter_equal (&match_start, &match_end);
+
+		gtk_text_buffer_move_mark (buffer, data->position, &match_end);
+
+		if (!gtk_source_search_context_replace (data->search_context,
+							&match_start,
+							&match_end,
+							data->replace_text,
+							-1,
+							error))
+		{
+			return TRUE;
+		}
+
+		data->count++;
+
+		/* Do not find the same empty match (e.g. "^") over and over */
+		if (empty_match)
+		{
+			gtk_text_buffer_get_iter_at_mark (buffer, &iter, data->position);
+
+			if (!gtk_text_iter_forward_char (&iter))
+			{
+				return TRUE;
+			}
+
+			gtk_text_buffer_move_mark (buffer, data->position, &iter);
+		}
+	}
+	while (g_timer_elapsed (data->timer, NULL) < REPLACE_ALL_TIME_SLICE);
+
+	return FALSE;
+}
+
+static gboolean
+replace_all_idle (ReplaceAllData *data)
+{
+	GError *error = NULL;
+
+	/* Stop as well if the tab is being closed */
+	if (g_cancellable_is_cancelled (data->cancellable) ||
+	    gedit_tab_get_state (data->tab) == GEDIT_TAB_STATE_CLOSING ||
+	    gtk_widget_get_parent (GTK_WIDGET (data->tab)) == NULL ||
+	    replace_all_chunk (data, &error))
+	{
+		replace_all_finished (data, error);
+
+		return G_SOURCE_REMOVE;
+	}
+
+	replace_all_update_progress (data);
+
+	return G_SOURCE_CONTINUE;
 }
 
 static void
 do_replace_all (GeditReplaceDialog *dialog,
 		GeditWindow        *window)
 {
+	GeditTab *tab;
 	GeditDocument *doc;
 	GtkSourceSearchContext *search_context;
 	const gchar *replace_entry_text;
-	gchar *unescaped_replace_text;
-	gint count;
+	ReplaceAllData *data;
+	GtkTextIter start;
 	GError *error = NULL;
 
-	doc = gedit_window_get_active_document (window);
+	tab = gedit_window_get_active_tab (window);
 
-	if (doc == NULL)
+	if (tab == NULL)
+	{
+		return;
+	}
+
+	doc = gedit_tab_get_document (tab);
+
+	/* Already replacing in this document, or busy */
+	if (g_object_get_data (G_OBJECT (doc), GEDIT_REPLACE_ALL_DATA_KEY) != NULL ||
+	    gedit_tab_get_state (tab) != GEDIT_TAB_STATE_NORMAL)
 	{
 		return;
 	}
@@ -475,29 +847,45 @@ do_replace_all (GeditReplaceDialog *dialog,
 	replace_entry_text = gedit_replace_dialog_get_replace_text (dialog);
 	g_return_if_fail (replace_entry_text != NULL);
 
-	unescaped_replace_text = gtk_source_utils_unescape_search_text (replace_entry_text);
+	data = g_slice_new0 (ReplaceAllData);
+	data->window = window;
+	data->dialog = dialog;
+	data->tab = g_object_ref (tab);
+	data->doc = g_object_ref (doc);
+	data->search_context = create_replace_all_context (doc,
+							   gtk_source_search_context_get_settings (search_context));
+	data->replace_text = gtk_source_utils_unescape_search_text (replace_entry_text);
+	data->timer = g_timer_new ();
+	data->cancellable = g_cancellable_new ();
+
+	g_object_add_weak_pointer (G_OBJECT (window), (gpointer *) &data->window);
+	g_object_add_weak_pointer (G_OBJECT (dialog), (gpointer *) &data->dialog);
+
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (doc), &start);
+	data->position = gtk_text_buffer_create_mark (GTK_TEXT_BUFFER (doc),
+						      NULL,
+						      &start,
+						      FALSE);
 
-	count = gtk_source_search_context_replace_all (search_context,
-						       unescaped_replace_text,
-						       -1,
-						       &error);
+	g_object_set_data (G_OBJECT (doc), GEDIT_REPLACE_ALL_DATA_KEY, data);
 
-	g_free (unescaped_replace_text);
+	/* Keep the user from editing, undoing or saving the document half
+	 * replaced while the user action is open. This also postpones the
+	 * auto save. */
+	_gedit_tab_set_generic_not_editable (tab, TRUE);
 
-	if (count > 0)
-	{
-		text_found (window, count);
-	}
-	else if (error == NULL)
-	{
-		text_not_found (window, dialog);
-	}
+	gtk_text_buffer_begin_user_action (GTK_TEXT_BUFFER (doc));
 
-	if (error != NULL)
+	/* Small documents are done right away, without any progress bar */
+	if (replace_all_chunk (data, &error))
 	{
-		gedit_replace_dialog_set_replace_error (dialog, error->message);
-		g_error_free (error);
+		replace_all_finished (data, error);
+		return;
 	}
+
+	replace_all_update_progress (data);
+
+	g_idle_add ((GSourceFunc) replace_all_idle, data);
 }
 
 static void
@@ -0,0 +1,245 @@
+/*
+ * gedit-converter-pool.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+/* Opening a converter loads and sets up the iconv tables of the charsets,
+ * which costs more than converting a small file. When many files in the
+ * same encoding are opened or saved, such as on a session restore, the
+ * converters are reused instead.
+ *
+ * Idle converters are kept per pair of charsets, up to MAX_IDLE of each.
+ * The number of converters opened and reused is logged in the
+ * GEDIT_DEBUG_UTILS debug section.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gedit-converter-pool.h"
+#include "gedit-debug.h"
+
+#define MAX_IDLE 4
+
+static GMutex pool_lock;
+
+/* Interned "to\nfrom" -> GSList of idle converters */
+static GHashTable *idle_converters = NULL;
+static GHashTable *idle_iconvs = NULL;
+
+static guint n_opened = 0;
+static guint n_reused = 0;
+
+static GQuark pool_key_quark = 0;
+
+static const gchar *
+get_pool_key (const gchar *to_charset,
+	      const gchar *from_charset)
+{
+	const gchar *key;
+	gchar *str;
+
+	str = g_strconcat (to_charset, "\n", from_charset, NULL);
+	key = g_intern_string (str);
+	g_free (str);
+
+	return key;
+}
+
+/* Must be called with the lock held */
+static gpointer
+take_idle (GHashTable  *table,
+	   const gchar *key)
+{
+	GSList *idle;
+	gpointer ret;
+
+	idle = g_hash_table_lookup (table, key);
+
+	if (idle == NULL)
+		return NULL;
+
+	ret = idle->data;
+	g_hash_table_insert (table, (gpointer) key, g_slist_delete_link (idle, idle));
+
+	n_reused++;
+
+	return ret;
+}
+
+/* Must be called with the lock held. Returns whether it was kept. */
+static gboolean
+put_idle (GHashTable  *table,
+	  const gchar *key,
+	  gpointer     converter)
+{
+	GSList *idle;
+
+	idle = g_hash_table_lookup (table, key);
+
+	if (g_slist_length (idle) >= MAX_IDLE)
+		return FALSE;
+
+	g_hash_table_insert (table, (gpointer) key, g_slist_prepend (idle, converter));
+
+	return TRUE;
+}
+
+static void
+init_pool (void)
+{
+	if (idle_converters == NULL)
+	{
+		idle_converters = g_hash_table_new (g_direct_hash, g_direct_equal);
+		idle_iconvs = g_hash_table_new (g_direct_hash, g_direct_equal);
+		pool_key_quark = g_quark_from_static_string ("gedit-converter-pool-key");
+	}
+}
+
+GCharsetConverter *
+_gedit_converter_pool_get_converter (const gchar  *to_charset,
+				     const gchar  *from_charset,
+				     GError      **error)
+{
+	GCharsetConverter *converter;
+	const gchar *key;
+
+	g_return_val_if_fail (to_charset != NULL, NULL);
+	g_return_val_if_fail (from_charset != NULL, NULL);
+
+	key = get_pool_key (to_charset, from_charset);
+
+	g_mutex_lock (&pool_lock);
+	init_pool ();
+	converter = take_idle (idle_converters, key);
+	g_mutex_unlock (&pool_lock);
+
+	if (converter != NULL)
+	{
+		gedit_debug_message (DEBUG_UTILS, "Reused converter from %s to %s (%u reused, %u opened)",
+				     from_charset, to_charset, n_reused, n_opened);
+
+		return converter;
+	}
+
+	converter = g_charset_converter_new (to_charset, from_charset, error);
+
+	if (converter == NULL)
+		return NULL;
+
+	g_object_set_qdata (G_OBJECT (converter), pool_key_quark, (gpointer) key);
+
+	g_mutex_lock (&pool_lock);
+	n_opened++;
+	g_mutex_unlock (&pool_lock);
+
+	gedit_debug_message (DEBUG_UTILS, "Opened converter from %s to %s (%u reused, %u opened)",
+			     from_charset, to_charset, n_reused, n_opened);
+
+	return converter;
+}
+
+void
+_gedit_converter_pool_release_converter (GCharsetConverter *converter)
+{
+	const gchar *key;
+	gboolean kept;
+
+	g_return_if_fail (G_IS_CHARSET_CONVERTER (converter));
+
+	key = g_object_get_qdata (G_OBJECT (converter), pool_key_quark);
+	g_return_if_fail (key != NULL);
+
+	g_converter_reset (G_CONVERTER (converter));
+
+	g_mutex_lock (&pool_lock);
+	kept = put_idle (idle_converters, key, converter);
+	g_mutex_unlock (&pool_lock);
+
+	if (!kept)
+		g_object_unref (converter);
+}
+
+GIConv
+_gedit_converter_pool_get_iconv (const gchar *to_charset,
+				 const gchar *from_charset)
+{
+	GIConv iconv;
+	const gchar *key;
+
+	g_return_val_if_fail (to_charset != NULL, (GIConv) -1);
+	g_return_val_if_fail (from_charset != NULL, (GIConv) -1);
+
+	key = get_pool_key (to_charset, from_charset);
+
+	g_mutex_lock (&pool_lock);
+	init_pool ();
+	iconv = take_idle (idle_iconvs, key);
+	g_mutex_unlock (&pool_lock);
+
+	if (iconv != NULL)
+	{
+		gedit_debug_message (DEBUG_UTILS, "Reused iconv from %s to %s (%u reused, %u opened)",
+				     from_charset, to_charset, n_reused, n_opened);
+
+		return iconv;
+	}
+
+	iconv = g_iconv_open (to_charset, from_charset);
+
+	if (iconv == (GIConv) -1)
+		return iconv;
+
+	g_mutex_lock (&pool_lock);
+	n_opened++;
+	g_mutex_unlock (&pool_lock);
+
+	gedit_debug_message (DEBUG_UTILS, "Opened iconv from %s to %s (%u reused, %u opened)",
+			     from_charset, to_charset, n_reused, n_opened);
+
+	return iconv;
+}
+
+void
+_gedit_converter_pool_release_iconv (GIConv       iconv,
+				     const gchar *to_charset,
+				     const gchar *from_charset)
+{
+	const gchar *key;
+	gboolean kept;
+
+	g_return_if_fail (iconv != (GIConv) -1);
+
+	/* Back to the initial shift state */
+	g_iconv (iconv, NULL, NULL, NULL, NULL);
+
+	key = get_pool_key (to_charset, from_charset);
+
+	g_mutex_lock (&pool_lock);
+	init_pool ();
+	kept = put_idle (idle_iconvs, key, iconv);
+	g_mutex_unlock (&pool_lock);
+
+	if (!kept)
+		g_iconv_close (iconv);
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,52 @@
+/*
+ * gedit-converter-pool.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GEDIT_CONVERTER_POOL_H__
+#define __GEDIT_CONVERTER_POOL_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* The converters are given back with the release functions once done
+ * with, instead of being unreffed or closed. They can be used from any
+ * thread.
+ */
+GCharsetConverter	*_gedit_converter_pool_get_converter		(const gchar       *to_charset,
+									 const gchar       *from_charset,
+									 GError           **error);
+
+void			 _gedit_converter_pool_release_converter	(GCharsetConverter *converter);
+
+/* Returns (GIConv) -1 and sets errno on failure, like g_iconv_open() */
+GIConv			 _gedit_converter_pool_get_iconv		(const gchar       *to_charset,
+									 const gchar       *from_charset);
+
+void			 _gedit_converter_pool_release_iconv		(GIConv             iconv,
+									 const gchar       *to_charset,
+									 const gchar       *from_charset);
+
+G_END_DECLS
+
+#endif /* __GEDIT_CONVERTER_POOL_H__ */
+
+/* ex:set ts=8 noet: */
@@ -45,6 +45,7 @@
 #include "gedit-marshal.h"
 #include "gedit-enum-types.h"
 #include "gedit-settings.h"
+#include "gedit-trace.h"
 
 #ifndef ENABLE_GVFS_METADATA
 #include "gedit-metadata-manager.h"
@@ -57,6 +58,9 @@ typedef struct
 
 	gssize               read;
 	gboolean             tried_mount;
+
+	/* Start of the phase in progress, for the trace */
+	gint64               begin;
 } AsyncData;
 
 /* Signals */
@@ -117,6 +121,8 @@ struct _GeditDocumentLoaderPrivate
 
 	GError                   *error;
 	gboolean                  guess_content_type_from_content;
+
+	gint64                    load_begin;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeditDocumentLoader, gedit_document_loader, G_TYPE_OBJECT)
@@ -347,6 +353,7 @@ async_data_new (GeditDocumentLoader *loader)
 	async->loader = loader;
 	async->cancellable = g_object_ref (loader->priv->cancellable);
 	async->tried_mount = FALSE;
+	async->begin = 0;
 
 	return async;
 }
@@ -408,6 +415,9 @@ static void
 loader_load_completed_or_failed (GeditDocumentLoader *loader,
 				 AsyncData           *async)
 {
+	gedit_trace_end (GEDIT_TRACE_LOADER, "load", loader->priv->document,
+			 loader->priv->load_begin, loader->priv->bytes_read);
+
 	gedit_document_loader_loading (loader,
 				       TRUE,
 				       loader->priv->error);
@@ -442,6 +452,9 @@ close_input_stream_ready_cb (GInputStream *stream,
 
 	gedit_debug_message (DEBUG_LOADER, "Finished closing input stream");
 
+	gedit_trace_end (GEDIT_TRACE_LOADER, "close", async->loader->priv->document,
+			 async->begin, -1);
+
 	if (!g_input_stream_close_finish (stream, res, &error))
 	{
 		gedit_debug_message (DEBUG_LOADER, "Closing input stream error: %s", error->message);
@@ -478,6 +491,7 @@ write_complete (AsyncData *async)
 {
 	if (async->loader->priv->stream)
 	{
+		async->begin = gedit_trace_begin ();
 		g_input_stream_close_async (G_INPUT_STREAM (async->loader->priv->stream),
 					    G_PRIORITY_HIGH,
 					    async->cancellable,
@@ -495,16 +509,20 @@ write_file_chunk (AsyncData *async)
 	GeditDocumentLoader *loader;
 	gssize bytes_written;
 	GError *error = NULL;
+	gint64 begin;
 
 	loader = async->loader;
 
 	/* we use sync methods on doc stream since it is in memory. Using async
 	   would be racy and we can endup with invalidated iters */
+	begin = gedit_trace_begin ();
 	bytes_written = g_output_stream_write (G_OUTPUT_STREAM (loader->priv->output),
 					       loader->priv->buffer,
 					       async->read,
 					       async->cancellable,
 					       &error);
+	gedit_trace_end (GEDIT_TRACE_LOADER, "insert", loader->priv->document,
+			 begin, async->read);
 
 	gedit_debug_message (DEBUG_LOADER, "Written: %" G_GSSIZE_FORMAT, bytes_written);
 	if (bytes_written == -1)
@@ -545,6 +563,9 @@ async_read_cb (GInputStream *stream,
 
 	async->read = g_input_stream_read_finish (stream, res, &error);
 
+	gedit_trace_end (GEDIT_TRACE_LOADER, "read", loader->priv->document,
+			 async->begin, async->read);
+
 	/* error occurred */
 	if (async->read == -1)
 	{
@@ -591,8 +612,13 @@ async_read_cb (GInputStream *stream,
 	/* end of the file, we are done! */
 	if (async->read == 0)
 	{
+		gint64 begin;
+
 		/* flush the stream to ensure proper line ending detection */
+		begin = gedit_trace_begin ();
 		g_output_stream_flush (loader->priv->output, NULL, NULL);
+		gedit_trace_end (GEDIT_TRACE_LOADER, "flush", loader->priv->document,
+				 begin, -1);
 
 		loader->priv->auto_detected_encoding =
 			gedit_document_output_stream_get_guessed (GEDIT_DOCUMENT_OUTPUT_STREAM (loader->priv->output));
@@ -617,6 +643,7 @@ read_file_chunk (AsyncData *async)
 
 	loader = async->loader;
 
+	async->begin = gedit_trace_begin ();
 	g_input_stream_read_async (G_INPUT_STREAM (loader->priv->stream),
 				   loader->priv->buffer,
 				   READ_CHUNK_SIZE,
@@ -772,6 +799,9 @@ query_info_cb (GFile        *source,
 
 	priv = async->loader->priv;
 
+	gedit_trace_end (GEDIT_TRACE_LOADER, "query-info", priv->document,
+			 async->begin, -1);
+
 	/* finish the info query */
 	info = g_file_query_info_finish (priv->location,
 	                                 res,
@@ -806,6 +836,9 @@ mount_ready_callback (GFile        *file,
 		return;
 	}
 
+	gedit_trace_end (GEDIT_TRACE_LOADER, "mount", async->loader->priv->document,
+			 async->begin, -1);
+
 	mounted = g_file_mount_enclosing_volume_finish (file, res, &error);
 
 	if (!mounted)
@@ -831,6 +864,7 @@ recover_not_mounted (AsyncData *async)
 	mount_operation = _gedit_document_create_mount_operation (doc);
 
 	async->tried_mount = TRUE;
+	async->begin = gedit_trace_begin ();
 	g_file_mount_enclosing_volume (async->loader->priv->location,
 				       G_MOUNT_MOUNT_NONE,
 				       mount_operation,
@@ -860,6 +894,9 @@ async_read_ready_callback (GObject      *source,
 
 	loader = async->loader;
 
+	gedit_trace_end (GEDIT_TRACE_LOADER, "open", loader->priv->document,
+			 async->begin, -1);
+
 	loader->priv->stream = G_INPUT_STREAM (g_file_read_finish (loader->priv->location,
 								     res, &error));
 
@@ -888,6 +925,7 @@ async_read_ready_callback (GObject      *source,
 	 * Using the file instead of the stream is slightly racy, but for
 	 * loading this is not too bad...
 	 */
+	async->begin = gedit_trace_begin ();
 	g_file_query_info_async (loader->priv->location,
 				 LOADER_QUERY_ATTRIBUTES,
                                  G_FILE_QUERY_INFO_NONE,
@@ -900,6 +938,7 @@ async_read_ready_callback (GObject      *source,
 static void
 open_async_read (AsyncData *async)
 {
+	async->begin = gedit_trace_begin ();
 	g_file_read_async (async->loader->priv->location,
 	                   G_PRIORITY_HIGH,
 	                   async->cancellable,
@@ -955,6 +994,7 @@ gedit_document_loader_load (GeditDocumentLoader *loader)
 				       NULL);
 
 	loader->priv->cancellable = g_cancellable_new ();
+	loader->priv->load_begin = gedit_trace_begin ();
 	async = async_data_new (loader);
 
 	if (loader->priv->stream)
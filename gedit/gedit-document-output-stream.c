@@ -28,7 +28,9 @@
 #include <gio/gio.h>
 #include <errno.h>
 #include "gedit-document-output-stream.h"
+#include "gedit-converter-pool.h"
 #include "gedit-debug.h"
+#include "gedit-trace.h"
 
 /* NOTE: never use async methods on this stream, the stream is just
  * a wrapper around GtkTextBuffer api so that we can use GIO Stream
@@ -56,16 +58,24 @@ struct _GeditDocumentOutputStreamPrivate
 	gchar *iconv_buffer;
 	gsize iconv_buflen;
 
-	/* Encoding detection */
+	/* Encoding detection, both come from the converter pool */
 	GIConv iconv;
+	const gchar *iconv_charset;
 	GCharsetConverter *charset_conv;
 
 	GSList *encodings;
 	GSList *current_encoding;
 
+	/* The invalid chars are tagged once everything is inserted. Each
+	 * range is a pair of offsets, the last one is still open while
+	 * error_offset is not -1. */
 	gint error_offset;
+	GArray *error_ranges;
 	guint n_fallback_errors;
 
+	/* Where runs of invalid chars are escaped before being inserted */
+	GString *fallback;
+
 	guint is_utf8 : 1;
 	guint use_first : 1;
 
@@ -151,7 +161,20 @@ gedit_document_output_stream_dispose (GObject *object)
 {
 	GeditDocumentOutputStream *stream = GEDIT_DOCUMENT_OUTPUT_STREAM (object);
 
-	g_clear_object (&stream->priv->charset_conv);
+	if (stream->priv->charset_conv != NULL)
+	{
+		_gedit_converter_pool_release_converter (stream->priv->charset_conv);
+		stream->priv->charset_conv = NULL;
+	}
+
+	/* The stream was not closed */
+	if (stream->priv->iconv != NULL)
+	{
+		_gedit_converter_pool_release_iconv (stream->priv->iconv,
+						     "UTF-8",
+						     stream->priv->iconv_charset);
+		stream->priv->iconv = NULL;
+	}
 
 	G_OBJECT_CLASS (gedit_document_output_stream_parent_class)->dispose (object);
 }
@@ -164,6 +187,8 @@ gedit_document_output_stream_finalize (GObject *object)
 	g_free (stream->priv->buffer);
 	g_free (stream->priv->iconv_buffer);
 	g_slist_free (stream->priv->encodings);
+	g_array_unref (stream->priv->error_ranges);
+	g_string_free (stream->priv->fallback, TRUE);
 
 	G_OBJECT_CLASS (gedit_document_output_stream_parent_class)->finalize (object);
 }
@@ -248,6 +273,8 @@ gedit_document_output_stream_init (GeditDocumentOutputStream *stream)
 	stream->priv->current_encoding = NULL;
 
 	stream->priv->error_offset = -1;
+	stream->priv->error_ranges = g_array_new (FALSE, FALSE, sizeof (gint));
+	stream->priv->fallback = g_string_new (NULL);
 
 	stream->priv->is_initialized = FALSE;
 	stream->priv->is_closed = FALSE;
@@ -376,7 +403,7 @@ guess_encoding (GeditDocumentOutputStream *stream,
 
 		if (conv != NULL)
 		{
-			g_object_unref (conv);
+			_gedit_converter_pool_release_converter (conv);
 			conv = NULL;
 		}
 
@@ -415,9 +442,18 @@ guess_encoding (GeditDocumentOutputStream *stream,
 			continue;
 		}
 
-		conv = g_charset_converter_new ("UTF-8",
-						gedit_encoding_get_charset (enc),
-						NULL);
+		conv = _gedit_converter_pool_get_converter ("UTF-8",
+							    gedit_encoding_get_charset (enc),
+							    NULL);
+
+		/* Not supported by iconv */
+		if (conv == NULL)
+		{
+			if (stream->priv->use_first)
+				break;
+
+			continue;
+		}
 
 		/* If we tried all encodings we use the first one */
 		if (stream->priv->use_first)
@@ -536,45 +572,122 @@ gedit_document_output_stream_get_num_fallbacks (GeditDocumentOutputStream *strea
 	return stream->priv->n_fallback_errors;
 }
 
+/* Ends the current range of invalid chars, if any */
 static void
-apply_error_tag (GeditDocumentOutputStream *stream)
+end_error_range (GeditDocumentOutputStream *stream)
 {
-	GtkTextIter start;
+	gint end_offset;
 
 	if (stream->priv->error_offset == -1)
 	{
 		return;
 	}
 
-	gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (stream->priv->doc),
-	                                    &start, stream->priv->error_offset);
+	end_offset = gtk_text_iter_get_offset (&stream->priv->pos);
 
-	_gedit_document_apply_error_style (stream->priv->doc,
-	                                   &start, &stream->priv->pos);
+	g_array_append_val (stream->priv->error_ranges, stream->priv->error_offset);
+	g_array_append_val (stream->priv->error_ranges, end_offset);
 
 	stream->priv->error_offset = -1;
 }
 
+static void
+apply_error_tags (GeditDocumentOutputStream *stream)
+{
+	GtkTextBuffer *buffer;
+	guint i;
+
+	end_error_range (stream);
+
+	buffer = GTK_TEXT_BUFFER (stream->priv->doc);
+
+	for (i = 0; i + 1 < stream->priv->error_ranges->len; i += 2)
+	{
+		GtkTextIter start;
+		GtkTextIter end;
+
+		gtk_text_buffer_get_iter_at_offset (buffer, &start,
+		                                    g_array_index (stream->priv->error_ranges, gint, i));
+		gtk_text_buffer_get_iter_at_offset (buffer, &end,
+		                                    g_array_index (stream->priv->error_ranges, gint, i + 1));
+
+		_gedit_document_apply_error_style (stream->priv->doc, &start, &end);
+	}
+
+	g_array_set_size (stream->priv->error_ranges, 0);
+}
+
+/* Substitutes each of the invalid bytes by its hex value, and inserts
+ * the whole run at once.
+ */
 static void
 insert_fallback (GeditDocumentOutputStream *stream,
-                 const gchar               *buffer)
+                 const gchar               *buffer,
+                 gsize                      len)
 {
-	guint8 out[4];
-	guint8 v;
 	const gchar hex[] = "0123456789ABCDEF";
+	GString *out = stream->priv->fallback;
+	gsize i;
+
+	if (len == 0)
+	{
+		return;
+	}
+
+	/* we need the start of the chunk of invalid chars */
+	if (stream->priv->error_offset == -1)
+	{
+		stream->priv->error_offset = gtk_text_iter_get_offset (&stream->priv->pos);
+	}
+
+	g_string_truncate (out, 0);
+
+	for (i = 0; i < len; ++i)
+	{
+		guint8 v = ((const guint8 *)buffer)[i];
 
-	/* if we are here is because we are pointing to an invalid char
-	 * so we substitute it by an hex value */
-	v = *(guint8 *)buffer;
-	out[0] = '\\';
-	out[1] = hex[(v & 0xf0) >> 4];
-	out[2] = hex[(v & 0x0f) >> 0];
-	out[3] = '\0';
+		g_string_append_c (out, '\\');
+		g_string_append_c (out, hex[(v & 0xf0) >> 4]);
+		g_string_append_c (out, hex[(v & 0x0f) >> 0]);
+	}
 
 	gtk_text_buffer_insert (GTK_TEXT_BUFFER (stream->priv->doc),
-	                        &stream->priv->pos, (const gchar *)out, 3);
+	                        &stream->priv->pos, out->str, out->len);
 
-	++stream->priv->n_fallback_errors;
+	stream->priv->n_fallback_errors += len;
+}
+
+/* Returns the number of bytes at the start of buffer that are not valid
+ * UTF-8, stopping before an incomplete char at the end of the buffer.
+ */
+static gsize
+count_invalid (const gchar *buffer,
+               gsize        len)
+{
+	gsize n = 0;
+
+	while (n < len)
+	{
+		const gchar *end;
+		gsize remaining = len - n;
+
+		if (remaining < MAX_UNICHAR_LEN &&
+		    g_utf8_get_char_validated (buffer + n, remaining) == (gunichar)-2)
+		{
+			break;
+		}
+
+		g_utf8_validate (buffer + n, MIN (remaining, MAX_UNICHAR_LEN), &end);
+
+		if (end != buffer + n)
+		{
+			break;
+		}
+
+		++n;
+	}
+
+	return n;
 }
 
 static void
@@ -595,6 +708,7 @@ validate_and_insert (GeditDocumentOutputStream *stream,
 		const gchar *end;
 		gboolean valid;
 		gsize nvalid;
+		gsize ninvalid;
 
 		/* validate */
 		valid = g_utf8_validate (buffer, len, &end);
@@ -624,10 +738,10 @@ validate_and_insert (GeditDocumentOutputStream *stream,
 			}
 		}
 
-		/* if we've got any valid char we must tag the invalid chars */
+		/* if we've got any valid char the invalid chars end here */
 		if (nvalid > 0)
 		{
-			apply_error_tag (stream);
+			end_error_range (stream);
 		}
 
 		gtk_text_buffer_insert (text_buffer, iter, buffer, nvalid);
@@ -650,15 +764,11 @@ validate_and_insert (GeditDocumentOutputStream *stream,
 			break;
 		}
 
-		/* we need the start of the chunk of invalid chars */
-		if (stream->priv->error_offset == -1)
-		{
-			stream->priv->error_offset = gtk_text_iter_get_offset (&stream->priv->pos);
-		}
+		ninvalid = count_invalid (buffer, len);
 
-		insert_fallback (stream, buffer);
-		++buffer;
-		--len;
+		insert_fallback (stream, buffer, ninvalid);
+		buffer += ninvalid;
+		len -= ninvalid;
 	}
 }
 
@@ -819,7 +929,12 @@ gedit_document_output_stream_write (GOutputStream            *stream,
 
 	if (!ostream->priv->is_initialized)
 	{
+		gint64 begin;
+
+		begin = gedit_trace_begin ();
 		ostream->priv->charset_conv = guess_encoding (ostream, buffer, count);
+		gedit_trace_end (GEDIT_TRACE_LOADER, "detect-encoding",
+				 ostream->priv->doc, begin, count);
 
 		/* If we still have the previous case is that we didn't guess
 		   anything */
@@ -843,7 +958,7 @@ gedit_document_output_stream_write (GOutputStream            *stream,
 				      "from-charset", &from_charset,
 				      NULL);
 
-			ostream->priv->iconv = g_iconv_open ("UTF-8", from_charset);
+			ostream->priv->iconv = _gedit_converter_pool_get_iconv ("UTF-8", from_charset);
 
 			if (ostream->priv->iconv == (GIConv)-1)
 			{
@@ -860,12 +975,16 @@ gedit_document_output_stream_write (GOutputStream            *stream,
 						     from_charset);
 				}
 
+				ostream->priv->iconv = NULL;
+
 				g_free (from_charset);
-				g_clear_object (&ostream->priv->charset_conv);
+				_gedit_converter_pool_release_converter (ostream->priv->charset_conv);
+				ostream->priv->charset_conv = NULL;
 
 				return -1;
 			}
 
+			ostream->priv->iconv_charset = g_intern_string (from_charset);
 			g_free (from_charset);
 		}
 
@@ -1016,20 +1135,8 @@ gedit_document_output_stream_flush (GOutputStream  *stream,
 	{
 		/* If we reached here is because the last insertion was a half
 		   correct char, which has to be inserted as fallback */
-		gchar *text;
-
-		if (ostream->priv->error_offset == -1)
-		{
-			ostream->priv->error_offset = gtk_text_iter_get_offset (&ostream->priv->pos);
-		}
-
-		text = ostream->priv->buffer;
-		while (ostream->priv->buflen != 0)
-		{
-			insert_fallback (ostream, text);
-			++text;
-			--ostream->priv->buflen;
-		}
+		insert_fallback (ostream, ostream->priv->buffer, ostream->priv->buflen);
+		ostream->priv->buflen = 0;
 
 		g_free (ostream->priv->buffer);
 		ostream->priv->buffer = NULL;
@@ -1037,7 +1144,7 @@ gedit_document_output_stream_flush (GOutputStream  *stream,
 	else if (ostream->priv->buflen == 1 && *ostream->priv->buffer == '\r')
 	{
 		/* The previous chars can be invalid */
-		apply_error_tag (ostream);
+		end_error_range (ostream);
 
 		/* See special case above, flush this */
 		gtk_text_buffer_insert (GTK_TEXT_BUFFER (ostream->priv->doc),
@@ -1054,26 +1161,14 @@ gedit_document_output_stream_flush (GOutputStream  *stream,
 	{
 		/* If we reached here is because the last insertion was a half
 		   correct char, which has to be inserted as fallback */
-		gchar *text;
-
-		if (ostream->priv->error_offset == -1)
-		{
-			ostream->priv->error_offset = gtk_text_iter_get_offset (&ostream->priv->pos);
-		}
-
-		text = ostream->priv->iconv_buffer;
-		while (ostream->priv->iconv_buflen != 0)
-		{
-			insert_fallback (ostream, text);
-			++text;
-			--ostream->priv->iconv_buflen;
-		}
+		insert_fallback (ostream, ostream->priv->iconv_buffer, ostream->priv->iconv_buflen);
+		ostream->priv->iconv_buflen = 0;
 
 		g_free (ostream->priv->iconv_buffer);
 		ostream->priv->iconv_buffer = NULL;
 	}
 
-	apply_error_tag (ostream);
+	apply_error_tags (ostream);
 
 	return TRUE;
 }
@@ -1091,7 +1186,10 @@ gedit_document_output_stream_close (GOutputStream     *stream,
 
 		if (ostream->priv->iconv != NULL)
 		{
-			g_iconv_close (ostream->priv->iconv);
+			_gedit_converter_pool_release_iconv (ostream->priv->iconv,
+							     "UTF-8",
+							     ostream->priv->iconv_charset);
+			ostream->priv->iconv = NULL;
 		}
 
 		ostream->priv->is_closed = TRUE;
@@ -39,11 +39,14 @@
 
 #include "gedit-document-saver.h"
 #include "gedit-document-input-stream.h"
+#include "gedit-converter-pool.h"
 #include "gedit-debug.h"
 #include "gedit-marshal.h"
 #include "gedit-utils.h"
 #include "gedit-enum-types.h"
 #include "gedit-settings.h"
+#include "gedit-trace.h"
+#include "gedit-save-scheduler.h"
 
 #define WRITE_CHUNK_SIZE 8192
 
@@ -77,6 +80,9 @@ typedef struct
 	gssize		       written;
 	gssize		       read;
 	GError                *error;
+
+	/* Start of the phase in progress, for the trace */
+	gint64		       begin;
 } AsyncData;
 
 #define REMOTE_QUERY_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE "," \
@@ -111,6 +117,8 @@ struct _GeditDocumentSaverPrivate
 	GInputStream		 *input;
 
 	GError                   *error;
+
+	gint64			  save_begin;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeditDocumentSaver, gedit_document_saver, G_TYPE_OBJECT)
@@ -223,6 +231,7 @@ async_data_new (GeditDocumentSaver *saver)
 	async->read = 0;
 
 	async->error = NULL;
+	async->begin = 0;
 
 	return async;
 }
@@ -364,6 +373,9 @@ static void
 remote_save_completed_or_failed (GeditDocumentSaver *saver,
 				 AsyncData 	    *async)
 {
+	gedit_trace_end (GEDIT_TRACE_SAVER, "save", saver->priv->document,
+			 saver->priv->save_begin, saver->priv->bytes_written);
+
 	gedit_document_saver_saving (saver,
 				     TRUE,
 				     saver->priv->error);
@@ -479,6 +491,9 @@ remote_get_info_cb (GFile        *source,
 	saver = async->saver;
 
 	gedit_debug_message (DEBUG_SAVER, "Finished query info on file");
+	gedit_trace_end (GEDIT_TRACE_SAVER, "query-info", saver->priv->document,
+			 async->begin, -1);
+
 	info = g_file_query_info_finish (source, res, &error);
 
 	if (info != NULL)
@@ -514,6 +529,8 @@ close_async_ready_get_info_cb (GOutputStream *stream,
 	}
 
 	gedit_debug_message (DEBUG_SAVER, "Finished closing stream");
+	gedit_trace_end (GEDIT_TRACE_SAVER, "close", async->saver->priv->document,
+			 async->begin, -1);
 
 	if (!g_output_stream_close_finish (stream, res, &error))
 	{
@@ -530,6 +547,7 @@ close_async_ready_get_info_cb (GOutputStream *stream,
 	 * g_content_type_guess (since we have the file name and the data)
 	 */
 	gedit_debug_message (DEBUG_SAVER, "Query info on file");
+	async->begin = gedit_trace_begin ();
 	g_file_query_info_async (async->saver->priv->location,
 			         REMOTE_QUERY_ATTRIBUTES,
 			         G_FILE_QUERY_INFO_NONE,
@@ -556,6 +574,7 @@ write_complete (AsyncData *async)
 
 	/* now we close the output stream */
 	gedit_debug_message (DEBUG_SAVER, "Close output stream");
+	async->begin = gedit_trace_begin ();
 	g_output_stream_close_async (async->saver->priv->stream,
 				     G_PRIORITY_HIGH,
 				     async->cancellable,
@@ -587,6 +606,9 @@ async_write_cb (GOutputStream *stream,
 
 	bytes_written = g_output_stream_write_finish (stream, res, &error);
 
+	gedit_trace_end (GEDIT_TRACE_SAVER, "write", async->saver->priv->document,
+			 async->begin, bytes_written);
+
 	gedit_debug_message (DEBUG_SAVER, "Written: %" G_GSSIZE_FORMAT, bytes_written);
 
 	if (bytes_written == -1)
@@ -625,6 +647,7 @@ write_file_chunk (AsyncData *async)
 
 	saver = async->saver;
 
+	async->begin = gedit_trace_begin ();
 	g_output_stream_write_async (G_OUTPUT_STREAM (saver->priv->stream),
 				     async->buffer + async->written,
 				     async->read - async->written,
@@ -640,6 +663,7 @@ read_file_chunk (AsyncData *async)
 	GeditDocumentSaver *saver;
 	GeditDocumentInputStream *dstream;
 	GError *error = NULL;
+	gint64 begin;
 
 	gedit_debug (DEBUG_SAVER);
 
@@ -648,11 +672,14 @@ read_file_chunk (AsyncData *async)
 
 	/* we use sync methods on doc stream since it is in memory. Using async
 	   would be racy and we can endup with invalidated iters */
+	begin = gedit_trace_begin ();
 	async->read = g_input_stream_read (saver->priv->input,
 					   async->buffer,
 					   WRITE_CHUNK_SIZE,
 					   async->cancellable,
 					   &error);
+	gedit_trace_end (GEDIT_TRACE_SAVER, "read", saver->priv->document,
+			 begin, async->read);
 
 	if (error != NULL)
 	{
@@ -674,6 +701,13 @@ read_file_chunk (AsyncData *async)
 	write_file_chunk (async);
 }
 
+static void
+release_converter (GCharsetConverter *converter,
+		   GObject           *stream)
+{
+	_gedit_converter_pool_release_converter (converter);
+}
+
 static void
 async_replace_ready_callback (GFile        *source,
 			      GAsyncResult *res,
@@ -699,6 +733,9 @@ async_replace_ready_callback (GFile        *source,
 	saver = async->saver;
 	file_stream = g_file_replace_finish (source, res, &error);
 
+	gedit_trace_end (GEDIT_TRACE_SAVER, "open", saver->priv->document,
+			 async->begin, -1);
+
 	/* handle any error that might occur */
 	if (!file_stream)
 	{
@@ -737,14 +774,19 @@ async_replace_ready_callback (GFile        *source,
 
 	if (saver->priv->encoding != gedit_encoding_get_utf8 ())
 	{
-		converter = g_charset_converter_new (gedit_encoding_get_charset (saver->priv->encoding),
-						     "UTF-8",
-						     NULL);
+		converter = _gedit_converter_pool_get_converter (gedit_encoding_get_charset (saver->priv->encoding),
+								 "UTF-8",
+								 NULL);
 
 		saver->priv->stream = g_converter_output_stream_new (base_stream,
 		                                                     G_CONVERTER (converter));
 
-		g_object_unref (converter);
+		/* The converter goes back to the pool once the stream
+		 * is gone, which can be after the saver */
+		g_object_weak_ref (G_OBJECT (saver->priv->stream),
+				   (GWeakNotify) release_converter,
+				   converter);
+
 		g_object_unref (base_stream);
 	}
 	else
@@ -785,6 +827,7 @@ begin_write (AsyncData *async)
 	gedit_debug_message (DEBUG_SAVER, "Calling replace_async");
 	gedit_debug_message (DEBUG_SAVER, backup ? "Keep backup" : "Discard backup");
 
+	async->begin = gedit_trace_begin ();
 	g_file_replace_async (saver->priv->location,
 			      NULL,
 			      backup,
@@ -812,6 +855,9 @@ mount_ready_callback (GFile        *file,
 		return;
 	}
 
+	gedit_trace_end (GEDIT_TRACE_SAVER, "mount", async->saver->priv->document,
+			 async->begin, -1);
+
 	mounted = g_file_mount_enclosing_volume_finish (file, res, &error);
 
 	if (!mounted)
@@ -837,6 +883,7 @@ recover_not_mounted (AsyncData *async)
 	mount_operation = _gedit_document_create_mount_operation (doc);
 
 	async->tried_mount = TRUE;
+	async->begin = gedit_trace_begin ();
 	g_file_mount_enclosing_volume (async->saver->priv->location,
 				       G_MOUNT_MOUNT_NONE,
 				       mount_operation,
@@ -867,6 +914,10 @@ check_modification_callback (GFile        *source,
 
 	saver = async->saver;
 	info = g_file_query_info_finish (source, res, &error);
+
+	gedit_trace_end (GEDIT_TRACE_SAVER, "check-modified", saver->priv->document,
+			 async->begin, -1);
+
 	if (info == NULL)
 	{
 		if (error->code == G_IO_ERROR_NOT_MOUNTED && !async->tried_mount)
@@ -925,6 +976,7 @@ check_modified_async (AsyncData *async)
 {
 	gedit_debug_message (DEBUG_SAVER, "Check externally modified");
 
+	async->begin = gedit_trace_begin ();
 	g_file_query_info_async (async->saver->priv->location,
 				 G_FILE_ATTRIBUTE_TIME_MODIFIED,
 				 G_FILE_QUERY_INFO_NONE,
@@ -934,22 +986,24 @@ check_modified_async (AsyncData *async)
 				 async);
 }
 
-static gboolean
-save_remote_file_real (GeditDocumentSaver *saver)
+void
+_gedit_document_saver_start (GeditDocumentSaver *saver)
 {
 	AsyncData *async;
 
+	g_return_if_fail (GEDIT_IS_DOCUMENT_SAVER (saver));
+
 	gedit_debug_message (DEBUG_SAVER, "Starting  save");
 
+	gedit_trace_end (GEDIT_TRACE_SAVER, "queued", saver->priv->document,
+			 saver->priv->save_begin, -1);
+
 	/* First find out if the file is modified externally. This requires
 	 * a stat, but I don't think we can do this any other way
 	 */
 	async = async_data_new (saver);
 
 	check_modified_async (async);
-
-	/* return false to stop timeout */
-	return FALSE;
 }
 
 void
@@ -980,15 +1034,13 @@ gedit_document_saver_save (GeditDocumentSaver *saver,
 	}
 
 	saver->priv->old_mtime = *old_mtime;
+	saver->priv->save_begin = gedit_trace_begin ();
 
 	/* saving start */
 	gedit_document_saver_saving (saver, FALSE, NULL);
 
-	g_timeout_add_full (G_PRIORITY_HIGH,
-			    0,
-			    (GSourceFunc) save_remote_file_real,
-			    saver,
-			    NULL);
+	/* The save starts when the scheduler lets it */
+	_gedit_save_scheduler_add (_gedit_save_scheduler_get_default (), saver);
 }
 
 void
@@ -1002,6 +1054,10 @@ gedit_document_saver_saving (GeditDocumentSaver *saver,
 	if (completed)
 	{
 		g_object_ref (saver);
+
+		/* Let the next save start */
+		_gedit_save_scheduler_finished (_gedit_save_scheduler_get_default (),
+						saver);
 	}
 
 	g_signal_emit (saver, signals[SAVING], 0, completed, error);
@@ -95,6 +95,9 @@ void			 gedit_document_saver_saving		(GeditDocumentSaver  *saver,
 void			 gedit_document_saver_save		(GeditDocumentSaver  *saver,
 								 GTimeVal            *old_mtime);
 
+/* Called by the save scheduler when it is the turn of the saver */
+void			_gedit_document_saver_start		(GeditDocumentSaver  *saver);
+
 #if 0
 void			 gedit_document_saver_cancel		(GeditDocumentSaver  *saver);
 #endif
@@ -48,6 +48,7 @@
 #include "gedit-document-saver.h"
 #include "gedit-marshal.h"
 #include "gedit-enum-types.h"
+#include "gedit-trace.h"
 
 #ifndef ENABLE_GVFS_METADATA
 #include "gedit-metadata-manager.h"
@@ -85,6 +86,21 @@ static void	gedit_document_save_real	(GeditDocument                *doc,
 						 GeditDocumentNewlineType      newline_type,
 						 GeditDocumentCompressionType  compression_type,
 						 GeditDocumentSaveFlags        flags);
+static void	gedit_document_insert_text	(GtkTextBuffer                *buffer,
+						 GtkTextIter                  *pos,
+						 const gchar                  *text,
+						 gint                          len);
+static void	gedit_document_delete_range	(GtkTextBuffer                *buffer,
+						 GtkTextIter                  *start,
+						 GtkTextIter                  *end);
+static void	gedit_document_apply_tag	(GtkTextBuffer                *buffer,
+						 GtkTextTag                   *tag,
+						 const GtkTextIter            *start,
+						 const GtkTextIter            *end);
+static void	gedit_document_remove_tag	(GtkTextBuffer                *buffer,
+						 GtkTextTag                   *tag,
+						 const GtkTextIter            *start,
+						 const GtkTextIter            *end);
 
 struct _GeditDocumentPrivate
 {
@@ -125,6 +141,9 @@ struct _GeditDocumentPrivate
 
 	GtkTextTag *error_tag;
 
+	/* The ranges the error tag was applied to, in buffer order */
+	GArray *invalid_ranges;
+
 	/* Mount operation factory */
 	GeditMountOperationFactory  mount_operation_factory;
 	gpointer		    mount_operation_userdata;
@@ -137,6 +156,9 @@ struct _GeditDocumentPrivate
 	guint stop_cursor_moved_emission : 1;
 	guint dispose_has_run : 1;
 
+	/* Cleared before "loaded" is emitted, unlike the loader */
+	guint loading : 1;
+
 	/* The search is empty if there is no search context, or if the
 	 * search text is empty. It is used for the sensitivity of some menu
 	 * actions.
@@ -320,6 +342,11 @@ gedit_document_finalize (GObject *object)
 
 	g_free (doc->priv->content_type);
 
+	if (doc->priv->invalid_ranges != NULL)
+	{
+		g_array_unref (doc->priv->invalid_ranges);
+	}
+
 	G_OBJECT_CLASS (gedit_document_parent_class)->finalize (object);
 }
 
@@ -463,6 +490,10 @@ gedit_document_class_init (GeditDocumentClass *klass)
 
 	buf_class->mark_set = gedit_document_mark_set;
 	buf_class->changed = gedit_document_changed;
+	buf_class->insert_text = gedit_document_insert_text;
+	buf_class->delete_range = gedit_document_delete_range;
+	buf_class->apply_tag = gedit_document_apply_tag;
+	buf_class->remove_tag = gedit_document_remove_tag;
 
 	klass->load = gedit_document_load_real;
 	klass->save = gedit_document_save_real;
@@ -801,15 +832,18 @@ on_location_changed (GeditDocument *doc,
 	if (location != NULL)
 	{
 		GError *error = NULL;
+		gint64 begin;
 
 		if (doc->priv->metadata_info != NULL)
 			g_object_unref (doc->priv->metadata_info);
 
+		begin = gedit_trace_begin ();
 		doc->priv->metadata_info = g_file_query_info (location,
 							      METADATA_QUERY,
 							      G_FILE_QUERY_INFO_NONE,
 							      NULL,
 							      &error);
+		gedit_trace_end (GEDIT_TRACE_DOCUMENT, "query-metadata", doc, begin, -1);
 
 		if (error != NULL)
 		{
@@ -1317,6 +1351,9 @@ document_loader_loaded (GeditDocumentLoader *loader,
 			const GError        *error,
 			GeditDocument       *doc)
 {
+	/* The handlers of "loaded" can already edit the document */
+	doc->priv->loading = FALSE;
+
 	/* load was successful */
 	if (error == NULL ||
 	    (error->domain == GEDIT_DOCUMENT_ERROR &&
@@ -1498,6 +1535,7 @@ gedit_document_load_real (GeditDocument       *doc,
 
 	/* create a loader. It will be destroyed when loading is completed */
 	doc->priv->loader = gedit_document_loader_new (doc, location, encoding);
+	doc->priv->loading = TRUE;
 
 	g_signal_connect (doc->priv->loader,
 			  "loading",
@@ -1538,6 +1576,7 @@ gedit_document_load_stream (GeditDocument       *doc,
 
 	/* create a loader. It will be destroyed when loading is completed */
 	doc->priv->loader = gedit_document_loader_new_from_stream (doc, stream, encoding);
+	doc->priv->loading = TRUE;
 
 	g_signal_connect (doc->priv->loader,
 			  "loading",
@@ -1599,32 +1638,365 @@ gedit_document_load_cancel (GeditDocument *doc)
 	return gedit_document_loader_cancel (doc->priv->loader);
 }
 
+/* The ranges of invalid chars are kept as char offsets, sorted and without
+ * overlaps, and are shifted by the insert-text and delete-range handlers so
+ * that they follow the edits. Text inserted at the start of a range is put
+ * before it, text inserted at its end is put after it. A range whose text
+ * is deleted is dropped.
+ */
+typedef struct
+{
+	gint start;
+	gint end;
+} InvalidRange;
+
+#define INVALID_RANGE(doc, i) (&g_array_index ((doc)->priv->invalid_ranges, InvalidRange, (i)))
+
+/* Returns the index of the first range that ends after offset */
+static guint
+find_invalid_range (GeditDocument *doc,
+		    gint           offset)
+{
+	guint low = 0;
+	guint high = doc->priv->invalid_ranges->len;
+
+	while (low < high)
+	{
+		guint mid = low + (high - low) / 2;
+
+		if (INVALID_RANGE (doc, mid)->end <= offset)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static void
+add_invalid_range (GeditDocument *doc,
+		   gint           start,
+		   gint           end)
+{
+	InvalidRange range;
+	guint first;
+	guint last;
+
+	if (start >= end)
+	{
+		return;
+	}
+
+	if (doc->priv->invalid_ranges == NULL)
+	{
+		doc->priv->invalid_ranges = g_array_new (FALSE, FALSE, sizeof (InvalidRange));
+	}
+
+	/* Merge the new range with the ones it overlaps or touches */
+	first = find_invalid_range (doc, start - 1);
+	last = first;
+
+	while (last < doc->priv->invalid_ranges->len &&
+	       INVALID_RANGE (doc, last)->start <= end)
+	{
+		start = MIN (start, INVALID_RANGE (doc, last)->start);
+		end = MAX (end, INVALID_RANGE (doc, last)->end);
+		++last;
+	}
+
+	range.start = start;
+	range.end = end;
+
+	if (last > first)
+	{
+		g_array_remove_range (doc->priv->invalid_ranges, first, last - first);
+	}
+
+	g_array_insert_val (doc->priv->invalid_ranges, first, range);
+}
+
+static void
+remove_invalid_range (GeditDocument *doc,
+		      gint           start,
+		      gint           end)
+{
+	guint i;
+
+	if (doc->priv->invalid_ranges == NULL)
+	{
+		return;
+	}
+
+	i = find_invalid_range (doc, start);
+
+	while (i < doc->priv->invalid_ranges->len &&
+	       INVALID_RANGE (doc, i)->start < end)
+	{
+		InvalidRange *range = INVALID_RANGE (doc, i);
+
+		if (range->start < start && range->end > end)
+		{
+			InvalidRange tail;
+
+			tail.start = end;
+			tail.end = range->end;
+			range->end = start;
+
+			g_array_insert_val (doc->priv->invalid_ranges, i + 1, tail);
+			return;
+		}
+		else if (range->start < start)
+		{
+			range->end = start;
+			++i;
+		}
+		else if (range->end > end)
+		{
+			range->start = end;
+			return;
+		}
+		else
+		{
+			g_array_remove_index (doc->priv->invalid_ranges, i);
+		}
+	}
+}
+
+static void
+shift_invalid_ranges_on_insert (GeditDocument *doc,
+				gint           offset,
+				gint           n_chars)
+{
+	guint i;
+
+	if (doc->priv->invalid_ranges == NULL)
+	{
+		return;
+	}
+
+	for (i = find_invalid_range (doc, offset); i < doc->priv->invalid_ranges->len; ++i)
+	{
+		InvalidRange *range = INVALID_RANGE (doc, i);
+
+		if (range->start >= offset)
+		{
+			range->start += n_chars;
+		}
+
+		range->end += n_chars;
+	}
+}
+
+static void
+shift_invalid_ranges_on_delete (GeditDocument *doc,
+				gint           start,
+				gint           end)
+{
+	guint i;
+	guint j;
+
+	if (doc->priv->invalid_ranges == NULL)
+	{
+		return;
+	}
+
+	i = find_invalid_range (doc, start);
+	j = i;
+
+	for (; i < doc->priv->invalid_ranges->len; ++i)
+	{
+		InvalidRange range = *INVALID_RANGE (doc, i);
+
+		range.start = range.start >= end ? range.start - (end - start) : MIN (range.start, start);
+		range.end = range.end >= end ? range.end - (end - start) : MIN (range.end, start);
+
+		if (range.start < range.end)
+		{
+			*INVALID_RANGE (doc, j) = range;
+			++j;
+		}
+	}
+
+	g_array_set_size (doc->priv->invalid_ranges, j);
+}
+
+static void
+get_invalid_range (GeditDocument *doc,
+		   guint          i,
+		   GtkTextIter   *start,
+		   GtkTextIter   *end)
+{
+	InvalidRange *range = INVALID_RANGE (doc, i);
+
+	gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (doc), start, range->start);
+	gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (doc), end, range->end);
+}
+
 static gboolean
 has_invalid_chars (GeditDocument *doc)
 {
-	GtkTextBuffer *buffer;
-	GtkTextIter start;
-
 	g_return_val_if_fail (GEDIT_IS_DOCUMENT (doc), FALSE);
 
 	gedit_debug (DEBUG_DOCUMENT);
 
-	if (doc->priv->error_tag == NULL)
+	return _gedit_document_get_n_invalid_ranges (doc) > 0;
+}
+
+/* Returns the number of ranges of invalid chars in the document */
+guint
+_gedit_document_get_n_invalid_ranges (GeditDocument *doc)
+{
+	g_return_val_if_fail (GEDIT_IS_DOCUMENT (doc), 0);
+
+	if (doc->priv->invalid_ranges == NULL)
+	{
+		return 0;
+	}
+
+	return doc->priv->invalid_ranges->len;
+}
+
+/* Finds the first range of invalid chars that ends after iter */
+gboolean
+_gedit_document_forward_invalid_range (GeditDocument     *doc,
+				       const GtkTextIter *iter,
+				       GtkTextIter       *match_start,
+				       GtkTextIter       *match_end)
+{
+	guint i;
+
+	g_return_val_if_fail (GEDIT_IS_DOCUMENT (doc), FALSE);
+	g_return_val_if_fail (iter != NULL, FALSE);
+
+	if (doc->priv->invalid_ranges == NULL)
 	{
 		return FALSE;
 	}
 
-	buffer = GTK_TEXT_BUFFER (doc);
+	i = find_invalid_range (doc, gtk_text_iter_get_offset (iter));
 
-	gtk_text_buffer_get_start_iter (buffer, &start);
+	if (i == doc->priv->invalid_ranges->len)
+	{
+		return FALSE;
+	}
 
-	if (gtk_text_iter_begins_tag (&start, doc->priv->error_tag) ||
-	    gtk_text_iter_forward_to_tag_toggle (&start, doc->priv->error_tag))
+	get_invalid_range (doc, i, match_start, match_end);
+
+	return TRUE;
+}
+
+/* Finds the last range of invalid chars that starts before iter */
+gboolean
+_gedit_document_backward_invalid_range (GeditDocument     *doc,
+					const GtkTextIter *iter,
+					GtkTextIter       *match_start,
+					GtkTextIter       *match_end)
+{
+	gint offset;
+	guint i;
+
+	g_return_val_if_fail (GEDIT_IS_DOCUMENT (doc), FALSE);
+	g_return_val_if_fail (iter != NULL, FALSE);
+
+	if (doc->priv->invalid_ranges == NULL)
 	{
-		return TRUE;
+		return FALSE;
 	}
 
-	return FALSE;
+	offset = gtk_text_iter_get_offset (iter);
+	i = find_invalid_range (doc, offset);
+
+	/* The ranges do not overlap: the last range that starts before iter
+	 * is the first one that ends after it if it contains iter, otherwise
+	 * the one before.
+	 */
+	if (i < doc->priv->invalid_ranges->len &&
+	    INVALID_RANGE (doc, i)->start < offset)
+	{
+		++i;
+	}
+
+	if (i == 0)
+	{
+		return FALSE;
+	}
+
+	get_invalid_range (doc, i - 1, match_start, match_end);
+
+	return TRUE;
+}
+
+static void
+gedit_document_insert_text (GtkTextBuffer *buffer,
+			    GtkTextIter   *pos,
+			    const gchar   *text,
+			    gint           len)
+{
+	GeditDocument *doc = GEDIT_DOCUMENT (buffer);
+	gint offset;
+
+	offset = gtk_text_iter_get_offset (pos);
+
+	GTK_TEXT_BUFFER_CLASS (gedit_document_parent_class)->insert_text (buffer, pos, text, len);
+
+	shift_invalid_ranges_on_insert (doc, offset, g_utf8_strlen (text, len));
+}
+
+static void
+gedit_document_delete_range (GtkTextBuffer *buffer,
+			     GtkTextIter   *start,
+			     GtkTextIter   *end)
+{
+	GeditDocument *doc = GEDIT_DOCUMENT (buffer);
+	gint start_offset;
+	gint end_offset;
+
+	start_offset = gtk_text_iter_get_offset (start);
+	end_offset = gtk_text_iter_get_offset (end);
+
+	GTK_TEXT_BUFFER_CLASS (gedit_document_parent_class)->delete_range (buffer, start, end);
+
+	shift_invalid_ranges_on_delete (doc, start_offset, end_offset);
+}
+
+/* The error tag is also applied when text that has it is copied within the
+ * buffer, so the index is kept up to date here rather than only when the
+ * invalid chars are found on load.
+ */
+static void
+gedit_document_apply_tag (GtkTextBuffer     *buffer,
+			  GtkTextTag        *tag,
+			  const GtkTextIter *start,
+			  const GtkTextIter *end)
+{
+	GeditDocument *doc = GEDIT_DOCUMENT (buffer);
+
+	GTK_TEXT_BUFFER_CLASS (gedit_document_parent_class)->apply_tag (buffer, tag, start, end);
+
+	if (tag != NULL && tag == doc->priv->error_tag)
+	{
+		add_invalid_range (doc,
+				   gtk_text_iter_get_offset (start),
+				   gtk_text_iter_get_offset (end));
+	}
+}
+
+static void
+gedit_document_remove_tag (GtkTextBuffer     *buffer,
+			   GtkTextTag        *tag,
+			   const GtkTextIter *start,
+			   const GtkTextIter *end)
+{
+	GeditDocument *doc = GEDIT_DOCUMENT (buffer);
+
+	GTK_TEXT_BUFFER_CLASS (gedit_document_parent_class)->remove_tag (buffer, tag, start, end);
+
+	if (tag != NULL && tag == doc->priv->error_tag)
+	{
+		remove_invalid_range (doc,
+				      gtk_text_iter_get_offset (start),
+				      gtk_text_iter_get_offset (end));
+	}
 }
 
 static void
@@ -1972,6 +2344,16 @@ _gedit_document_needs_saving (GeditDocument *doc)
 	return FALSE;
 }
 
+/* Whether the document is being loaded, so that its text is not the
+ * result of edits. It is not anymore once "loaded" is emitted. */
+gboolean
+_gedit_document_is_loading (GeditDocument *doc)
+{
+	g_return_val_if_fail (GEDIT_IS_DOCUMENT (doc), FALSE);
+
+	return doc->priv->loading;
+}
+
 /*
  * If @line is bigger than the lines of the document, the cursor is moved
  * to the last line and FALSE is returned.
@@ -2320,6 +2702,7 @@ gedit_document_set_metadata (GeditDocument *doc,
 	const gchar *key;
 	const gchar *value;
 	va_list var_args;
+	gint64 begin;
 
 	g_return_if_fail (GEDIT_IS_DOCUMENT (doc));
 	g_return_if_fail (first_key != NULL);
@@ -2330,6 +2713,8 @@ gedit_document_set_metadata (GeditDocument *doc,
 		return;
 	}
 
+	begin = gedit_trace_begin ();
+
 	va_start (var_args, first_key);
 
 	for (key = first_key; key; key = va_arg (var_args, const gchar *))
@@ -2343,6 +2728,8 @@ gedit_document_set_metadata (GeditDocument *doc,
 	}
 
 	va_end (var_args);
+
+	gedit_trace_end (GEDIT_TRACE_DOCUMENT, "write-metadata", doc, begin, -1);
 }
 
 #else
@@ -2375,11 +2762,19 @@ gedit_document_get_metadata (GeditDocument *doc,
 	return value;
 }
 
+typedef struct
+{
+	/* Only used to identify the document in the trace */
+	gconstpointer doc;
+	gint64        begin;
+} MetadataWrite;
+
 static void
 set_attributes_cb (GObject      *source,
 		   GAsyncResult *res,
-		   gpointer      useless)
+		   gpointer      user_data)
 {
+	MetadataWrite *write = user_data;
 	GError *error = NULL;
 
 	g_file_set_attributes_finish (G_FILE (source),
@@ -2387,6 +2782,10 @@ set_attributes_cb (GObject      *source,
 				      NULL,
 				      &error);
 
+	gedit_trace_end (GEDIT_TRACE_DOCUMENT, "write-metadata", write->doc,
+			 write->begin, -1);
+	g_slice_free (MetadataWrite, write);
+
 	if (error != NULL)
 	{
 		g_warning ("Set document metadata failed: %s", error->message);
@@ -2446,13 +2845,19 @@ gedit_document_set_metadata (GeditDocument *doc,
 
 	if (location != NULL)
 	{
+		MetadataWrite *write;
+
+		write = g_slice_new (MetadataWrite);
+		write->doc = doc;
+		write->begin = gedit_trace_begin ();
+
 		g_file_set_attributes_async (location,
 					     info,
 					     G_FILE_QUERY_INFO_NONE,
 					     G_PRIORITY_DEFAULT,
 					     NULL,
 					     set_attributes_cb,
-					     NULL);
+					     write);
 
 		g_object_unref (location);
 	}
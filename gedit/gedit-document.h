@@ -282,12 +282,29 @@ void		 _gedit_document_apply_error_style
                                                  GtkTextIter   *start,
                                                  GtkTextIter   *end);
 
+guint		 _gedit_document_get_n_invalid_ranges
+						(GeditDocument       *doc);
+
+gboolean	 _gedit_document_forward_invalid_range
+						(GeditDocument       *doc,
+						 const GtkTextIter   *iter,
+						 GtkTextIter         *match_start,
+						 GtkTextIter         *match_end);
+
+gboolean	 _gedit_document_backward_invalid_range
+						(GeditDocument       *doc,
+						 const GtkTextIter   *iter,
+						 GtkTextIter         *match_start,
+						 GtkTextIter         *match_end);
+
 /* Note: this is a sync stat: use only on local files */
 gboolean	_gedit_document_check_externally_modified
 						(GeditDocument       *doc);
 
 gboolean	 _gedit_document_needs_saving	(GeditDocument       *doc);
 
+gboolean	 _gedit_document_is_loading	(GeditDocument       *doc);
+
 /**
  * GeditMountOperationFactory: (skip)
  * @doc:
@@ -50,6 +50,18 @@ struct _GeditDocumentsPanelPrivate
 	GtkWidget          *treeview;
 	GtkTreeModel       *model;
 
+	/* GeditTab -> GtkTreeIter and GeditNotebook -> GtkTreeIter, the
+	 * iters of a GtkTreeStore persist as long as the row exists.
+	 */
+	GHashTable         *tab_rows;
+	GHashTable         *notebook_rows;
+
+	/* GeditTabState -> GdkPixbuf, NULL values are stored too */
+	GHashTable         *icons;
+
+	/* Whether the notebook rows are shown */
+	guint               show_notebooks : 1;
+
 	guint               selection_changed_handler_id;
 	guint               refresh_idle_id;
 
@@ -146,110 +158,47 @@ tab_get_name (GeditTab *tab)
 
 static gboolean
 get_iter_from_tab (GeditDocumentsPanel *panel,
-		   GeditNotebook       *notebook,
 		   GeditTab            *tab,
 		   GtkTreeIter         *tab_iter)
 {
-	GtkTreeIter parent;
-	gboolean success;
-	gboolean search_notebook;
-
-	/* Note: we cannot use the functions of the MultiNotebook
-	 *       because in cases where the notebook or tab has been
-	 *       removed already we will fail to get an iter.
-	 */
+	GtkTreeIter *iter;
 
 	gedit_debug (DEBUG_PANEL);
 
-	g_assert (notebook != NULL);
-	/* tab may be NULL if just the notebook is specified */
 	g_assert (tab_iter != NULL);
 
-	search_notebook = (gedit_multi_notebook_get_n_notebooks (panel->priv->mnb) > 1);
+	iter = g_hash_table_lookup (panel->priv->tab_rows, tab);
 
-	if (!gtk_tree_model_get_iter_first (panel->priv->model, &parent))
+	if (iter == NULL)
 		return FALSE;
 
-	success = FALSE;
-	do
-	{
-		GtkTreeIter iter;
-
-		if (search_notebook)
-		{
-			GeditNotebook *current_notebook;
-
-			gtk_tree_model_get (panel->priv->model,
-					    &parent,
-					    NOTEBOOK_COLUMN, &current_notebook,
-					    -1);
-
-			if (current_notebook != NULL)
-			{
-				gboolean is_cur;
-				is_cur = (current_notebook == notebook);
-
-				g_object_unref (current_notebook);
-
-				if (is_cur)
-				{
-					/* notebook found */
-					search_notebook = FALSE;
-					gtk_tree_model_iter_children (panel->priv->model, &iter, &parent);
-				}
-			}
-		}
-		else
-		{
-			iter = parent;
-		}
-
-		if (!search_notebook)
-		{
-			if (tab == NULL)
-			{
-				success = TRUE;
-				break;
-			}
-
-			g_assert (gtk_tree_store_iter_is_valid (GTK_TREE_STORE (panel->priv->model),
-								&iter));
-
-			do
-			{
-				GeditTab *current_tab;
+	*tab_iter = *iter;
 
-				gtk_tree_model_get (panel->priv->model,
-						    &iter,
-						    TAB_COLUMN, &current_tab,
-						    -1);
-
-				if (current_tab != NULL)
-				{
-					gboolean is_cur;
-
-					is_cur = (current_tab == tab);
-					g_object_unref (current_tab);
-
-					if (is_cur)
-					{
-						*tab_iter = iter;
-						success = TRUE;
+	return TRUE;
+}
 
-						/* break 2; */
-						goto out;
-					}
-				}
-			} while (gtk_tree_model_iter_next (panel->priv->model, &iter));
+static GdkPixbuf *
+get_tab_icon (GeditDocumentsPanel *panel,
+	      GeditTab            *tab)
+{
+	gpointer state;
+	GdkPixbuf *pixbuf;
 
-			/* We already found the notebook and the tab was not found */
-			g_assert (!success);
-		}
-	} while (gtk_tree_model_iter_next (panel->priv->model, &parent));
+	/* The icon only depends on the state, don't load it from the icon
+	 * theme for each tab.
+	 */
+	state = GINT_TO_POINTER (gedit_tab_get_state (tab));
 
-out:
+	if (!g_hash_table_lookup_extended (panel->priv->icons,
+					   state,
+					   NULL,
+					   (gpointer *)&pixbuf))
+	{
+		pixbuf = _gedit_tab_get_icon (tab);
+		g_hash_table_insert (panel->priv->icons, state, pixbuf);
+	}
 
-	return success;
+	return pixbuf;
 }
 
 static void
@@ -287,7 +236,7 @@ select_active_tab (GeditDocumentsPanel *panel)
 	{
 		GtkTreeIter iter;
 
-		if (get_iter_from_tab (panel, notebook, tab, &iter))
+		if (get_iter_from_tab (panel, tab, &iter))
 			select_iter (panel, &iter);
 	}
 }
@@ -307,14 +256,42 @@ multi_notebook_tab_switched (GeditMultiNotebook  *mnb,
 	{
 		GtkTreeIter iter;
 
-		if (get_iter_from_tab (panel, new_notebook, new_tab, &iter) &&
-		    gtk_tree_store_iter_is_valid (GTK_TREE_STORE (panel->priv->model), &iter))
+		if (get_iter_from_tab (panel, new_tab, &iter))
 		{
 			select_iter (panel, &iter);
 		}
 	}
 }
 
+static void
+insert_tab_row (GeditDocumentsPanel *panel,
+		GeditNotebook       *notebook,
+		GeditTab            *tab,
+		GtkTreeIter         *parent,
+		gint                 position,
+		GtkTreeIter         *iter)
+{
+	gchar *name;
+
+	name = tab_get_name (tab);
+
+	gtk_tree_store_insert_with_values (GTK_TREE_STORE (panel->priv->model),
+					   iter,
+					   parent,
+					   position,
+					   PIXBUF_COLUMN, get_tab_icon (panel, tab),
+					   NAME_COLUMN, name,
+					   NOTEBOOK_COLUMN, notebook,
+					   TAB_COLUMN, tab,
+					   -1);
+
+	g_hash_table_insert (panel->priv->tab_rows,
+			     tab,
+			     gtk_tree_iter_copy (iter));
+
+	g_free (name);
+}
+
 static void
 refresh_notebook (GeditDocumentsPanel *panel,
 		  GeditNotebook       *notebook,
@@ -322,41 +299,19 @@ refresh_notebook (GeditDocumentsPanel *panel,
 {
 	GList *tabs;
 	GList *l;
-	GtkTreeStore *tree_store;
 	GeditTab *active_tab;
 
 	gedit_debug (DEBUG_PANEL);
 
-	tree_store = GTK_TREE_STORE (panel->priv->model);
-
 	active_tab = gedit_window_get_active_tab (panel->priv->window);
 
 	tabs = gtk_container_get_children (GTK_CONTAINER (notebook));
 
 	for (l = tabs; l != NULL; l = g_list_next (l))
 	{
-		GdkPixbuf *pixbuf;
-		gchar *name;
 		GtkTreeIter iter;
 
-		name = tab_get_name (GEDIT_TAB (l->data));
-		pixbuf = _gedit_tab_get_icon (GEDIT_TAB (l->data));
-
-		/* Add a new row to the model */
-		gtk_tree_store_append (tree_store, &iter, parent);
-		gtk_tree_store_set (tree_store,
-				    &iter,
-				    PIXBUF_COLUMN, pixbuf,
-				    NAME_COLUMN, name,
-				    NOTEBOOK_COLUMN, notebook,
-				    TAB_COLUMN, l->data,
-				    -1);
-
-		g_free (name);
-		if (pixbuf != NULL)
-		{
-			g_object_unref (pixbuf);
-		}
+		insert_tab_row (panel, notebook, GEDIT_TAB (l->data), parent, -1, &iter);
 
 		if (l->data == active_tab)
 		{
@@ -395,6 +350,10 @@ refresh_notebook_foreach (GeditNotebook       *notebook,
 				    TAB_COLUMN, NULL,
 				    -1);
 
+		g_hash_table_insert (panel->priv->notebook_rows,
+				     notebook,
+				     gtk_tree_iter_copy (&iter));
+
 		refresh_notebook (panel, notebook, &iter);
 
 		g_free (name);
@@ -415,8 +374,13 @@ refresh_list_idle (GeditDocumentsPanel *panel)
 	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (panel->priv->treeview));
 	g_signal_handler_block (selection, panel->priv->selection_changed_handler_id);
 
+	g_hash_table_remove_all (panel->priv->tab_rows);
+	g_hash_table_remove_all (panel->priv->notebook_rows);
+
 	gtk_tree_store_clear (GTK_TREE_STORE (panel->priv->model));
 
+	panel->priv->show_notebooks = (gedit_multi_notebook_get_n_notebooks (panel->priv->mnb) > 1);
+
 	panel->priv->adding_tab = TRUE;
 	gedit_multi_notebook_foreach_notebook (panel->priv->mnb,
 					       (GtkCallback)refresh_notebook_foreach,
@@ -434,6 +398,9 @@ refresh_list_idle (GeditDocumentsPanel *panel)
 	return FALSE;
 }
 
+/* Only used when the notebook rows must be added or removed, tabs are
+ * added, removed and reordered one row at a time.
+ */
 static void
 refresh_list (GeditDocumentsPanel *panel)
 {
@@ -468,28 +435,28 @@ sync_name_and_icon (GeditTab            *tab,
 
 	gedit_debug (DEBUG_PANEL);
 
-	if (get_iter_from_tab (panel,
-			       gedit_multi_notebook_get_active_notebook (panel->priv->mnb),
-			       tab,
-			       &iter))
+	if (!get_iter_from_tab (panel, tab, &iter))
+		return;
+
+	if (g_strcmp0 (pspec->name, "state") == 0)
+	{
+		gtk_tree_store_set (GTK_TREE_STORE (panel->priv->model),
+				    &iter,
+				    PIXBUF_COLUMN, get_tab_icon (panel, tab),
+				    -1);
+	}
+	else
 	{
 		gchar *name;
-		GdkPixbuf *pixbuf;
 
 		name = tab_get_name (tab);
-		pixbuf = _gedit_tab_get_icon (tab);
 
 		gtk_tree_store_set (GTK_TREE_STORE (panel->priv->model),
 				    &iter,
-				    PIXBUF_COLUMN, pixbuf,
 				    NAME_COLUMN, name,
 				    -1);
 
 		g_free (name);
-		if (pixbuf != NULL)
-		{
-			g_object_unref (pixbuf);
-		}
 	}
 }
 
@@ -499,6 +466,8 @@ multi_notebook_tab_removed (GeditMultiNotebook  *mnb,
 			    GeditTab            *tab,
 			    GeditDocumentsPanel *panel)
 {
+	GtkTreeIter iter;
+
 	gedit_debug (DEBUG_PANEL);
 
 	g_signal_handlers_disconnect_by_func (gedit_tab_get_document (tab),
@@ -509,7 +478,11 @@ multi_notebook_tab_removed (GeditMultiNotebook  *mnb,
 					      G_CALLBACK (sync_name_and_icon),
 					      panel);
 
-	refresh_list (panel);
+	if (get_iter_from_tab (panel, tab, &iter))
+	{
+		gtk_tree_store_remove (GTK_TREE_STORE (panel->priv->model), &iter);
+		g_hash_table_remove (panel->priv->tab_rows, tab);
+	}
 }
 
 static void
@@ -518,6 +491,11 @@ multi_notebook_tab_added (GeditMultiNotebook  *mnb,
 			  GeditTab            *tab,
 			  GeditDocumentsPanel *panel)
 {
+	GtkTreeSelection *selection;
+	GtkTreeIter *parent = NULL;
+	GtkTreeIter iter;
+	gboolean show_notebooks;
+
 	gedit_debug (DEBUG_PANEL);
 
 	g_signal_connect (tab,
@@ -529,7 +507,47 @@ multi_notebook_tab_added (GeditMultiNotebook  *mnb,
 			  G_CALLBACK (sync_name_and_icon),
 			  panel);
 
-	refresh_list (panel);
+	/* The whole list is going to be rebuilt anyway */
+	if (panel->priv->refresh_idle_id != 0)
+		return;
+
+	show_notebooks = (gedit_multi_notebook_get_n_notebooks (mnb) > 1);
+
+	if (show_notebooks != panel->priv->show_notebooks)
+	{
+		refresh_list (panel);
+		return;
+	}
+
+	if (show_notebooks)
+	{
+		parent = g_hash_table_lookup (panel->priv->notebook_rows, notebook);
+
+		if (parent == NULL)
+		{
+			refresh_list (panel);
+			return;
+		}
+	}
+
+	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (panel->priv->treeview));
+	g_signal_handler_block (selection, panel->priv->selection_changed_handler_id);
+
+	panel->priv->adding_tab = TRUE;
+	insert_tab_row (panel,
+			notebook,
+			tab,
+			parent,
+			gtk_notebook_page_num (GTK_NOTEBOOK (notebook), GTK_WIDGET (tab)),
+			&iter);
+	panel->priv->adding_tab = FALSE;
+
+	if (tab == gedit_window_get_active_tab (panel->priv->window))
+	{
+		select_iter (panel, &iter);
+	}
+
+	g_signal_handler_unblock (selection, panel->priv->selection_changed_handler_id);
 }
 
 static void
@@ -547,12 +565,43 @@ multi_notebook_tabs_reordered (GeditMultiNotebook  *mnb,
                                gint                 page_num,
                                GeditDocumentsPanel *panel)
 {
+	GtkTreeIter iter;
+	GtkWidget *next_page;
+
 	gedit_debug (DEBUG_PANEL);
 
 	if (panel->priv->is_reodering)
 		return;
 
-	refresh_list (panel);
+	if (panel->priv->refresh_idle_id != 0 ||
+	    !get_iter_from_tab (panel, GEDIT_TAB (page), &iter))
+	{
+		refresh_list (panel);
+		return;
+	}
+
+	next_page = gtk_notebook_get_nth_page (GTK_NOTEBOOK (notebook), page_num + 1);
+
+	if (next_page != NULL)
+	{
+		GtkTreeIter next_iter;
+
+		if (!get_iter_from_tab (panel, GEDIT_TAB (next_page), &next_iter))
+		{
+			refresh_list (panel);
+			return;
+		}
+
+		gtk_tree_store_move_before (GTK_TREE_STORE (panel->priv->model),
+					    &iter,
+					    &next_iter);
+	}
+	else
+	{
+		gtk_tree_store_move_before (GTK_TREE_STORE (panel->priv->model),
+					    &iter,
+					    NULL);
+	}
 }
 
 static void
@@ -681,12 +730,16 @@ gedit_documents_panel_get_property (GObject    *object,
 static void
 gedit_documents_panel_finalize (GObject *object)
 {
-	/* GeditDocumentsPanel *tab = GEDIT_DOCUMENTS_PANEL (object); */
+	GeditDocumentsPanel *panel = GEDIT_DOCUMENTS_PANEL (object);
 
 	/* TODO disconnect signal with window */
 
 	gedit_debug (DEBUG_PANEL);
 
+	g_hash_table_destroy (panel->priv->tab_rows);
+	g_hash_table_destroy (panel->priv->notebook_rows);
+	g_hash_table_destroy (panel->priv->icons);
+
 	G_OBJECT_CLASS (gedit_documents_panel_parent_class)->finalize (object);
 }
 
@@ -708,16 +761,39 @@ gedit_documents_panel_dispose (GObject *object)
 	G_OBJECT_CLASS (gedit_documents_panel_parent_class)->dispose (object);
 }
 
+static void
+gedit_documents_panel_style_updated (GtkWidget *widget)
+{
+	GeditDocumentsPanel *panel = GEDIT_DOCUMENTS_PANEL (widget);
+
+	GTK_WIDGET_CLASS (gedit_documents_panel_parent_class)->style_updated (widget);
+
+	/* The icon theme may have changed */
+	if (panel->priv->icons != NULL &&
+	    g_hash_table_size (panel->priv->icons) > 0)
+	{
+		g_hash_table_remove_all (panel->priv->icons);
+
+		if (panel->priv->mnb != NULL)
+		{
+			refresh_list (panel);
+		}
+	}
+}
+
 static void
 gedit_documents_panel_class_init (GeditDocumentsPanelClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
 	object_class->finalize = gedit_documents_panel_finalize;
 	object_class->dispose = gedit_documents_panel_dispose;
 	object_class->get_property = gedit_documents_panel_get_property;
 	object_class->set_property = gedit_documents_panel_set_property;
 
+	widget_class->style_updated = gedit_documents_panel_style_updated;
+
 	g_object_class_install_property (object_class,
 					 PROP_WINDOW,
 					 g_param_spec_object ("window",
@@ -1080,6 +1156,15 @@ pixbuf_data_func (GtkTreeViewColumn   *column,
 	}
 }
 
+static void
+free_icon (GdkPixbuf *pixbuf)
+{
+	if (pixbuf != NULL)
+	{
+		g_object_unref (pixbuf);
+	}
+}
+
 static void
 gedit_documents_panel_init (GeditDocumentsPanel *panel)
 {
@@ -1096,6 +1181,19 @@ gedit_documents_panel_init (GeditDocumentsPanel *panel)
 	panel->priv->adding_tab = FALSE;
 	panel->priv->is_reodering = FALSE;
 
+	panel->priv->tab_rows = g_hash_table_new_full (g_direct_hash,
+						       g_direct_equal,
+						       NULL,
+						       (GDestroyNotify)gtk_tree_iter_free);
+	panel->priv->notebook_rows = g_hash_table_new_full (g_direct_hash,
+							    g_direct_equal,
+							    NULL,
+							    (GDestroyNotify)gtk_tree_iter_free);
+	panel->priv->icons = g_hash_table_new_full (g_direct_hash,
+						    g_direct_equal,
+						    NULL,
+						    (GDestroyNotify)free_icon);
+
 	gtk_orientable_set_orientation (GTK_ORIENTABLE (panel),
 	                                GTK_ORIENTATION_VERTICAL);
 
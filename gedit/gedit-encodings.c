@@ -284,11 +284,34 @@ static const GeditEncoding encodings [] = {
     "WINDOWS-1258", N_("Vietnamese") }
 };
 
+/* Charset -> GeditEncoding, the charsets are compared ignoring the case */
+static GHashTable *encodings_by_charset = NULL;
+
+static guint
+charset_hash (gconstpointer key)
+{
+	const gchar *p;
+	guint hash = 5381;
+
+	for (p = key; *p != '\0'; p++)
+		hash = (hash << 5) + hash + g_ascii_toupper (*p);
+
+	return hash;
+}
+
+static gboolean
+charset_equal (gconstpointer a,
+	       gconstpointer b)
+{
+	return g_ascii_strcasecmp (a, b) == 0;
+}
+
 static void
 gedit_encoding_lazy_init (void)
 {
 	static gboolean initialized = FALSE;
 	const gchar *locale_charset;
+	gint i;
 
 	if (initialized)
 		return;
@@ -298,13 +321,30 @@ gedit_encoding_lazy_init (void)
 		unknown_encoding.charset = g_strdup (locale_charset);
 	}
 
+	encodings_by_charset = g_hash_table_new (charset_hash, charset_equal);
+
+	g_hash_table_insert (encodings_by_charset,
+			     (gpointer) utf8_encoding.charset,
+			     (gpointer) &utf8_encoding);
+
+	for (i = 0; i < GEDIT_ENCODING_LAST; i++)
+	{
+		/* The first of the encodings with the same charset wins */
+		if (!g_hash_table_contains (encodings_by_charset, encodings[i].charset))
+		{
+			g_hash_table_insert (encodings_by_charset,
+					     (gpointer) encodings[i].charset,
+					     (gpointer) &encodings[i]);
+		}
+	}
+
 	initialized = TRUE;
 }
 
 const GeditEncoding *
 gedit_encoding_get_from_charset (const gchar *charset)
 {
-	gint i;
+	const GeditEncoding *encoding;
 
 	g_return_val_if_fail (charset != NULL, NULL);
 
@@ -313,17 +353,10 @@ gedit_encoding_get_from_charset (const gchar *charset)
 	if (charset == NULL)
 		return NULL;
 
-	if (g_ascii_strcasecmp (charset, "UTF-8") == 0)
-		return gedit_encoding_get_utf8 ();
+	encoding = g_hash_table_lookup (encodings_by_charset, charset);
 
-	i = 0;
-	while (i < GEDIT_ENCODING_LAST)
-	{
-		if (g_ascii_strcasecmp (charset, encodings[i].charset) == 0)
-			return &encodings[i];
-
-		++i;
-	}
+	if (encoding != NULL)
+		return encoding;
 
 	if (unknown_encoding.charset != NULL)
 	{
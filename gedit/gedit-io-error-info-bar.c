@@ -1183,7 +1183,8 @@ gedit_externally_modified_info_bar_new (GFile    *location,
 }
 
 GtkWidget *
-gedit_invalid_character_info_bar_new (GFile *location)
+gedit_invalid_character_info_bar_new (GFile *location,
+                                      guint  n_invalid_ranges)
 {
 	GtkWidget *info_bar;
 	GtkWidget *hbox_content;
@@ -1215,6 +1216,16 @@ gedit_invalid_character_info_bar_new (GFile *location)
 
 	info_bar = gtk_info_bar_new ();
 
+	if (n_invalid_ranges > 1)
+	{
+		gtk_info_bar_add_button (GTK_INFO_BAR (info_bar),
+					 _("_Previous"),
+					 GEDIT_INVALID_CHARACTER_RESPONSE_PREVIOUS);
+		gtk_info_bar_add_button (GTK_INFO_BAR (info_bar),
+					 _("_Next"),
+					 GEDIT_INVALID_CHARACTER_RESPONSE_NEXT);
+	}
+
 	gtk_info_bar_add_button (GTK_INFO_BAR (info_bar),
 				 _("S_ave Anyway"),
 				 GTK_RESPONSE_YES);
@@ -1229,8 +1240,19 @@ gedit_invalid_character_info_bar_new (GFile *location)
 	vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 6);
 	gtk_box_pack_start (GTK_BOX (hbox_content), vbox, TRUE, TRUE, 0);
 
-	primary_text = g_strdup_printf (_("Some invalid chars have been detected while saving “%s”"),
-					uri_for_display);
+	if (n_invalid_ranges > 0)
+	{
+		primary_text = g_strdup_printf (ngettext ("Invalid chars have been detected in %u place while saving “%s”",
+		                                          "Invalid chars have been detected in %u places while saving “%s”",
+		                                          n_invalid_ranges),
+		                                n_invalid_ranges,
+		                                uri_for_display);
+	}
+	else
+	{
+		primary_text = g_strdup_printf (_("Some invalid chars have been detected while saving “%s”"),
+		                                uri_for_display);
+	}
 
 	g_free (uri_for_display);
 
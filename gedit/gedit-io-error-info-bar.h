@@ -63,7 +63,15 @@ GtkWidget	*gedit_unrecoverable_saving_error_info_bar_new		(GFile               *
 GtkWidget	*gedit_externally_modified_info_bar_new		 	(GFile               *location,
 									 gboolean             document_modified);
 
-GtkWidget	*gedit_invalid_character_info_bar_new			(GFile               *location);
+/* Responses of the invalid character info bar, besides YES and CANCEL */
+enum
+{
+	GEDIT_INVALID_CHARACTER_RESPONSE_PREVIOUS = 1,
+	GEDIT_INVALID_CHARACTER_RESPONSE_NEXT
+};
+
+GtkWidget	*gedit_invalid_character_info_bar_new			(GFile               *location,
+									 guint                n_invalid_ranges);
 
 G_END_DECLS
 
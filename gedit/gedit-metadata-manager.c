@@ -32,6 +32,7 @@
 #include <libxml/xmlreader.h>
 #include "gedit-metadata-manager.h"
 #include "gedit-debug.h"
+#include "gedit-timer.h"
 
 /*
 #define GEDIT_METADATA_VERBOSE_DEBUG	1
@@ -92,11 +93,9 @@ gedit_metadata_manager_arm_timeout (void)
 	if (gedit_metadata_manager->timeout_id == 0)
 	{
 		gedit_metadata_manager->timeout_id =
-			g_timeout_add_seconds_full (G_PRIORITY_DEFAULT_IDLE,
-						    2,
-						    (GSourceFunc)gedit_metadata_manager_save,
-						    NULL,
-						    NULL);
+			_gedit_timer_add_seconds (2,
+						  (GSourceFunc)gedit_metadata_manager_save,
+						  NULL);
 	}
 }
 
@@ -146,7 +145,7 @@ gedit_metadata_manager_shutdown (void)
 
 	if (gedit_metadata_manager->timeout_id)
 	{
-		g_source_remove (gedit_metadata_manager->timeout_id);
+		_gedit_timer_remove (gedit_metadata_manager->timeout_id);
 		gedit_metadata_manager->timeout_id = 0;
 		gedit_metadata_manager_save (NULL);
 	}
@@ -0,0 +1,897 @@
+/*
+ * gedit-occurrence-index.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+/* The occurrence index keeps the sorted list of the matches of the
+ * interactive search, so the search entry can show how many occurrences
+ * were found so far while the rest of the buffer is being scanned.
+ *
+ * Only plain text searches that can't span several lines are handled,
+ * this keeps every match inside a single line so the index can be
+ * updated line by line when the buffer is edited. For other searches
+ * gedit_occurrence_index_set_settings() returns FALSE and the caller
+ * relies on the GtkSourceSearchContext alone.
+ *
+ * The scan starts at the line of the cursor, goes to the end of the
+ * buffer and then wraps around, a chunk at a time in an idle. When the
+ * search text grows and the previous scan is complete, the previous
+ * matches are just re-checked instead of scanning the whole buffer again.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gedit-occurrence-index.h"
+
+#include <string.h>
+
+#include "gedit-debug.h"
+
+/* Number of characters scanned at once */
+#define SCAN_CHUNK_SIZE 65536
+
+/* Number of previous matches re-checked at once */
+#define REFINE_CHUNK_SIZE 512
+
+/* Maximum time spent in one idle, in microseconds */
+#define STEP_TIME_SLICE 4000
+
+typedef struct
+{
+	gint start;
+	gint end;
+} Match;
+
+struct _GeditOccurrenceIndex
+{
+	GtkTextBuffer *buffer;
+
+	GeditOccurrenceIndexNotify notify;
+	gpointer user_data;
+
+	gchar *text;
+	GRegex *regex;
+	gint text_length;
+	guint case_sensitive : 1;
+
+	/* Sorted by start offset, matches never overlap */
+	GArray *matches;
+
+	/* The scan goes from scan_start to the end of the buffer, and then
+	 * from the start of the buffer to scan_start.
+	 */
+	gint scan_start;
+	gint scan_pos;
+	guint wrapped : 1;
+	guint complete : 1;
+
+	/* Matches of the previous search text, when refining */
+	GArray *candidates;
+	guint next_candidate;
+
+	guint idle_id;
+
+	gulong insert_text_id;
+	gulong delete_range_id;
+	gulong delete_range_after_id;
+
+	gint deleted_start;
+	gint deleted_length;
+};
+
+/* Returns the index of the first match that starts at or after @offset. */
+static guint
+find_first (GArray *matches,
+	    gint    offset)
+{
+	guint low = 0;
+	guint high = matches->len;
+
+	while (low < high)
+	{
+		guint mid = low + (high - low) / 2;
+
+		if (g_array_index (matches, Match, mid).start < offset)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+static void
+get_line_bounds (GtkTextBuffer *buffer,
+		 gint           offset,
+		 gint          *line_start,
+		 gint          *line_end)
+{
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_iter_at_offset (buffer, &iter, offset);
+
+	gtk_text_iter_set_line_offset (&iter, 0);
+
+	if (line_start != NULL)
+	{
+		*line_start = gtk_text_iter_get_offset (&iter);
+	}
+
+	if (!gtk_text_iter_ends_line (&iter))
+	{
+		gtk_text_iter_forward_to_line_end (&iter);
+	}
+
+	if (line_end != NULL)
+	{
+		*line_end = gtk_text_iter_get_offset (&iter);
+	}
+}
+
+/* Adds the matches starting in [start, end) to the index. The caller must
+ * ensure that no match is already indexed in that range. Returns the
+ * offset where a following scan must resume, so that the matches don't
+ * overlap.
+ */
+static gint
+scan_range (GeditOccurrenceIndex *index,
+	    gint                  start,
+	    gint                  end)
+{
+	GtkTextIter slice_start;
+	GtkTextIter slice_end;
+	gchar *slice;
+	GMatchInfo *match_info;
+	GArray *found;
+	gint resume = end;
+	gint char_offset = 0;
+	gint byte_offset = 0;
+
+	if (start >= end)
+	{
+		return end;
+	}
+
+	gtk_text_buffer_get_iter_at_offset (index->buffer, &slice_start, start);
+
+	/* A match can begin right before @end, keep enough context for it */
+	gtk_text_buffer_get_iter_at_offset (index->buffer, &slice_end, end + index->text_length);
+
+	slice = gtk_text_buffer_get_slice (index->buffer, &slice_start, &slice_end, TRUE);
+
+	found = g_array_new (FALSE, FALSE, sizeof (Match));
+
+	g_regex_match (index->regex, slice, 0, &match_info);
+
+	while (g_match_info_matches (match_info))
+	{
+		gint match_byte_start;
+		gint match_byte_end;
+		Match match;
+
+		g_match_info_fetch_pos (match_info, 0, &match_byte_start, &match_byte_end);
+
+		char_offset += g_utf8_strlen (slice + byte_offset, match_byte_start - byte_offset);
+		byte_offset = match_byte_start;
+
+		match.start = start + char_offset;
+
+		if (match.start >= end)
+		{
+			break;
+		}
+
+		match.end = match.start + g_utf8_strlen (slice + match_byte_start,
+							 match_byte_end - match_byte_start);
+
+		g_array_append_val (found, match);
+		resume = MAX (resume, match.end);
+
+		g_match_info_next (match_info, NULL);
+	}
+
+	g_match_info_free (match_info);
+
+	if (found->len > 0)
+	{
+		g_array_insert_vals (index->matches,
+				     find_first (index->matches, start),
+				     found->data,
+				     found->len);
+	}
+
+	g_array_free (found, TRUE);
+	g_free (slice);
+
+	return resume;
+}
+
+/* Checks whether a match of the current search text starts at
+ * @candidate->start.
+ */
+static gboolean
+check_candidate (GeditOccurrenceIndex *index,
+		 const Match          *candidate,
+		 Match                *match)
+{
+	GtkTextIter slice_start;
+	GtkTextIter slice_end;
+	gchar *slice;
+	GMatchInfo *match_info;
+	gboolean matches;
+
+	gtk_text_buffer_get_iter_at_offset (index->buffer, &slice_start, candidate->start);
+	gtk_text_buffer_get_iter_at_offset (index->buffer, &slice_end,
+					    candidate->start + index->text_length);
+
+	slice = gtk_text_buffer_get_slice (index->buffer, &slice_start, &slice_end, TRUE);
+
+	matches = g_regex_match (index->regex, slice, G_REGEX_MATCH_ANCHORED, &match_info);
+
+	if (matches)
+	{
+		gint match_byte_end;
+
+		g_match_info_fetch_pos (match_info, 0, NULL, &match_byte_end);
+
+		match->start = candidate->start;
+		match->end = candidate->start + g_utf8_strlen (slice, match_byte_end);
+	}
+
+	g_match_info_free (match_info);
+	g_free (slice);
+
+	return matches;
+}
+
+static void
+refine_chunk (GeditOccurrenceIndex *index)
+{
+	guint last = MIN (index->next_candidate + REFINE_CHUNK_SIZE,
+			  index->candidates->len);
+
+	for (; index->next_candidate < last; index->next_candidate++)
+	{
+		const Match *candidate;
+		Match match;
+
+		candidate = &g_array_index (index->candidates, Match, index->next_candidate);
+
+		/* Like the search context, skip the matches overlapping the
+		 * previous one, e.g. "abXab" at the second "ab" of "abXabXab" */
+		if (index->matches->len > 0 &&
+		    candidate->start < g_array_index (index->matches, Match, index->matches->len - 1).end)
+		{
+			continue;
+		}
+
+		if (check_candidate (index, candidate, &match))
+		{
+			g_array_append_val (index->matches, match);
+		}
+	}
+
+	if (index->next_candidate == index->candidates->len)
+	{
+		g_array_free (index->candidates, TRUE);
+		index->candidates = NULL;
+		index->complete = TRUE;
+	}
+}
+
+static void
+scan_chunk (GeditOccurrenceIndex *index)
+{
+	gint limit;
+
+	if (index->wrapped)
+	{
+		limit = index->scan_start;
+	}
+	else
+	{
+		limit = gtk_text_buffer_get_char_count (index->buffer);
+	}
+
+	index->scan_pos = scan_range (index,
+				      index->scan_pos,
+				      MIN (index->scan_pos + SCAN_CHUNK_SIZE, limit));
+
+	if (index->scan_pos < limit)
+	{
+		return;
+	}
+
+	if (!index->wrapped && index->scan_start > 0)
+	{
+		index->wrapped = TRUE;
+		index->scan_pos = 0;
+	}
+	else
+	{
+		index->complete = TRUE;
+	}
+}
+
+/* Returns TRUE if the index is complete */
+static gboolean
+step (GeditOccurrenceIndex *index)
+{
+	gint64 start_time = g_get_monotonic_time ();
+
+	while (!index->complete)
+	{
+		if (index->candidates != NULL)
+		{
+			refine_chunk (index);
+		}
+		else
+		{
+			scan_chunk (index);
+		}
+
+		if (g_get_monotonic_time () - start_time > STEP_TIME_SLICE)
+		{
+			break;
+		}
+	}
+
+	return index->complete;
+}
+
+static gboolean
+step_idle_cb (GeditOccurrenceIndex *index)
+{
+	gboolean complete = step (index);
+
+	if (complete)
+	{
+		gedit_debug_message (DEBUG_VIEW, "%u occurrences indexed",
+				     index->matches->len);
+
+		index->idle_id = 0;
+	}
+
+	index->notify (index->user_data);
+
+	return complete ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+static void
+install_idle (GeditOccurrenceIndex *index)
+{
+	if (index->idle_id == 0 && !index->complete)
+	{
+		index->idle_id = g_idle_add ((GSourceFunc)step_idle_cb, index);
+	}
+}
+
+static void
+remove_idle (GeditOccurrenceIndex *index)
+{
+	if (index->idle_id != 0)
+	{
+		g_source_remove (index->idle_id);
+		index->idle_id = 0;
+	}
+}
+
+static void
+start_scan (GeditOccurrenceIndex *index,
+	    const GtkTextIter    *around)
+{
+	GtkTextIter line_start = *around;
+
+	gtk_text_iter_set_line_offset (&line_start, 0);
+
+	if (index->candidates != NULL)
+	{
+		g_array_free (index->candidates, TRUE);
+		index->candidates = NULL;
+	}
+
+	g_array_set_size (index->matches, 0);
+
+	index->scan_start = gtk_text_iter_get_offset (&line_start);
+	index->scan_pos = index->scan_start;
+	index->wrapped = FALSE;
+	index->complete = FALSE;
+
+	/* Index the region around the cursor right away */
+	step (index);
+	install_idle (index);
+}
+
+static void
+reset (GeditOccurrenceIndex *index)
+{
+	remove_idle (index);
+
+	g_free (index->text);
+	index->text = NULL;
+
+	if (index->regex != NULL)
+	{
+		g_regex_unref (index->regex);
+		index->regex = NULL;
+	}
+
+	if (index->candidates != NULL)
+	{
+		g_array_free (index->candidates, TRUE);
+		index->candidates = NULL;
+	}
+
+	g_array_set_size (index->matches, 0);
+	index->complete = FALSE;
+}
+
+/* Two matches of a text that has a border (a proper prefix that is also
+ * a suffix) can overlap, so a longer search text could match at positions
+ * that were skipped during the previous scan.
+ */
+static gboolean
+has_border (const gchar *text,
+	    gboolean     case_sensitive)
+{
+	gchar *folded;
+	gsize len;
+	gsize k;
+	gboolean ret = FALSE;
+
+	folded = case_sensitive ? g_strdup (text) : g_utf8_casefold (text, -1);
+	len = strlen (folded);
+
+	for (k = 1; k < len; k++)
+	{
+		if (memcmp (folded, folded + len - k, k) == 0)
+		{
+			ret = TRUE;
+			break;
+		}
+	}
+
+	g_free (folded);
+	return ret;
+}
+
+static void
+restart_after_edit (GeditOccurrenceIndex *index)
+{
+	GtkTextIter cursor;
+
+	gtk_text_buffer_get_iter_at_mark (index->buffer,
+					  &cursor,
+					  gtk_text_buffer_get_insert (index->buffer));
+
+	start_scan (index, &cursor);
+}
+
+/* Removes the matches starting in [start, end] and shifts the following
+ * ones by @delta.
+ */
+static void
+update_range (GeditOccurrenceIndex *index,
+	      gint                  start,
+	      gint                  end,
+	      gint                  delta)
+{
+	guint first = find_first (index->matches, start);
+	guint last = find_first (index->matches, end + 1);
+	guint i;
+
+	if (last > first)
+	{
+		g_array_remove_range (index->matches, first, last - first);
+	}
+
+	for (i = first; i < index->matches->len; i++)
+	{
+		Match *match = &g_array_index (index->matches, Match, i);
+
+		match->start += delta;
+		match->end += delta;
+	}
+}
+
+static void
+insert_text_cb (GtkTextBuffer        *buffer,
+		GtkTextIter          *location,
+		const gchar          *text,
+		gint                  len,
+		GeditOccurrenceIndex *index)
+{
+	gint inserted_length;
+	gint line_start;
+	gint line_end;
+
+	if (index->regex == NULL)
+	{
+		return;
+	}
+
+	if (!index->complete)
+	{
+		restart_after_edit (index);
+		return;
+	}
+
+	/* @location has been revalidated to the end of the inserted text, the
+	 * inserted text can contain several lines.
+	 */
+	inserted_length = g_utf8_strlen (text, len);
+	get_line_bounds (buffer,
+			 gtk_text_iter_get_offset (location) - inserted_length,
+			 &line_start,
+			 NULL);
+	get_line_bounds (buffer,
+			 gtk_text_iter_get_offset (location),
+			 NULL,
+			 &line_end);
+
+	update_range (index, line_start, line_end - inserted_length, inserted_length);
+	scan_range (index, line_start, line_end);
+
+	index->notify (index->user_data);
+}
+
+static void
+delete_range_cb (GtkTextBuffer        *buffer,
+		 GtkTextIter          *start,
+		 GtkTextIter          *end,
+		 GeditOccurrenceIndex *index)
+{
+	index->deleted_start = gtk_text_iter_get_offset (start);
+	index->deleted_length = gtk_text_iter_get_offset (end) - index->deleted_start;
+}
+
+static void
+delete_range_after_cb (GtkTextBuffer        *buffer,
+		       GtkTextIter          *start,
+		       GtkTextIter          *end,
+		       GeditOccurrenceIndex *index)
+{
+	gint line_start;
+	gint line_end;
+
+	if (index->regex == NULL)
+	{
+		return;
+	}
+
+	if (!index->complete)
+	{
+		restart_after_edit (index);
+		return;
+	}
+
+	get_line_bounds (buffer, index->deleted_start, &line_start, &line_end);
+
+	update_range (index, line_start, line_end + index->deleted_length, -index->deleted_length);
+	scan_range (index, line_start, line_end);
+
+	index->notify (index->user_data);
+}
+
+GeditOccurrenceIndex *
+gedit_occurrence_index_new (GtkTextBuffer              *buffer,
+			    GeditOccurrenceIndexNotify  notify,
+			    gpointer                    user_data)
+{
+	GeditOccurrenceIndex *index;
+
+	g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+	g_return_val_if_fail (notify != NULL, NULL);
+
+	index = g_slice_new0 (GeditOccurrenceIndex);
+
+	index->buffer = g_object_ref (buffer);
+	index->notify = notify;
+	index->user_data = user_data;
+	index->matches = g_array_new (FALSE, FALSE, sizeof (Match));
+
+	index->insert_text_id =
+		g_signal_connect_after (buffer,
+					"insert-text",
+					G_CALLBACK (insert_text_cb),
+					index);
+
+	index->delete_range_id =
+		g_signal_connect (buffer,
+				  "delete-range",
+				  G_CALLBACK (delete_range_cb),
+				  index);
+
+	index->delete_range_after_id =
+		g_signal_connect_after (buffer,
+					"delete-range",
+					G_CALLBACK (delete_range_after_cb),
+					index);
+
+	return index;
+}
+
+void
+gedit_occurrence_index_free (GeditOccurrenceIndex *index)
+{
+	if (index == NULL)
+	{
+		return;
+	}
+
+	reset (index);
+
+	g_signal_handler_disconnect (index->buffer, index->insert_text_id);
+	g_signal_handler_disconnect (index->buffer, index->delete_range_id);
+	g_signal_handler_disconnect (index->buffer, index->delete_range_after_id);
+
+	g_array_free (index->matches, TRUE);
+	g_object_unref (index->buffer);
+
+	g_slice_free (GeditOccurrenceIndex, index);
+}
+
+/**
+ * gedit_occurrence_index_set_settings:
+ * @index: a #GeditOccurrenceIndex.
+ * @settings: (allow-none): the search settings, or %NULL to clear the index.
+ * @around: where to start the scan.
+ *
+ * Updates the index for @settings. Nothing is done if the search text and
+ * case sensitivity didn't change.
+ *
+ * Returns: %FALSE if @settings is not supported by the index.
+ */
+gboolean
+gedit_occurrence_index_set_settings (GeditOccurrenceIndex    *index,
+				     GtkSourceSearchSettings *settings,
+				     const GtkTextIter       *around)
+{
+	const gchar *text;
+	gboolean case_sensitive;
+	gboolean refine;
+	gchar *escaped;
+	GRegex *regex;
+
+	g_return_val_if_fail (index != NULL, FALSE);
+	g_return_val_if_fail (settings == NULL || GTK_SOURCE_IS_SEARCH_SETTINGS (settings), FALSE);
+	g_return_val_if_fail (around != NULL, FALSE);
+
+	if (settings == NULL)
+	{
+		reset (index);
+		return FALSE;
+	}
+
+	text = gtk_source_search_settings_get_search_text (settings);
+	case_sensitive = gtk_source_search_settings_get_case_sensitive (settings);
+
+	if (text == NULL ||
+	    gtk_source_search_settings_get_regex_enabled (settings) ||
+	    gtk_source_search_settings_get_at_word_boundaries (settings) ||
+	    strpbrk (text, "\r\n") != NULL)
+	{
+		reset (index);
+		return FALSE;
+	}
+
+	if (index->regex != NULL &&
+	    index->case_sensitive == case_sensitive &&
+	    g_strcmp0 (index->text, text) == 0)
+	{
+		return TRUE;
+	}
+
+	escaped = g_regex_escape_string (text, -1);
+	regex = g_regex_new (escaped,
+			     G_REGEX_OPTIMIZE | (case_sensitive ? 0 : G_REGEX_CASELESS),
+			     0,
+			     NULL);
+	g_free (escaped);
+
+	if (regex == NULL)
+	{
+		reset (index);
+		return FALSE;
+	}
+
+	refine = (index->complete &&
+		  index->text != NULL &&
+		  index->case_sensitive == case_sensitive &&
+		  g_str_has_prefix (text, index->text) &&
+		  !has_border (index->text, case_sensitive));
+
+	remove_idle (index);
+
+	if (index->regex != NULL)
+	{
+		g_regex_unref (index->regex);
+	}
+
+	g_free (index->text);
+
+	index->text = g_strdup (text);
+	index->regex = regex;
+	index->text_length = g_utf8_strlen (text, -1);
+	index->case_sensitive = case_sensitive != FALSE;
+
+	if (refine)
+	{
+		gedit_debug_message (DEBUG_VIEW, "Refining %u occurrences",
+				     index->matches->len);
+
+		index->candidates = index->matches;
+		index->next_candidate = 0;
+		index->matches = g_array_new (FALSE, FALSE, sizeof (Match));
+		index->complete = FALSE;
+
+		step (index);
+		install_idle (index);
+	}
+	else
+	{
+		start_scan (index, around);
+	}
+
+	return TRUE;
+}
+
+/**
+ * gedit_occurrence_index_get_count:
+ * @index: a #GeditOccurrenceIndex.
+ * @complete: (out): whether the whole buffer has been scanned.
+ *
+ * Returns: the number of occurrences found so far, or -1 if the index is
+ * not in use.
+ */
+gint
+gedit_occurrence_index_get_count (GeditOccurrenceIndex *index,
+				  gboolean             *complete)
+{
+	g_return_val_if_fail (index != NULL, -1);
+
+	if (complete != NULL)
+	{
+		*complete = index->complete;
+	}
+
+	if (index->regex == NULL)
+	{
+		return -1;
+	}
+
+	return index->matches->len;
+}
+
+/**
+ * gedit_occurrence_index_get_position:
+ * @index: a #GeditOccurrenceIndex.
+ * @match_start: the start of the occurrence.
+ * @match_end: the end of the occurrence.
+ *
+ * Returns: the position of the occurrence, starting at 1, 0 if
+ * [@match_start, @match_end] is not an occurrence, or -1 if the index is
+ * not complete.
+ */
+gint
+gedit_occurrence_index_get_position (GeditOccurrenceIndex *index,
+				     const GtkTextIter    *match_start,
+				     const GtkTextIter    *match_end)
+{
+	gint start;
+	guint i;
+	const Match *match;
+
+	g_return_val_if_fail (index != NULL, -1);
+
+	if (index->regex == NULL || !index->complete)
+	{
+		return -1;
+	}
+
+	start = gtk_text_iter_get_offset (match_start);
+	i = find_first (index->matches, start);
+
+	if (i == index->matches->len)
+	{
+		return 0;
+	}
+
+	match = &g_array_index (index->matches, Match, i);
+
+	if (match->start == start && match->end == gtk_text_iter_get_offset (match_end))
+	{
+		return i + 1;
+	}
+
+	return 0;
+}
+
+/**
+ * gedit_occurrence_index_forward:
+ * @index: a #GeditOccurrenceIndex.
+ * @iter: start of search.
+ * @match_start: (out): return location for start of match.
+ * @match_end: (out): return location for end of match.
+ *
+ * Looks for the next occurrence after @iter, without wrapping around,
+ * in the part of the buffer that has already been scanned.
+ *
+ * Returns: %TRUE if an occurrence has been found.
+ */
+gboolean
+gedit_occurrence_index_forward (GeditOccurrenceIndex *index,
+				const GtkTextIter    *iter,
+				GtkTextIter          *match_start,
+				GtkTextIter          *match_end)
+{
+	gint offset;
+	guint i;
+	const Match *match;
+	gboolean scanned;
+
+	g_return_val_if_fail (index != NULL, FALSE);
+
+	if (index->regex == NULL || index->candidates != NULL)
+	{
+		return FALSE;
+	}
+
+	offset = gtk_text_iter_get_offset (iter);
+	i = find_first (index->matches, offset);
+
+	if (i == index->matches->len)
+	{
+		return FALSE;
+	}
+
+	match = &g_array_index (index->matches, Match, i);
+
+	if (index->complete)
+	{
+		scanned = TRUE;
+	}
+	else if (offset >= index->scan_start)
+	{
+		scanned = index->wrapped || match->start < index->scan_pos;
+	}
+	else
+	{
+		scanned = index->wrapped && match->start < index->scan_pos;
+	}
+
+	if (!scanned)
+	{
+		return FALSE;
+	}
+
+	gtk_text_buffer_get_iter_at_offset (index->buffer, match_start, match->start);
+	gtk_text_buffer_get_iter_at_offset (index->buffer, match_end, match->end);
+
+	return TRUE;
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,62 @@
+/*
+ * gedit-occurrence-index.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GEDIT_OCCURRENCE_INDEX_H__
+#define __GEDIT_OCCURRENCE_INDEX_H__
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GeditOccurrenceIndex GeditOccurrenceIndex;
+
+/* Called from the main loop each time the index has made progress. */
+typedef void (* GeditOccurrenceIndexNotify) (gpointer user_data);
+
+GeditOccurrenceIndex	*gedit_occurrence_index_new		(GtkTextBuffer              *buffer,
+								 GeditOccurrenceIndexNotify  notify,
+								 gpointer                    user_data);
+
+void			 gedit_occurrence_index_free		(GeditOccurrenceIndex       *index);
+
+gboolean		 gedit_occurrence_index_set_settings	(GeditOccurrenceIndex       *index,
+								 GtkSourceSearchSettings    *settings,
+								 const GtkTextIter          *around);
+
+gint			 gedit_occurrence_index_get_count	(GeditOccurrenceIndex       *index,
+								 gboolean                   *complete);
+
+gint			 gedit_occurrence_index_get_position	(GeditOccurrenceIndex       *index,
+								 const GtkTextIter          *match_start,
+								 const GtkTextIter          *match_end);
+
+gboolean		 gedit_occurrence_index_forward		(GeditOccurrenceIndex       *index,
+								 const GtkTextIter          *iter,
+								 GtkTextIter                *match_start,
+								 GtkTextIter                *match_end);
+
+G_END_DECLS
+
+#endif /* __GEDIT_OCCURRENCE_INDEX_H__ */
+
+/* ex:set ts=8 noet: */
@@ -38,6 +38,10 @@
 #include <glib/gi18n.h>
 #include <girepository.h>
 
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
+
 #include "gedit-plugins-engine.h"
 #include "gedit-debug.h"
 #include "gedit-app.h"
@@ -48,25 +52,57 @@
 struct _GeditPluginsEnginePrivate
 {
 	GSettings *plugin_settings;
+
+	guint load_plugins_id;
+
+	guint typelibs_loaded : 1;
+	guint lazy : 1;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeditPluginsEngine, gedit_plugins_engine, PEAS_TYPE_ENGINE)
 
 GeditPluginsEngine *default_engine = NULL;
 
+static gulong
+get_resident_set_size (void)
+{
+	gchar *contents;
+	gchar **fields;
+	gulong rss = 0;
+
+	/* Only used for the debug report, so no need to be portable */
+#ifdef G_OS_UNIX
+	if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+	{
+		return 0;
+	}
+
+	fields = g_strsplit (contents, " ", 3);
+
+	if (fields[0] != NULL && fields[1] != NULL)
+	{
+		rss = g_ascii_strtoull (fields[1], NULL, 10) * (sysconf (_SC_PAGESIZE) / 1024);
+	}
+
+	g_strfreev (fields);
+	g_free (contents);
+#endif
+
+	return rss;
+}
+
 static void
-gedit_plugins_engine_init (GeditPluginsEngine *engine)
+require_typelibs (GeditPluginsEngine *engine)
 {
 	gchar *typelib_dir;
 	GError *error = NULL;
 
-	gedit_debug (DEBUG_PLUGINS);
-
-	engine->priv = gedit_plugins_engine_get_instance_private (engine);
-
-	peas_engine_enable_loader (PEAS_ENGINE (engine), "python3");
+	if (engine->priv->typelibs_loaded)
+	{
+		return;
+	}
 
-	engine->priv->plugin_settings = g_settings_new ("org.gnome.gedit.plugins");
+	engine->priv->typelibs_loaded = TRUE;
 
 	/* Require gedit's typelib. */
 	typelib_dir = g_build_filename (gedit_dirs_get_gedit_lib_dir (),
@@ -99,6 +135,58 @@ gedit_plugins_engine_init (GeditPluginsEngine *engine)
 		g_error_free (error);
 		error = NULL;
 	}
+}
+
+static void
+load_active_plugins (GeditPluginsEngine *engine)
+{
+	GTimer *timer;
+	gulong rss_before;
+
+	timer = g_timer_new ();
+	rss_before = get_resident_set_size ();
+
+	g_settings_bind (engine->priv->plugin_settings,
+	                 GEDIT_SETTINGS_ACTIVE_PLUGINS,
+	                 engine,
+	                 "loaded-plugins",
+	                 G_SETTINGS_BIND_DEFAULT);
+
+	gedit_debug_message (DEBUG_PLUGINS,
+	                     "Active plugins loaded (%s) in %.3f s, RSS %lu kB -> %lu kB",
+	                     engine->priv->lazy ? "lazy" : "eager",
+	                     g_timer_elapsed (timer, NULL),
+	                     rss_before,
+	                     get_resident_set_size ());
+
+	g_timer_destroy (timer);
+}
+
+static gboolean
+load_active_plugins_idle (GeditPluginsEngine *engine)
+{
+	engine->priv->load_plugins_id = 0;
+
+	load_active_plugins (engine);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+gedit_plugins_engine_init (GeditPluginsEngine *engine)
+{
+	gedit_debug (DEBUG_PLUGINS);
+
+	engine->priv = gedit_plugins_engine_get_instance_private (engine);
+
+	/* Enabling a loader is only a flag, the loader module itself (and
+	 * the interpreter with it) is not brought in until a plugin needs it.
+	 */
+	peas_engine_enable_loader (PEAS_ENGINE (engine), "python3");
+
+	engine->priv->plugin_settings = g_settings_new ("org.gnome.gedit.plugins");
+	engine->priv->lazy = g_settings_get_boolean (engine->priv->plugin_settings,
+	                                             GEDIT_SETTINGS_LAZY_PLUGIN_LOADING);
 
 	peas_engine_add_search_path (PEAS_ENGINE (engine),
 	                             gedit_dirs_get_user_plugins_dir (),
@@ -108,11 +196,34 @@ gedit_plugins_engine_init (GeditPluginsEngine *engine)
 	                             gedit_dirs_get_gedit_plugins_dir (),
 	                             gedit_dirs_get_gedit_plugins_data_dir ());
 
-	g_settings_bind (engine->priv->plugin_settings,
-	                 GEDIT_SETTINGS_ACTIVE_PLUGINS,
-	                 engine,
-	                 "loaded-plugins",
-	                 G_SETTINGS_BIND_DEFAULT);
+	if (engine->priv->lazy)
+	{
+		/* Extension sets pick up the plugins when they get loaded, so
+		 * we can wait until the first window had a chance to be drawn.
+		 */
+		engine->priv->load_plugins_id =
+			g_idle_add_full (G_PRIORITY_LOW,
+			                 (GSourceFunc) load_active_plugins_idle,
+			                 engine,
+			                 NULL);
+	}
+	else
+	{
+		require_typelibs (engine);
+		load_active_plugins (engine);
+	}
+}
+
+static void
+gedit_plugins_engine_load_plugin (PeasEngine     *engine,
+                                  PeasPluginInfo *info)
+{
+	gedit_debug_message (DEBUG_PLUGINS, "Loading plugin: %s",
+	                     peas_plugin_info_get_module_name (info));
+
+	require_typelibs (GEDIT_PLUGINS_ENGINE (engine));
+
+	PEAS_ENGINE_CLASS (gedit_plugins_engine_parent_class)->load_plugin (engine, info);
 }
 
 static void
@@ -120,6 +231,12 @@ gedit_plugins_engine_dispose (GObject *object)
 {
 	GeditPluginsEngine *engine = GEDIT_PLUGINS_ENGINE (object);
 
+	if (engine->priv->load_plugins_id != 0)
+	{
+		g_source_remove (engine->priv->load_plugins_id);
+		engine->priv->load_plugins_id = 0;
+	}
+
 	g_clear_object (&engine->priv->plugin_settings);
 
 	G_OBJECT_CLASS (gedit_plugins_engine_parent_class)->dispose (object);
@@ -129,8 +246,11 @@ static void
 gedit_plugins_engine_class_init (GeditPluginsEngineClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	PeasEngineClass *engine_class = PEAS_ENGINE_CLASS (klass);
 
 	object_class->dispose = gedit_plugins_engine_dispose;
+
+	engine_class->load_plugin = gedit_plugins_engine_load_plugin;
 }
 
 GeditPluginsEngine *
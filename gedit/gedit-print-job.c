@@ -44,6 +44,12 @@
 #include "gedit-dirs.h"
 #include "gedit-settings.h"
 
+/* Maximum time spent paginating in one "paginate" emission, in
+ * microseconds. The compositor only lays out a few pages per call, so
+ * without this a long document needs thousands of main loop iterations.
+ */
+#define PAGINATE_TIME_SLICE 10000
+
 struct _GeditPrintJobPrivate
 {
 	GSettings                *print_settings;
@@ -54,6 +60,11 @@ struct _GeditPrintJobPrivate
 	GtkPrintOperation        *operation;
 	GtkSourcePrintCompositor *compositor;
 
+	/* Copy of the document the compositor works on, so the document
+	 * can be edited while the pages are laid out and rendered.
+	 */
+	GtkSourceBuffer          *snapshot;
+
 	GtkPrintSettings         *settings;
 
 	GtkWidget                *preview;
@@ -172,6 +183,7 @@ gedit_print_job_dispose (GObject *object)
 
 	g_clear_object (&job->priv->print_settings);
 	g_clear_object (&job->priv->compositor);
+	g_clear_object (&job->priv->snapshot);
 
 	if (job->priv->operation != NULL)
 	{
@@ -506,6 +518,36 @@ custom_widget_apply_cb (GtkPrintOperation *operation,
 			     wrap_mode);
 }
 
+static GtkSourceBuffer *
+create_snapshot (GeditDocument *doc)
+{
+	GtkSourceBuffer *snapshot;
+	GtkTextIter start;
+	GtkTextIter end;
+	gchar *text;
+
+	snapshot = gtk_source_buffer_new (NULL);
+
+	gtk_source_buffer_set_language (snapshot,
+					gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (doc)));
+	gtk_source_buffer_set_style_scheme (snapshot,
+					    gtk_source_buffer_get_style_scheme (GTK_SOURCE_BUFFER (doc)));
+	gtk_source_buffer_set_highlight_syntax (snapshot,
+						gtk_source_buffer_get_highlight_syntax (GTK_SOURCE_BUFFER (doc)));
+
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+	text = gtk_text_buffer_get_slice (GTK_TEXT_BUFFER (doc), &start, &end, TRUE);
+
+	/* The snapshot is never undone, don't copy the text to its undo stack */
+	gtk_source_buffer_begin_not_undoable_action (snapshot);
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (snapshot), text, -1);
+	gtk_source_buffer_end_not_undoable_action (snapshot);
+
+	g_free (text);
+
+	return snapshot;
+}
+
 static void
 create_compositor (GeditPrintJob *job)
 {
@@ -534,9 +576,12 @@ create_compositor (GeditPrintJob *job)
 	wrap_mode = g_settings_get_enum (job->priv->print_settings,
 					 GEDIT_SETTINGS_PRINT_WRAP_MODE);
 
+	g_clear_object (&job->priv->snapshot);
+	job->priv->snapshot = create_snapshot (job->priv->doc);
+
 	job->priv->compositor = GTK_SOURCE_PRINT_COMPOSITOR (
 					g_object_new (GTK_SOURCE_TYPE_PRINT_COMPOSITOR,
-						     "buffer", GTK_SOURCE_BUFFER (job->priv->doc),
+						     "buffer", job->priv->snapshot,
 						     "tab-width", gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (job->priv->view)),
 						     "highlight-syntax", gtk_source_buffer_get_highlight_syntax (GTK_SOURCE_BUFFER (job->priv->doc)) &&
 									 syntax_hl,
@@ -639,10 +684,17 @@ paginate_cb (GtkPrintOperation *operation,
 	     GeditPrintJob     *job)
 {
 	gboolean res;
+	gint64 start_time;
 
 	job->priv->status = GEDIT_PRINT_JOB_STATUS_PAGINATING;
 
-	res = gtk_source_print_compositor_paginate (job->priv->compositor, context);
+	start_time = g_get_monotonic_time ();
+
+	do
+	{
+		res = gtk_source_print_compositor_paginate (job->priv->compositor, context);
+	}
+	while (!res && g_get_monotonic_time () - start_time < PAGINATE_TIME_SLICE);
 
 	if (res)
 	{
@@ -704,6 +756,8 @@ end_print_cb (GtkPrintOperation *operation,
 		g_object_unref (job->priv->compositor);
 		job->priv->compositor = NULL;
 	}
+
+	g_clear_object (&job->priv->snapshot);
 }
 
 static void
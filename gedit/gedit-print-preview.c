@@ -43,6 +43,22 @@
 
 #define PRINTER_DPI (72.)
 
+/* Upper bound of the memory used by the rendered pages */
+#define PAGE_CACHE_MAX_BYTES (64 * 1024 * 1024)
+
+/* Largest side of a cairo image surface */
+#define MAX_SURFACE_SIZE 32767
+
+#define ZOOM_MAX (8.0)
+
+/* A page rendered at a given zoom */
+typedef struct
+{
+	gint page;
+	double scale;
+	cairo_surface_t *surface;
+} CachedPage;
+
 struct _GeditPrintPreviewPrivate
 {
 	GtkPrintOperation *operation;
@@ -80,6 +96,11 @@ struct _GeditPrintPreviewPrivate
 
 	guint n_pages;
 	guint cur_page;
+
+	/* Rendered pages, the most recently used first */
+	GQueue page_cache;
+	gsize page_cache_bytes;
+	guint render_idle_id;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeditPrintPreview, gedit_print_preview, GTK_TYPE_GRID)
@@ -116,6 +137,43 @@ gedit_print_preview_set_property (GObject      *object,
 	}
 }
 
+static void
+cached_page_free (CachedPage *cached)
+{
+	cairo_surface_destroy (cached->surface);
+	g_slice_free (CachedPage, cached);
+}
+
+static void
+clear_page_cache (GeditPrintPreview *preview)
+{
+	GeditPrintPreviewPrivate *priv = preview->priv;
+	CachedPage *cached;
+
+	while ((cached = g_queue_pop_head (&priv->page_cache)) != NULL)
+	{
+		cached_page_free (cached);
+	}
+
+	priv->page_cache_bytes = 0;
+}
+
+static void
+gedit_print_preview_dispose (GObject *object)
+{
+	GeditPrintPreview *preview = GEDIT_PRINT_PREVIEW (object);
+
+	if (preview->priv->render_idle_id != 0)
+	{
+		g_source_remove (preview->priv->render_idle_id);
+		preview->priv->render_idle_id = 0;
+	}
+
+	clear_page_cache (preview);
+
+	G_OBJECT_CLASS (gedit_print_preview_parent_class)->dispose (object);
+}
+
 static void
 gedit_print_preview_finalize (GObject *object)
 {
@@ -145,6 +203,7 @@ gedit_print_preview_class_init (GeditPrintPreviewClass *klass)
 
 	object_class->get_property = gedit_print_preview_get_property;
 	object_class->set_property = gedit_print_preview_set_property;
+	object_class->dispose = gedit_print_preview_dispose;
 	object_class->finalize = gedit_print_preview_finalize;
 
 	widget_class->grab_focus = gedit_print_preview_grab_focus;
@@ -254,7 +313,7 @@ set_zoom_factor (GeditPrintPreview *preview,
 
 	priv = preview->priv;
 
-	priv->scale = zoom;
+	priv->scale = MIN (zoom, ZOOM_MAX);
 
 	update_tile_size (preview);
 	update_layout_size (preview);
@@ -783,6 +842,16 @@ preview_layout_key_press (GtkWidget         *widget,
 	return ret;
 }
 
+/* The rendered pages are at the scale of the previous screen */
+static void
+preview_layout_scale_factor_changed (GtkWidget         *widget,
+				     GParamSpec        *pspec,
+				     GeditPrintPreview *preview)
+{
+	clear_page_cache (preview);
+	gtk_widget_queue_draw (widget);
+}
+
 static void
 gedit_print_preview_init (GeditPrintPreview *preview)
 {
@@ -851,6 +920,10 @@ gedit_print_preview_init (GeditPrintPreview *preview)
 			  "key-press-event",
 			  G_CALLBACK (preview_layout_key_press),
 			  preview);
+	g_signal_connect (priv->layout,
+			  "notify::scale-factor",
+			  G_CALLBACK (preview_layout_scale_factor_changed),
+			  preview);
 
 	gtk_widget_grab_focus (GTK_WIDGET (priv->layout));
 
@@ -864,21 +937,317 @@ gedit_print_preview_init (GeditPrintPreview *preview)
 	priv->cols = 1;
 }
 
+/* Rendering a page lays it out again through the compositor, so the
+ * rendered pages are kept, the most recently used first, and reused
+ * as long as the zoom does not change.
+ */
+
+static gsize
+page_surface_bytes (cairo_surface_t *surface)
+{
+	return cairo_image_surface_get_stride (surface) *
+	       cairo_image_surface_get_height (surface);
+}
+
 static void
-draw_page_content (cairo_t            *cr,
-		   gint	               page_number,
-		   GeditPrintPreview  *preview)
+get_page_surface_size (GeditPrintPreview *preview,
+		       gint              *width,
+		       gint              *height)
 {
+	*width = MAX (1, ceil (preview->priv->scale * get_paper_width (preview)));
+	*height = MAX (1, ceil (preview->priv->scale * get_paper_height (preview)));
+}
+
+static gsize
+estimate_page_bytes (GeditPrintPreview *preview)
+{
+	gint w, h;
+	gint scale_factor;
+
+	get_page_surface_size (preview, &w, &h);
+	scale_factor = gtk_widget_get_scale_factor (preview->priv->layout);
+
+	return 4 * (gsize) (w * scale_factor) * (gsize) (h * scale_factor);
+}
+
+static gboolean
+is_page_displayed (GeditPrintPreview *preview,
+		   gint               page_number)
+{
+	gint first;
+
+	first = get_first_page_displayed (preview);
+
+	return page_number >= first &&
+	       page_number < first + preview->priv->rows * preview->priv->cols;
+}
+
+/* Whether the pages on screen can all be kept rendered. When they can
+ * not, e.g. at a large zoom, they are drawn directly instead. */
+static gboolean
+can_cache_pages (GeditPrintPreview *preview)
+{
+	GeditPrintPreviewPrivate *priv = preview->priv;
+	gint w, h;
+	gint scale_factor;
+
+	if (!gtk_widget_get_realized (priv->layout))
+		return FALSE;
+
+	get_page_surface_size (preview, &w, &h);
+	scale_factor = gtk_widget_get_scale_factor (priv->layout);
+
+	if (w * scale_factor > MAX_SURFACE_SIZE ||
+	    h * scale_factor > MAX_SURFACE_SIZE)
+	{
+		return FALSE;
+	}
+
+	return priv->rows * priv->cols * estimate_page_bytes (preview) <= PAGE_CACHE_MAX_BYTES;
+}
+
+/* Returns the page rendered at the current zoom or, when exact is FALSE
+ * and there is none, at another zoom. */
+static CachedPage *
+lookup_cached_page (GeditPrintPreview *preview,
+		    gint               page_number,
+		    gboolean           exact)
+{
+	GeditPrintPreviewPrivate *priv = preview->priv;
+	CachedPage *other = NULL;
+	GList *l;
+
+	for (l = priv->page_cache.head; l != NULL; l = l->next)
+	{
+		CachedPage *cached = l->data;
+
+		if (cached->page != page_number)
+			continue;
+
+		if (cached->scale == priv->scale)
+		{
+			g_queue_unlink (&priv->page_cache, l);
+			g_queue_push_head_link (&priv->page_cache, l);
+
+			return cached;
+		}
+
+		if (!exact && other == NULL)
+			other = cached;
+	}
+
+	return other;
+}
+
+static CachedPage *
+render_cached_page (GeditPrintPreview *preview,
+		    gint               page_number)
+{
+	GeditPrintPreviewPrivate *priv = preview->priv;
+	CachedPage *cached;
+	cairo_surface_t *surface;
+	cairo_t *cr;
+	GList *l;
+	gint w, h;
+
+	get_page_surface_size (preview, &w, &h);
+
+	/* Rendered at the scale of the screen for HiDPI */
+	surface = gdk_window_create_similar_image_surface (gtk_layout_get_bin_window (GTK_LAYOUT (priv->layout)),
+							   CAIRO_FORMAT_ARGB32,
+							   w,
+							   h,
+							   gtk_widget_get_scale_factor (priv->layout));
+
+	cr = cairo_create (surface);
+
 	/* scale to the desired size */
-	cairo_scale (cr, preview->priv->scale, preview->priv->scale);
+	cairo_scale (cr, priv->scale, priv->scale);
 
-	gtk_print_context_set_cairo_context (preview->priv->context,
+	gtk_print_context_set_cairo_context (priv->context,
 					     cr,
-					     preview->priv->dpi,
-					     preview->priv->dpi);
+					     priv->dpi,
+					     priv->dpi);
 
-	gtk_print_operation_preview_render_page (preview->priv->gtk_preview,
+	gtk_print_operation_preview_render_page (priv->gtk_preview,
 						 page_number);
+
+	cairo_destroy (cr);
+
+	/* The page rendered at other zooms is not needed anymore */
+	l = priv->page_cache.head;
+
+	while (l != NULL)
+	{
+		GList *next = l->next;
+		CachedPage *old = l->data;
+
+		if (old->page == page_number)
+		{
+			priv->page_cache_bytes -= page_surface_bytes (old->surface);
+			cached_page_free (old);
+			g_queue_delete_link (&priv->page_cache, l);
+		}
+
+		l = next;
+	}
+
+	cached = g_slice_new (CachedPage);
+	cached->page = page_number;
+	cached->scale = priv->scale;
+	cached->surface = surface;
+
+	g_queue_push_head (&priv->page_cache, cached);
+	priv->page_cache_bytes += page_surface_bytes (surface);
+
+	/* The pages on screen are never evicted, they would be rendered
+	 * again right away */
+	l = priv->page_cache.tail;
+
+	while (l != NULL && priv->page_cache_bytes > PAGE_CACHE_MAX_BYTES)
+	{
+		GList *prev = l->prev;
+		CachedPage *old = l->data;
+
+		if (old != cached && !is_page_displayed (preview, old->page))
+		{
+			priv->page_cache_bytes -= page_surface_bytes (old->surface);
+			cached_page_free (old);
+			g_queue_delete_link (&priv->page_cache, l);
+		}
+
+		l = prev;
+	}
+
+	return cached;
+}
+
+static gboolean
+needs_rendering (GeditPrintPreview *preview,
+		 gint               page_number)
+{
+	return page_number >= 0 &&
+	       (guint) page_number < preview->priv->n_pages &&
+	       gtk_print_operation_preview_is_selected (preview->priv->gtk_preview,
+							page_number) &&
+	       lookup_cached_page (preview, page_number, TRUE) == NULL;
+}
+
+/* Returns the next page to render in the background, or -1. The pages
+ * shown at another zoom come first, then the pages of the next and of
+ * the previous screens, as long as they fit in the cache. */
+static gint
+get_page_to_render (GeditPrintPreview *preview)
+{
+	GeditPrintPreviewPrivate *priv = preview->priv;
+	gint first;
+	gint n;
+	gint i;
+
+	if (!can_cache_pages (preview))
+		return -1;
+
+	first = get_first_page_displayed (preview);
+	n = priv->rows * priv->cols;
+
+	for (i = first; i < first + n; ++i)
+	{
+		if (needs_rendering (preview, i))
+			return i;
+	}
+
+	if (priv->page_cache_bytes + estimate_page_bytes (preview) > PAGE_CACHE_MAX_BYTES)
+		return -1;
+
+	for (i = first + n; i < first + 2 * n; ++i)
+	{
+		if (needs_rendering (preview, i))
+			return i;
+	}
+
+	for (i = first - n; i < first; ++i)
+	{
+		if (needs_rendering (preview, i))
+			return i;
+	}
+
+	return -1;
+}
+
+static gboolean
+render_idle (GeditPrintPreview *preview)
+{
+	GeditPrintPreviewPrivate *priv = preview->priv;
+	gint page;
+	gint first;
+
+	page = get_page_to_render (preview);
+
+	if (page < 0)
+	{
+		priv->render_idle_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	render_cached_page (preview, page);
+
+	first = get_first_page_displayed (preview);
+
+	if (page >= first && page < first + priv->rows * priv->cols)
+	{
+		gtk_widget_queue_draw (priv->layout);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+schedule_render (GeditPrintPreview *preview)
+{
+	if (preview->priv->render_idle_id == 0)
+	{
+		preview->priv->render_idle_id =
+			g_idle_add ((GSourceFunc) render_idle, preview);
+	}
+}
+
+static void
+draw_page_content (cairo_t            *cr,
+		   gint	               page_number,
+		   GeditPrintPreview  *preview)
+{
+	GeditPrintPreviewPrivate *priv = preview->priv;
+	CachedPage *cached;
+	double scale;
+
+	if (!can_cache_pages (preview))
+	{
+		/* Only the exposed area is drawn, as the clip is kept */
+		cairo_scale (cr, priv->scale, priv->scale);
+
+		gtk_print_context_set_cairo_context (priv->context,
+						     cr,
+						     priv->dpi,
+						     priv->dpi);
+
+		gtk_print_operation_preview_render_page (priv->gtk_preview,
+							 page_number);
+
+		return;
+	}
+
+	cached = lookup_cached_page (preview, page_number, FALSE);
+
+	/* After a zoom, the page is shown scaled until it is rendered
+	 * again in the background */
+	if (cached == NULL)
+		cached = render_cached_page (preview, page_number);
+
+	scale = priv->scale / cached->scale;
+	cairo_scale (cr, scale, scale);
+
+	cairo_set_source_surface (cr, cached->surface, 0, 0);
+	cairo_paint (cr);
 }
 
 /* For the frame, we scale and rotate manually, since
@@ -980,6 +1349,8 @@ preview_draw (GtkWidget         *widget,
 		}
 
 		cairo_restore (cr);
+
+		schedule_render (preview);
 	}
 
 	return TRUE;
@@ -1032,6 +1403,8 @@ preview_ready (GtkPrintOperationPreview *gtk_preview,
 	/* figure out the dpi */
 	preview->priv->dpi = get_screen_dpi (preview);
 
+	clear_page_cache (preview);
+
 	set_zoom_factor (preview, 1.0);
 
 	/* let the default gtklayout handler clear the background */
@@ -0,0 +1,1041 @@
+/*
+ * gedit-recovery.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+/* Each document has a recovery journal, where its edits are appended as
+ * they are made, so that the unsaved changes are not lost if gedit does
+ * not quit properly. The journal is only created at the first edit, it
+ * is emptied each time the document is loaded or saved, and it is
+ * deleted when the document is closed. The journals that are left are
+ * offered for recovery when gedit starts.
+ *
+ * A journal starts with a header:
+ *   GEDIT-RECOVERY 1
+ *   L <uri>                  the location of the document, if any
+ *   E <charset>              its encoding, if it has a location
+ * followed by what the edits apply to, either the file at the location
+ * (or an empty document) as long as it has as many chars and lines, and
+ * the same text, as
+ *   B <chars> <lines> <sha1 of the text>
+ * or the text of the document itself:
+ *   S <bytes>\n<text>\n
+ * and then the edits, in char offsets:
+ *   I <offset> <bytes>\n<text>\n
+ *   D <start> <end>\n
+ *
+ * The edits are written at most once a second. When they get larger than
+ * the document, the journal is written again with the text of the
+ * document, so that it stays about the size of the document.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include "gedit-recovery.h"
+#include "gedit-app.h"
+#include "gedit-debug.h"
+#include "gedit-dirs.h"
+#include "gedit-encodings.h"
+#include "gedit-tab.h"
+#include "gedit-timer.h"
+
+#define JOURNAL_MAGIC		"GEDIT-RECOVERY 1\n"
+#define JOURNAL_SUFFIX		".journal"
+
+/* In seconds */
+#define FLUSH_TIMEOUT		1
+
+#define COMPACT_MIN_SIZE	(1024 * 1024)
+
+struct _GeditRecoveryJournal
+{
+	GeditDocument *doc;
+
+	GFile *file;
+	GOutputStream *stream;
+
+	/* What was not written yet */
+	GString *pending;
+	guint flush_id;
+
+	/* The size of the edits since the text of the document was
+	 * last written to the journal */
+	gsize edits_size;
+
+	/* The document was loaded from a stream, so the edits can only
+	 * be replayed on its text */
+	guint base_is_text : 1;
+
+	guint started : 1;
+	guint written : 1;
+	guint failed : 1;
+};
+
+typedef struct
+{
+	/* Deleted once its edits are replayed */
+	GFile *journal;
+
+	GFile *location;
+	const GeditEncoding *encoding;
+
+	gint base_chars;
+	gint base_lines;
+	gchar *base_checksum;
+
+	gchar *contents;
+	const gchar *text;
+	gsize text_len;
+	const gchar *edits;
+	const gchar *end;
+} RecoveredDocument;
+
+static guint journal_serial = 0;
+static gboolean offered = FALSE;
+
+static gchar *
+get_recovery_dir (void)
+{
+	return g_build_filename (gedit_dirs_get_user_cache_dir (),
+	                         "recovery",
+	                         NULL);
+}
+
+static gboolean
+ensure_recovery_dir (void)
+{
+	gchar *dir;
+	gboolean ret;
+
+	dir = get_recovery_dir ();
+	ret = g_mkdir_with_parents (dir, 0700) == 0;
+	g_free (dir);
+
+	return ret;
+}
+
+static gint
+get_pid (void)
+{
+#ifdef G_OS_UNIX
+	return getpid ();
+#else
+	return 0;
+#endif
+}
+
+/* The journals are named after the process that writes them */
+static gchar *
+compute_text_checksum (GtkTextBuffer *buffer)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+	gchar *text;
+	gchar *checksum;
+
+	gtk_text_buffer_get_bounds (buffer, &start, &end);
+	text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+
+	checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, text, -1);
+
+	g_free (text);
+
+	return checksum;
+}
+
+static gboolean
+journal_owner_is_running (const gchar *name)
+{
+#ifdef G_OS_UNIX
+	gint pid;
+
+	pid = atoi (name);
+
+	if (pid <= 0)
+		return FALSE;
+
+	if (pid == getpid ())
+		return TRUE;
+
+	return kill (pid, 0) == 0 || errno == EPERM;
+#else
+	return FALSE;
+#endif
+}
+
+static void
+append_header (GeditRecoveryJournal *journal,
+               GString              *out,
+               gboolean              with_text)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (journal->doc);
+	GFile *location;
+
+	g_string_append (out, JOURNAL_MAGIC);
+
+	location = gedit_document_get_location (journal->doc);
+
+	if (location != NULL)
+	{
+		gchar *uri;
+
+		uri = g_file_get_uri (location);
+		g_string_append_printf (out, "L %s\n", uri);
+		g_string_append_printf (out, "E %s\n",
+		                        gedit_encoding_get_charset (gedit_document_get_encoding (journal->doc)));
+
+		g_free (uri);
+		g_object_unref (location);
+	}
+
+	if (with_text)
+	{
+		GtkTextIter start;
+		GtkTextIter end;
+		gchar *text;
+		gsize len;
+
+		gtk_text_buffer_get_bounds (buffer, &start, &end);
+		text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+		len = strlen (text);
+
+		g_string_append_printf (out, "S %" G_GSIZE_FORMAT "\n", len);
+		g_string_append_len (out, text, len);
+		g_string_append_c (out, '\n');
+
+		g_free (text);
+	}
+	else
+	{
+		gchar *checksum;
+
+		/* A file changed to the same size must not get the edits */
+		checksum = compute_text_checksum (buffer);
+
+		g_string_append_printf (out, "B %d %d %s\n",
+		                        gtk_text_buffer_get_char_count (buffer),
+		                        gtk_text_buffer_get_line_count (buffer),
+		                        checksum);
+
+		g_free (checksum);
+	}
+}
+
+static void
+journal_failed (GeditRecoveryJournal *journal,
+                GError               *error)
+{
+	g_warning ("Could not write the recovery journal: %s", error->message);
+	g_error_free (error);
+
+	journal->failed = TRUE;
+	g_string_truncate (journal->pending, 0);
+}
+
+/* Writes the journal again, with the text of the document instead of the
+ * edits, since they got larger than the document. */
+static void
+compact_journal (GeditRecoveryJournal *journal)
+{
+	GString *contents;
+	GError *error = NULL;
+
+	gedit_debug (DEBUG_SESSION);
+
+	if (journal->stream != NULL)
+	{
+		g_output_stream_close (journal->stream, NULL, NULL);
+		g_clear_object (&journal->stream);
+	}
+
+	contents = g_string_new (NULL);
+	append_header (journal, contents, TRUE);
+
+	journal->written = TRUE;
+	journal->edits_size = 0;
+	g_string_truncate (journal->pending, 0);
+
+	if (g_file_replace_contents (journal->file,
+	                             contents->str,
+	                             contents->len,
+	                             NULL,
+	                             FALSE,
+	                             G_FILE_CREATE_PRIVATE,
+	                             NULL,
+	                             NULL,
+	                             &error))
+	{
+		journal->stream = G_OUTPUT_STREAM (g_file_append_to (journal->file,
+		                                                     G_FILE_CREATE_PRIVATE,
+		                                                     NULL,
+		                                                     &error));
+	}
+
+	if (error != NULL)
+	{
+		journal_failed (journal, error);
+	}
+
+	g_string_free (contents, TRUE);
+}
+
+static gboolean
+flush_journal (GeditRecoveryJournal *journal)
+{
+	GError *error = NULL;
+	gsize char_count;
+
+	journal->flush_id = 0;
+
+	if (journal->failed || journal->pending->len == 0)
+		return G_SOURCE_REMOVE;
+
+	char_count = gtk_text_buffer_get_char_count (GTK_TEXT_BUFFER (journal->doc));
+
+	if (journal->edits_size > MAX (COMPACT_MIN_SIZE, 2 * char_count))
+	{
+		if (ensure_recovery_dir ())
+			compact_journal (journal);
+
+		return G_SOURCE_REMOVE;
+	}
+
+	if (journal->stream == NULL)
+	{
+		ensure_recovery_dir ();
+
+		journal->stream = G_OUTPUT_STREAM (g_file_replace (journal->file,
+		                                                   NULL,
+		                                                   FALSE,
+		                                                   G_FILE_CREATE_PRIVATE,
+		                                                   NULL,
+		                                                   &error));
+		journal->written = TRUE;
+	}
+
+	if (journal->stream == NULL ||
+	    !g_output_stream_write_all (journal->stream,
+	                                journal->pending->str,
+	                                journal->pending->len,
+	                                NULL,
+	                                NULL,
+	                                &error) ||
+	    !g_output_stream_flush (journal->stream, NULL, &error))
+	{
+		journal_failed (journal, error);
+		return G_SOURCE_REMOVE;
+	}
+
+	g_string_truncate (journal->pending, 0);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+record_edit (GeditRecoveryJournal *journal)
+{
+	if (journal->flush_id == 0)
+	{
+		journal->flush_id = _gedit_timer_add_seconds (FLUSH_TIMEOUT,
+		                                              (GSourceFunc) flush_journal,
+		                                              journal);
+	}
+}
+
+/* Returns whether the edit has to be recorded, starting the journal at
+ * the first one. Must be called before the edit is made. */
+static gboolean
+begin_edit (GeditRecoveryJournal *journal)
+{
+	if (journal->failed || _gedit_document_is_loading (journal->doc))
+		return FALSE;
+
+	if (!journal->started)
+	{
+		append_header (journal, journal->pending, journal->base_is_text);
+		journal->started = TRUE;
+	}
+
+	return TRUE;
+}
+
+static void
+insert_text_cb (GtkTextBuffer        *buffer,
+                GtkTextIter          *location,
+                const gchar          *text,
+                gint                  len,
+                GeditRecoveryJournal *journal)
+{
+	if (!begin_edit (journal))
+		return;
+
+	g_string_append_printf (journal->pending, "I %d %d\n",
+	                        gtk_text_iter_get_offset (location),
+	                        len);
+	g_string_append_len (journal->pending, text, len);
+	g_string_append_c (journal->pending, '\n');
+
+	journal->edits_size += len;
+
+	record_edit (journal);
+}
+
+static void
+delete_range_cb (GtkTextBuffer        *buffer,
+                 GtkTextIter          *start,
+                 GtkTextIter          *end,
+                 GeditRecoveryJournal *journal)
+{
+	gint start_offset;
+	gint end_offset;
+
+	if (!begin_edit (journal))
+		return;
+
+	start_offset = gtk_text_iter_get_offset (start);
+	end_offset = gtk_text_iter_get_offset (end);
+
+	g_string_append_printf (journal->pending, "D %d %d\n",
+	                        MIN (start_offset, end_offset),
+	                        MAX (start_offset, end_offset));
+
+	journal->edits_size += ABS (end_offset - start_offset);
+
+	record_edit (journal);
+}
+
+/* Deletes the journal. It starts again at the next edit. */
+static void
+reset_journal (GeditRecoveryJournal *journal)
+{
+	if (journal->flush_id != 0)
+	{
+		_gedit_timer_remove (journal->flush_id);
+		journal->flush_id = 0;
+	}
+
+	if (journal->stream != NULL)
+	{
+		g_output_stream_close (journal->stream, NULL, NULL);
+		g_clear_object (&journal->stream);
+	}
+
+	if (journal->written)
+	{
+		g_file_delete (journal->file, NULL, NULL);
+	}
+
+	g_string_truncate (journal->pending, 0);
+	journal->edits_size = 0;
+
+	journal->started = FALSE;
+	journal->written = FALSE;
+	journal->failed = FALSE;
+
+	journal->base_is_text =
+		gedit_document_is_untitled (journal->doc) &&
+		gtk_text_buffer_get_char_count (GTK_TEXT_BUFFER (journal->doc)) > 0;
+}
+
+static void
+document_loaded_cb (GeditDocument        *doc,
+                    const GError         *error,
+                    GeditRecoveryJournal *journal)
+{
+	reset_journal (journal);
+}
+
+static void
+document_saved_cb (GeditDocument        *doc,
+                   const GError         *error,
+                   GeditRecoveryJournal *journal)
+{
+	if (error == NULL)
+	{
+		reset_journal (journal);
+	}
+}
+
+GeditRecoveryJournal *
+_gedit_recovery_journal_new (GeditDocument *doc)
+{
+	GeditRecoveryJournal *journal;
+	gchar *dir;
+	gchar *name;
+	gchar *path;
+
+	g_return_val_if_fail (GEDIT_IS_DOCUMENT (doc), NULL);
+
+	journal = g_slice_new0 (GeditRecoveryJournal);
+	journal->doc = g_object_ref (doc);
+	journal->pending = g_string_new (NULL);
+
+	dir = get_recovery_dir ();
+	name = g_strdup_printf ("%d-%u-%08x" JOURNAL_SUFFIX,
+	                        get_pid (),
+	                        ++journal_serial,
+	                        g_random_int ());
+	path = g_build_filename (dir, name, NULL);
+
+	journal->file = g_file_new_for_path (path);
+
+	g_free (dir);
+	g_free (name);
+	g_free (path);
+
+	g_signal_connect (doc,
+	                  "insert-text",
+	                  G_CALLBACK (insert_text_cb),
+	                  journal);
+	g_signal_connect (doc,
+	                  "delete-range",
+	                  G_CALLBACK (delete_range_cb),
+	                  journal);
+	g_signal_connect (doc,
+	                  "loaded",
+	                  G_CALLBACK (document_loaded_cb),
+	                  journal);
+	g_signal_connect (doc,
+	                  "saved",
+	                  G_CALLBACK (document_saved_cb),
+	                  journal);
+
+	return journal;
+}
+
+/* The document was closed: its journal is not needed anymore */
+void
+_gedit_recovery_journal_free (GeditRecoveryJournal *journal)
+{
+	if (journal == NULL)
+		return;
+
+	g_signal_handlers_disconnect_by_data (journal->doc, journal);
+
+	reset_journal (journal);
+
+	g_string_free (journal->pending, TRUE);
+	g_object_unref (journal->file);
+	g_object_unref (journal->doc);
+
+	g_slice_free (GeditRecoveryJournal, journal);
+}
+
+/* Recovery */
+
+static void
+recovered_document_free (RecoveredDocument *recovered)
+{
+	if (recovered->location != NULL)
+		g_object_unref (recovered->location);
+
+	if (recovered->journal != NULL)
+		g_object_unref (recovered->journal);
+
+	g_free (recovered->base_checksum);
+	g_free (recovered->contents);
+	g_slice_free (RecoveredDocument, recovered);
+}
+
+/* Returns the next line, without the newline, or NULL if there is no
+ * complete line left */
+static gchar *
+read_line (const gchar **p,
+           const gchar  *end)
+{
+	const gchar *nl;
+	gchar *line;
+
+	nl = memchr (*p, '\n', end - *p);
+
+	if (nl == NULL)
+		return NULL;
+
+	line = g_strndup (*p, nl - *p);
+	*p = nl + 1;
+
+	return line;
+}
+
+/* Reads the text of a record, followed by a newline */
+static gboolean
+read_text (const gchar **p,
+           const gchar  *end,
+           gsize         len)
+{
+	if ((gsize) (end - *p) < len + 1 || (*p)[len] != '\n')
+		return FALSE;
+
+	*p += len + 1;
+
+	return TRUE;
+}
+
+static RecoveredDocument *
+parse_journal (gchar *contents,
+               gsize  length)
+{
+	RecoveredDocument *recovered;
+	const gchar *p;
+	const gchar *end;
+
+	if (!g_str_has_prefix (contents, JOURNAL_MAGIC))
+	{
+		g_free (contents);
+		return NULL;
+	}
+
+	recovered = g_slice_new0 (RecoveredDocument);
+	recovered->contents = contents;
+	recovered->base_chars = -1;
+
+	p = contents + strlen (JOURNAL_MAGIC);
+	end = contents + length;
+
+	/* The header ends with what the edits apply to */
+	while (recovered->base_chars < 0 && recovered->text == NULL)
+	{
+		gchar *line;
+		gsize len;
+		gboolean valid = TRUE;
+
+		line = read_line (&p, end);
+
+		if (line == NULL)
+		{
+			recovered_document_free (recovered);
+			return NULL;
+		}
+
+		if (g_str_has_prefix (line, "L "))
+		{
+			recovered->location = g_file_new_for_uri (line + 2);
+		}
+		else if (g_str_has_prefix (line, "E "))
+		{
+			recovered->encoding = gedit_encoding_get_from_charset (line + 2);
+		}
+		else if (g_str_has_prefix (line, "B "))
+		{
+			gchar checksum[41];
+
+			valid = sscanf (line, "B %d %d %40s",
+			                &recovered->base_chars,
+			                &recovered->base_lines,
+			                checksum) == 3 &&
+			        recovered->base_chars >= 0;
+
+			if (valid)
+			{
+				recovered->base_checksum = g_strdup (checksum);
+			}
+		}
+		else if (g_str_has_prefix (line, "S "))
+		{
+			valid = sscanf (line, "S %" G_GSIZE_FORMAT, &len) == 1 &&
+			        read_text (&p, end, len);
+
+			if (valid)
+			{
+				recovered->text = p - len - 1;
+				recovered->text_len = len;
+			}
+		}
+		else
+		{
+			valid = FALSE;
+		}
+
+		g_free (line);
+
+		if (!valid)
+		{
+			recovered_document_free (recovered);
+			return NULL;
+		}
+	}
+
+	recovered->edits = p;
+	recovered->end = end;
+
+	return recovered;
+}
+
+/* Replays the edits, stopping at the first one that does not apply,
+ * which can only be the last one, if it was not completely written.
+ * Returns FALSE if the edits do not apply to the document at all. */
+static gboolean
+replay_edits (GeditDocument     *doc,
+              RecoveredDocument *recovered)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (doc);
+	const gchar *p;
+
+	gedit_debug (DEBUG_SESSION);
+
+	if (recovered->text != NULL)
+	{
+		gtk_text_buffer_set_text (buffer, recovered->text, recovered->text_len);
+	}
+	else
+	{
+		gboolean changed;
+
+		changed = gtk_text_buffer_get_char_count (buffer) != recovered->base_chars ||
+		          gtk_text_buffer_get_line_count (buffer) != recovered->base_lines;
+
+		if (!changed)
+		{
+			gchar *checksum;
+
+			checksum = compute_text_checksum (buffer);
+			changed = g_strcmp0 (checksum, recovered->base_checksum) != 0;
+			g_free (checksum);
+		}
+
+		if (changed)
+		{
+			g_warning ("The file changed since gedit quit, "
+			           "its unsaved changes cannot be recovered");
+			return FALSE;
+		}
+	}
+
+	p = recovered->edits;
+
+	while (p < recovered->end)
+	{
+		GtkTextIter start;
+		GtkTextIter end;
+		gchar *line;
+		gint a;
+		gint b;
+
+		line = read_line (&p, recovered->end);
+
+		if (line == NULL)
+			break;
+
+		if (sscanf (line, "I %d %d", &a, &b) == 2 &&
+		    a >= 0 && a <= gtk_text_buffer_get_char_count (buffer) &&
+		    b >= 0 && read_text (&p, recovered->end, b) &&
+		    g_utf8_validate (p - b - 1, b, NULL))
+		{
+			gtk_text_buffer_get_iter_at_offset (buffer, &start, a);
+			gtk_text_buffer_insert (buffer, &start, p - b - 1, b);
+		}
+		else if (sscanf (line, "D %d %d", &a, &b) == 2 &&
+		         a >= 0 && a <= b && b <= gtk_text_buffer_get_char_count (buffer))
+		{
+			gtk_text_buffer_get_iter_at_offset (buffer, &start, a);
+			gtk_text_buffer_get_iter_at_offset (buffer, &end, b);
+			gtk_text_buffer_delete (buffer, &start, &end);
+		}
+		else
+		{
+			g_free (line);
+			break;
+		}
+
+		g_free (line);
+	}
+
+	return TRUE;
+}
+
+/* The journal is kept until its edits are replayed, so that they are
+ * offered again if the file could not be loaded */
+static void
+replay_journal (GeditDocument     *doc,
+                RecoveredDocument *recovered)
+{
+	if (replay_edits (doc, recovered))
+	{
+		g_file_delete (recovered->journal, NULL, NULL);
+	}
+}
+
+static void
+recovered_document_loaded_cb (GeditDocument     *doc,
+                              const GError      *error,
+                              RecoveredDocument *recovered)
+{
+	if (error == NULL)
+	{
+		replay_journal (doc, recovered);
+	}
+
+	/* Frees recovered */
+	g_signal_handlers_disconnect_by_func (doc,
+	                                      recovered_document_loaded_cb,
+	                                      recovered);
+}
+
+static GeditTab *
+get_tab_from_location (GFile *location)
+{
+	GeditTab *tab = NULL;
+	GList *docs;
+	GList *l;
+
+	docs = gedit_app_get_documents (GEDIT_APP (g_application_get_default ()));
+
+	for (l = docs; l != NULL; l = l->next)
+	{
+		GFile *doc_location;
+
+		doc_location = gedit_document_get_location (l->data);
+
+		if (doc_location != NULL)
+		{
+			if (g_file_equal (doc_location, location))
+			{
+				tab = gedit_tab_get_from_document (l->data);
+			}
+
+			g_object_unref (doc_location);
+		}
+
+		if (tab != NULL)
+			break;
+	}
+
+	g_list_free (docs);
+
+	return tab;
+}
+
+static void
+recover_journal (GeditWindow *window,
+                 GFile       *file)
+{
+	RecoveredDocument *recovered;
+	GeditTab *tab;
+	gchar *contents;
+	gsize length;
+
+	if (!g_file_load_contents (file, NULL, &contents, &length, NULL, NULL))
+		return;
+
+	recovered = parse_journal (contents, length);
+
+	/* There is nothing to recover from it */
+	if (recovered == NULL)
+	{
+		g_file_delete (file, NULL, NULL);
+		return;
+	}
+
+	recovered->journal = g_object_ref (file);
+
+	/* The file may have been opened already, e.g. from the command line */
+	tab = recovered->location != NULL ? get_tab_from_location (recovered->location) : NULL;
+
+	if (tab != NULL && gedit_tab_get_state (tab) != GEDIT_TAB_STATE_LOADING)
+	{
+		/* The edits are only replayed if it was not changed */
+		replay_journal (gedit_tab_get_document (tab), recovered);
+		recovered_document_free (recovered);
+	}
+	else if (recovered->location != NULL)
+	{
+		/* The edits are replayed once the file is loaded */
+		if (tab == NULL)
+		{
+			tab = gedit_window_create_tab_from_location (window,
+			                                             recovered->location,
+			                                             recovered->encoding,
+			                                             0,
+			                                             0,
+			                                             FALSE,
+			                                             FALSE);
+		}
+
+		if (tab == NULL)
+		{
+			recovered_document_free (recovered);
+			return;
+		}
+
+		g_signal_connect_data (gedit_tab_get_document (tab),
+		                       "loaded",
+		                       G_CALLBACK (recovered_document_loaded_cb),
+		                       recovered,
+		                       (GClosureNotify) recovered_document_free,
+		                       G_CONNECT_AFTER);
+	}
+	else
+	{
+		tab = gedit_window_create_tab (window, FALSE);
+
+		replay_journal (gedit_tab_get_document (tab), recovered);
+		recovered_document_free (recovered);
+	}
+}
+
+static GList *
+get_stale_journals (void)
+{
+	GList *journals = NULL;
+	gchar *dir_path;
+	GDir *dir;
+	const gchar *name;
+
+	dir_path = get_recovery_dir ();
+	dir = g_dir_open (dir_path, 0, NULL);
+
+	if (dir == NULL)
+	{
+		g_free (dir_path);
+		return NULL;
+	}
+
+	while ((name = g_dir_read_name (dir)) != NULL)
+	{
+		gchar *path;
+
+		if (!g_str_has_suffix (name, JOURNAL_SUFFIX) ||
+		    journal_owner_is_running (name))
+		{
+			continue;
+		}
+
+		path = g_build_filename (dir_path, name, NULL);
+		journals = g_list_prepend (journals, g_file_new_for_path (path));
+		g_free (path);
+	}
+
+	g_dir_close (dir);
+	g_free (dir_path);
+
+	return journals;
+}
+
+static void
+free_journals (GList *journals)
+{
+	g_list_free_full (journals, g_object_unref);
+}
+
+static void
+offer_response_cb (GtkDialog   *dialog,
+                   gint         response_id,
+                   GeditWindow *window)
+{
+	GList *journals;
+	GList *l;
+
+	journals = g_object_get_data (G_OBJECT (dialog), "gedit-recovery-journals");
+
+	/* If the question was not answered, it is asked again next time */
+	if (response_id == GTK_RESPONSE_ACCEPT ||
+	    response_id == GTK_RESPONSE_REJECT)
+	{
+		for (l = journals; l != NULL; l = l->next)
+		{
+			GFile *file = l->data;
+
+			/* A recovered journal is deleted once its edits
+			 * are replayed */
+			if (response_id == GTK_RESPONSE_ACCEPT)
+			{
+				recover_journal (window, file);
+			}
+			else
+			{
+				g_file_delete (file, NULL, NULL);
+			}
+		}
+	}
+
+	gtk_widget_destroy (GTK_WIDGET (dialog));
+}
+
+/* Asks whether to recover the documents of the journals left by a gedit
+ * that did not quit properly. Only done once, when gedit starts. */
+void
+_gedit_recovery_offer (GeditWindow *window)
+{
+	GList *journals;
+	GtkWidget *dialog;
+	guint n_journals;
+
+	g_return_if_fail (GEDIT_IS_WINDOW (window));
+
+	if (offered)
+		return;
+
+	offered = TRUE;
+
+	journals = get_stale_journals ();
+
+	if (journals == NULL)
+		return;
+
+	n_journals = g_list_length (journals);
+
+	dialog = gtk_message_dialog_new (GTK_WINDOW (window),
+	                                 GTK_DIALOG_DESTROY_WITH_PARENT,
+	                                 GTK_MESSAGE_QUESTION,
+	                                 GTK_BUTTONS_NONE,
+	                                 ngettext ("gedit did not quit properly. Recover the unsaved changes of %u document?",
+	                                           "gedit did not quit properly. Recover the unsaved changes of %u documents?",
+	                                           n_journals),
+	                                 n_journals);
+
+	gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+	                                          _("The changes that are not recovered are lost."));
+
+	gtk_dialog_add_buttons (GTK_DIALOG (dialog),
+	                        _("_Discard"), GTK_RESPONSE_REJECT,
+	                        _("_Recover"), GTK_RESPONSE_ACCEPT,
+	                        NULL);
+
+	gtk_dialog_set_default_response (GTK_DIALOG (dialog), GTK_RESPONSE_ACCEPT);
+
+	g_object_set_data_full (G_OBJECT (dialog),
+	                        "gedit-recovery-journals",
+	                        journals,
+	                        (GDestroyNotify) free_journals);
+
+	g_signal_connect (dialog,
+	                  "response",
+	                  G_CALLBACK (offer_response_cb),
+	                  window);
+
+	gtk_widget_show (dialog);
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,42 @@
+/*
+ * gedit-recovery.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GEDIT_RECOVERY_H__
+#define __GEDIT_RECOVERY_H__
+
+#include "gedit-document.h"
+#include "gedit-window.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GeditRecoveryJournal GeditRecoveryJournal;
+
+GeditRecoveryJournal	*_gedit_recovery_journal_new	(GeditDocument        *doc);
+void			 _gedit_recovery_journal_free	(GeditRecoveryJournal *journal);
+
+void			 _gedit_recovery_offer		(GeditWindow          *window);
+
+G_END_DECLS
+
+#endif /* __GEDIT_RECOVERY_H__ */
+
+/* ex:set ts=8 noet: */
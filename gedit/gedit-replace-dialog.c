@@ -49,6 +49,8 @@ struct _GeditReplaceDialogPrivate
 	GtkWidget *regex_checkbutton;
 	GtkWidget *backwards_checkbutton;
 	GtkWidget *wrap_around_checkbutton;
+	GtkWidget *all_documents_checkbutton;
+	GtkWidget *browser_root_checkbutton;
 
 	GeditDocument *active_document;
 
@@ -540,6 +542,8 @@ gedit_replace_dialog_class_init (GeditReplaceDialogClass *klass)
 	gtk_widget_class_bind_template_child_private (widget_class, GeditReplaceDialog, regex_checkbutton);
 	gtk_widget_class_bind_template_child_private (widget_class, GeditReplaceDialog, backwards_checkbutton);
 	gtk_widget_class_bind_template_child_private (widget_class, GeditReplaceDialog, wrap_around_checkbutton);
+	gtk_widget_class_bind_template_child_private (widget_class, GeditReplaceDialog, all_documents_checkbutton);
+	gtk_widget_class_bind_template_child_private (widget_class, GeditReplaceDialog, browser_root_checkbutton);
 }
 
 static void
@@ -706,6 +710,12 @@ gedit_replace_dialog_init (GeditReplaceDialog *dlg)
 			  G_CALLBACK (replace_text_entry_changed),
 			  dlg);
 
+	g_object_bind_property (dlg->priv->all_documents_checkbutton,
+				"active",
+				dlg->priv->browser_root_checkbutton,
+				"sensitive",
+				G_BINDING_SYNC_CREATE);
+
 	g_signal_connect (dlg,
 			  "show",
 			  G_CALLBACK (show_cb),
@@ -756,6 +766,23 @@ gedit_replace_dialog_get_backwards (GeditReplaceDialog *dialog)
 	return gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (dialog->priv->backwards_checkbutton));
 }
 
+gboolean
+gedit_replace_dialog_get_all_documents (GeditReplaceDialog *dialog)
+{
+	g_return_val_if_fail (GEDIT_IS_REPLACE_DIALOG (dialog), FALSE);
+
+	return gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (dialog->priv->all_documents_checkbutton));
+}
+
+gboolean
+gedit_replace_dialog_get_include_browser_root (GeditReplaceDialog *dialog)
+{
+	g_return_val_if_fail (GEDIT_IS_REPLACE_DIALOG (dialog), FALSE);
+
+	return gedit_replace_dialog_get_all_documents (dialog) &&
+	       gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (dialog->priv->browser_root_checkbutton));
+}
+
 /* This function returns the original search text. The search text from the
  * search settings has been unescaped, and the escape function is not
  * reciprocal. So to avoid bugs, we have to deal with the original search text.
@@ -97,6 +97,10 @@ const gchar		*gedit_replace_dialog_get_replace_text		(GeditReplaceDialog *dialog
 
 gboolean		 gedit_replace_dialog_get_backwards		(GeditReplaceDialog *dialog);
 
+gboolean		 gedit_replace_dialog_get_all_documents		(GeditReplaceDialog *dialog);
+
+gboolean		 gedit_replace_dialog_get_include_browser_root	(GeditReplaceDialog *dialog);
+
 void			 gedit_replace_dialog_set_replace_error		(GeditReplaceDialog *dialog,
 									 const gchar        *error_msg);
 
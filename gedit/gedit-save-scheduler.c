@@ -0,0 +1,361 @@
+/*
+ * gedit-save-scheduler.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+/* All the savers go through the save scheduler, which only lets a limited
+ * number of them run at the same time ("max-concurrent-saves"), so that
+ * saving many documents at once, with Save All or the autosave, does not
+ * flood the disk or the network.
+ *
+ * The pending savers are grouped by the directory of their file, and the
+ * directories take turns, so that a lot of files in one directory do not
+ * hold up the others. Until the first save of a directory completes, the
+ * other saves of that directory wait: if the volume has to be mounted
+ * only the first save does it, and the others find it mounted.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gedit-save-scheduler.h"
+#include "gedit-marshal.h"
+#include "gedit-settings.h"
+#include "gedit-debug.h"
+
+typedef struct
+{
+	gchar  *uri;
+
+	/* The savers waiting for their turn, with a reference */
+	GQueue  pending;
+
+	guint   n_running;
+	guint   first_done : 1;
+} Directory;
+
+struct _GeditSaveSchedulerPrivate
+{
+	GSettings  *editor_settings;
+
+	/* uri -> Directory */
+	GHashTable *directories;
+
+	/* The directories with pending savers come first in the order
+	 * they get their turn */
+	GQueue      rotation;
+
+	/* GeditDocumentSaver -> Directory, with a reference */
+	GHashTable *running;
+
+	guint       n_saved;
+	guint       n_total;
+
+	guint       schedule_id;
+};
+
+enum
+{
+	PROGRESS,
+	LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE_WITH_PRIVATE (GeditSaveScheduler, gedit_save_scheduler, G_TYPE_OBJECT)
+
+static void
+directory_free (Directory *dir)
+{
+	g_queue_foreach (&dir->pending, (GFunc) g_object_unref, NULL);
+	g_queue_clear (&dir->pending);
+
+	g_free (dir->uri);
+	g_slice_free (Directory, dir);
+}
+
+static void
+gedit_save_scheduler_dispose (GObject *object)
+{
+	GeditSaveSchedulerPrivate *priv = GEDIT_SAVE_SCHEDULER (object)->priv;
+
+	if (priv->schedule_id != 0)
+	{
+		g_source_remove (priv->schedule_id);
+		priv->schedule_id = 0;
+	}
+
+	g_queue_clear (&priv->rotation);
+
+	if (priv->running != NULL)
+	{
+		g_hash_table_destroy (priv->running);
+		priv->running = NULL;
+	}
+
+	if (priv->directories != NULL)
+	{
+		g_hash_table_destroy (priv->directories);
+		priv->directories = NULL;
+	}
+
+	g_clear_object (&priv->editor_settings);
+
+	G_OBJECT_CLASS (gedit_save_scheduler_parent_class)->dispose (object);
+}
+
+static void
+gedit_save_scheduler_class_init (GeditSaveSchedulerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gedit_save_scheduler_dispose;
+
+	/* Emitted each time a save is added or completes. @n_total counts
+	 * the saves since the scheduler was last idle. */
+	signals[PROGRESS] =
+		g_signal_new ("progress",
+			      G_OBJECT_CLASS_TYPE (object_class),
+			      G_SIGNAL_RUN_LAST,
+			      G_STRUCT_OFFSET (GeditSaveSchedulerClass, progress),
+			      NULL, NULL,
+			      gedit_marshal_VOID__UINT_UINT,
+			      G_TYPE_NONE,
+			      2,
+			      G_TYPE_UINT,
+			      G_TYPE_UINT);
+}
+
+static void
+gedit_save_scheduler_init (GeditSaveScheduler *scheduler)
+{
+	scheduler->priv = gedit_save_scheduler_get_instance_private (scheduler);
+
+	scheduler->priv->editor_settings = g_settings_new ("org.gnome.gedit.preferences.editor");
+
+	scheduler->priv->directories = g_hash_table_new_full (g_str_hash,
+							      g_str_equal,
+							      NULL,
+							      (GDestroyNotify) directory_free);
+
+	scheduler->priv->running = g_hash_table_new_full (g_direct_hash,
+							  g_direct_equal,
+							  g_object_unref,
+							  NULL);
+
+	g_queue_init (&scheduler->priv->rotation);
+}
+
+GeditSaveScheduler *
+_gedit_save_scheduler_get_default (void)
+{
+	static GeditSaveScheduler *default_scheduler = NULL;
+
+	if (G_UNLIKELY (default_scheduler == NULL))
+	{
+		default_scheduler = g_object_new (GEDIT_TYPE_SAVE_SCHEDULER, NULL);
+
+		g_object_add_weak_pointer (G_OBJECT (default_scheduler),
+		                           (gpointer) &default_scheduler);
+	}
+
+	return default_scheduler;
+}
+
+/* Finds the directory that can start a save, and gives it its turn */
+static Directory *
+next_directory (GeditSaveScheduler *scheduler)
+{
+	GList *l;
+
+	for (l = scheduler->priv->rotation.head; l != NULL; l = l->next)
+	{
+		Directory *dir = l->data;
+
+		if (!g_queue_is_empty (&dir->pending) &&
+		    (dir->first_done || dir->n_running == 0))
+		{
+			g_queue_unlink (&scheduler->priv->rotation, l);
+			g_queue_push_tail_link (&scheduler->priv->rotation, l);
+
+			return dir;
+		}
+	}
+
+	return NULL;
+}
+
+static gboolean
+schedule (GeditSaveScheduler *scheduler)
+{
+	GeditSaveSchedulerPrivate *priv = scheduler->priv;
+	guint max_running;
+
+	priv->schedule_id = 0;
+
+	max_running = g_settings_get_uint (priv->editor_settings,
+					   GEDIT_SETTINGS_MAX_CONCURRENT_SAVES);
+
+	while (g_hash_table_size (priv->running) < MAX (max_running, 1))
+	{
+		GeditDocumentSaver *saver;
+		Directory *dir;
+
+		dir = next_directory (scheduler);
+
+		if (dir == NULL)
+			break;
+
+		saver = g_queue_pop_head (&dir->pending);
+		dir->n_running++;
+
+		gedit_debug_message (DEBUG_SAVER, "Start save in %s", dir->uri);
+
+		/* The reference goes to the running table */
+		g_hash_table_insert (priv->running, saver, dir);
+
+		_gedit_document_saver_start (saver);
+	}
+
+	return FALSE;
+}
+
+static void
+queue_schedule (GeditSaveScheduler *scheduler)
+{
+	/* Savers are always started from the main loop, like they were
+	 * before there was a scheduler */
+	if (scheduler->priv->schedule_id == 0)
+	{
+		scheduler->priv->schedule_id =
+			g_timeout_add_full (G_PRIORITY_HIGH,
+					    0,
+					    (GSourceFunc) schedule,
+					    scheduler,
+					    NULL);
+	}
+}
+
+static gchar *
+get_directory_uri (GeditDocumentSaver *saver)
+{
+	GFile *location;
+	GFile *parent;
+	gchar *uri;
+
+	location = gedit_document_saver_get_location (saver);
+	parent = g_file_get_parent (location);
+
+	uri = g_file_get_uri (parent != NULL ? parent : location);
+
+	if (parent != NULL)
+		g_object_unref (parent);
+
+	g_object_unref (location);
+
+	return uri;
+}
+
+void
+_gedit_save_scheduler_add (GeditSaveScheduler *scheduler,
+			   GeditDocumentSaver *saver)
+{
+	Directory *dir;
+	gchar *uri;
+
+	g_return_if_fail (GEDIT_IS_SAVE_SCHEDULER (scheduler));
+	g_return_if_fail (GEDIT_IS_DOCUMENT_SAVER (saver));
+
+	uri = get_directory_uri (saver);
+	dir = g_hash_table_lookup (scheduler->priv->directories, uri);
+
+	if (dir == NULL)
+	{
+		dir = g_slice_new0 (Directory);
+		dir->uri = uri;
+		g_queue_init (&dir->pending);
+
+		g_hash_table_insert (scheduler->priv->directories, dir->uri, dir);
+		g_queue_push_tail (&scheduler->priv->rotation, dir);
+	}
+	else
+	{
+		g_free (uri);
+	}
+
+	g_queue_push_tail (&dir->pending, g_object_ref (saver));
+	scheduler->priv->n_total++;
+
+	g_signal_emit (scheduler,
+		       signals[PROGRESS],
+		       0,
+		       scheduler->priv->n_saved,
+		       scheduler->priv->n_total);
+
+	queue_schedule (scheduler);
+}
+
+void
+_gedit_save_scheduler_finished (GeditSaveScheduler *scheduler,
+				GeditDocumentSaver *saver)
+{
+	GeditSaveSchedulerPrivate *priv;
+	Directory *dir;
+
+	g_return_if_fail (GEDIT_IS_SAVE_SCHEDULER (scheduler));
+	g_return_if_fail (GEDIT_IS_DOCUMENT_SAVER (saver));
+
+	priv = scheduler->priv;
+
+	dir = g_hash_table_lookup (priv->running, saver);
+	g_return_if_fail (dir != NULL);
+
+	g_hash_table_remove (priv->running, saver);
+
+	dir->n_running--;
+	dir->first_done = TRUE;
+
+	if (dir->n_running == 0 && g_queue_is_empty (&dir->pending))
+	{
+		g_queue_remove (&priv->rotation, dir);
+		g_hash_table_remove (priv->directories, dir->uri);
+	}
+
+	priv->n_saved++;
+
+	g_signal_emit (scheduler,
+		       signals[PROGRESS],
+		       0,
+		       priv->n_saved,
+		       priv->n_total);
+
+	if (g_hash_table_size (priv->directories) == 0)
+	{
+		priv->n_saved = 0;
+		priv->n_total = 0;
+	}
+	else
+	{
+		queue_schedule (scheduler);
+	}
+}
+
+/* ex:set ts=8 noet: */
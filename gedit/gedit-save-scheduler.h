@@ -0,0 +1,73 @@
+/*
+ * gedit-save-scheduler.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GEDIT_SAVE_SCHEDULER_H__
+#define __GEDIT_SAVE_SCHEDULER_H__
+
+#include <glib-object.h>
+
+#include "gedit-document-saver.h"
+
+G_BEGIN_DECLS
+
+#define GEDIT_TYPE_SAVE_SCHEDULER		(gedit_save_scheduler_get_type ())
+#define GEDIT_SAVE_SCHEDULER(obj)		(G_TYPE_CHECK_INSTANCE_CAST ((obj), GEDIT_TYPE_SAVE_SCHEDULER, GeditSaveScheduler))
+#define GEDIT_SAVE_SCHEDULER_CLASS(klass)	(G_TYPE_CHECK_CLASS_CAST ((klass), GEDIT_TYPE_SAVE_SCHEDULER, GeditSaveSchedulerClass))
+#define GEDIT_IS_SAVE_SCHEDULER(obj)		(G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEDIT_TYPE_SAVE_SCHEDULER))
+#define GEDIT_IS_SAVE_SCHEDULER_CLASS(klass)	(G_TYPE_CHECK_CLASS_TYPE ((klass), GEDIT_TYPE_SAVE_SCHEDULER))
+#define GEDIT_SAVE_SCHEDULER_GET_CLASS(obj)	(G_TYPE_INSTANCE_GET_CLASS ((obj), GEDIT_TYPE_SAVE_SCHEDULER, GeditSaveSchedulerClass))
+
+typedef struct _GeditSaveScheduler		GeditSaveScheduler;
+typedef struct _GeditSaveSchedulerClass		GeditSaveSchedulerClass;
+typedef struct _GeditSaveSchedulerPrivate	GeditSaveSchedulerPrivate;
+
+struct _GeditSaveScheduler
+{
+	GObject parent;
+
+	GeditSaveSchedulerPrivate *priv;
+};
+
+struct _GeditSaveSchedulerClass
+{
+	GObjectClass parent_class;
+
+	void (* progress) (GeditSaveScheduler *scheduler,
+			   guint               n_saved,
+			   guint               n_total);
+};
+
+GType			 gedit_save_scheduler_get_type		(void) G_GNUC_CONST;
+
+GeditSaveScheduler	*_gedit_save_scheduler_get_default	(void);
+
+void			 _gedit_save_scheduler_add		(GeditSaveScheduler *scheduler,
+								 GeditDocumentSaver *saver);
+
+void			 _gedit_save_scheduler_finished		(GeditSaveScheduler *scheduler,
+								 GeditDocumentSaver *saver);
+
+G_END_DECLS
+
+#endif /* __GEDIT_SAVE_SCHEDULER_H__ */
+
+/* ex:set ts=8 noet: */
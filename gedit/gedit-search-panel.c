@@ -0,0 +1,1057 @@
+/*
+ * gedit-search-panel.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <glib/gi18n.h>
+
+#include "gedit-search-panel.h"
+#include "gedit-commands.h"
+#include "gedit-debug.h"
+#include "gedit-document.h"
+#include "gedit-tab.h"
+#include "gedit-utils.h"
+#include "gedit-view.h"
+
+/*
+ * The search runs over every open document, and optionally over the files
+ * below a root directory. The text of each document is copied (one document
+ * per idle, so that hundreds of tabs do not block the UI) and the snapshots
+ * are scanned in a shared thread pool. Results are sent back in batches and
+ * appended to the list as they arrive.
+ *
+ * Worker threads only see a SearchRun's regex, cancellable and counters, the
+ * panel is only touched from the main thread. Documents are referenced by the
+ * panel for the whole run, jobs and results only borrow them so that a buffer
+ * is never finalized from a worker thread.
+ */
+
+/* Stop the search after this many matches */
+#define MAX_RESULTS		10000
+
+/* Do not look into files bigger than this (in bytes) */
+#define MAX_FILE_SIZE		(10 * 1024 * 1024)
+
+/* Number of results sent to the main loop at once */
+#define RESULTS_BATCH_SIZE	100
+
+/* Context shown around a match in the list, in bytes */
+#define PREVIEW_CONTEXT		60
+
+#define DIRECTORY_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+			     G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+			     G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+			     G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
+			     G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK "," \
+			     G_FILE_ATTRIBUTE_STANDARD_SIZE
+
+typedef struct _SearchRun SearchRun;
+
+struct _SearchRun
+{
+	volatile gint ref_count;
+
+	/* Main thread only, NULL once the run is cancelled */
+	GeditSearchPanel *panel;
+
+	GRegex *regex;
+	GCancellable *cancellable;
+
+	/* Locations of the open documents, they are not read from disk */
+	GHashTable *open_locations;
+
+	volatile gint pending_jobs;
+	volatile gint n_results;
+};
+
+typedef enum
+{
+	SEARCH_JOB_TEXT,
+	SEARCH_JOB_FILE,
+	SEARCH_JOB_DIRECTORY
+} SearchJobKind;
+
+typedef struct _SearchJob
+{
+	SearchJobKind kind;
+	SearchRun *run;
+
+	/* Borrowed */
+	GeditDocument *doc;
+	GFile *location;
+	gchar *name;
+	gchar *text;
+} SearchJob;
+
+typedef struct _SearchResult
+{
+	/* Borrowed */
+	GeditDocument *doc;
+	GFile *location;
+	gint line;
+	gint line_offset;
+	gint length;
+	gchar *markup;
+} SearchResult;
+
+typedef struct _SearchBatch
+{
+	SearchRun *run;
+	gchar *name;
+	GPtrArray *results;
+	gboolean job_done;
+} SearchBatch;
+
+struct _GeditSearchPanelPrivate
+{
+	GeditWindow  *window;
+
+	GtkWidget    *treeview;
+	GtkListStore *store;
+	GtkWidget    *status_label;
+
+	SearchRun    *run;
+	GPtrArray    *docs;
+
+	/* Documents waiting to be copied into a job */
+	GList        *pending_docs;
+	guint         snapshot_idle_id;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (GeditSearchPanel, gedit_search_panel, GTK_TYPE_BOX)
+
+enum
+{
+	PROP_0,
+	PROP_WINDOW
+};
+
+enum
+{
+	LOCATION_MARKUP_COLUMN = 0,
+	TEXT_MARKUP_COLUMN,
+	DOCUMENT_COLUMN,
+	LOCATION_COLUMN,
+	LINE_COLUMN,
+	LINE_OFFSET_COLUMN,
+	LENGTH_COLUMN,
+	N_COLUMNS
+};
+
+static GThreadPool *search_pool = NULL;
+
+static void search_job_run (SearchJob *job, gpointer user_data);
+
+static SearchRun *
+search_run_ref (SearchRun *run)
+{
+	g_atomic_int_inc (&run->ref_count);
+
+	return run;
+}
+
+static void
+search_run_unref (SearchRun *run)
+{
+	if (g_atomic_int_dec_and_test (&run->ref_count))
+	{
+		g_regex_unref (run->regex);
+		g_object_unref (run->cancellable);
+		g_hash_table_unref (run->open_locations);
+
+		g_slice_free (SearchRun, run);
+	}
+}
+
+static void
+search_result_free (SearchResult *result)
+{
+	g_clear_object (&result->location);
+	g_free (result->markup);
+
+	g_slice_free (SearchResult, result);
+}
+
+static void
+search_job_free (SearchJob *job)
+{
+	search_run_unref (job->run);
+	g_clear_object (&job->location);
+	g_free (job->name);
+	g_free (job->text);
+
+	g_slice_free (SearchJob, job);
+}
+
+static void
+push_job (SearchRun     *run,
+	  SearchJobKind  kind,
+	  GeditDocument *doc,
+	  GFile         *location,
+	  gchar         *name,
+	  gchar         *text)
+{
+	SearchJob *job;
+
+	if (search_pool == NULL)
+	{
+		search_pool = g_thread_pool_new ((GFunc) search_job_run,
+						 NULL,
+						 MAX (2, g_get_num_processors ()),
+						 FALSE,
+						 NULL);
+	}
+
+	job = g_slice_new0 (SearchJob);
+	job->kind = kind;
+	job->run = search_run_ref (run);
+	job->doc = doc;
+	job->location = location != NULL ? g_object_ref (location) : NULL;
+	job->name = name;
+	job->text = text;
+
+	g_atomic_int_inc (&run->pending_jobs);
+
+	g_thread_pool_push (search_pool, job, NULL);
+}
+
+/* Main thread */
+
+static void
+update_status (GeditSearchPanel *panel)
+{
+	SearchRun *run = panel->priv->run;
+	gint n_results;
+	gchar *msg;
+
+	if (run == NULL)
+	{
+		return;
+	}
+
+	n_results = MIN (g_atomic_int_get (&run->n_results), MAX_RESULTS);
+
+	if (g_atomic_int_get (&run->pending_jobs) > 0 ||
+	    panel->priv->pending_docs != NULL)
+	{
+		msg = g_strdup_printf (ngettext ("Searching... %d match found",
+						 "Searching... %d matches found",
+						 n_results),
+				       n_results);
+	}
+	else
+	{
+		msg = g_strdup_printf (ngettext ("%d match found",
+						 "%d matches found",
+						 n_results),
+				       n_results);
+	}
+
+	gtk_label_set_text (GTK_LABEL (panel->priv->status_label), msg);
+	g_free (msg);
+}
+
+static gboolean
+deliver_batch (SearchBatch *batch)
+{
+	GeditSearchPanel *panel = batch->run->panel;
+	guint i;
+
+	/* The cancellable is also cancelled once there are MAX_RESULTS
+	 * results, the batches found until then are still shown */
+	if (panel == NULL)
+	{
+		return G_SOURCE_REMOVE;
+	}
+
+	for (i = 0; i < batch->results->len; i++)
+	{
+		SearchResult *result = g_ptr_array_index (batch->results, i);
+		gchar *name_markup;
+		GtkTreeIter iter;
+
+		name_markup = g_markup_printf_escaped ("%s:<b>%d</b>",
+						       batch->name,
+						       result->line + 1);
+
+		gtk_list_store_insert_with_values (panel->priv->store,
+						   &iter,
+						   -1,
+						   LOCATION_MARKUP_COLUMN, name_markup,
+						   TEXT_MARKUP_COLUMN, result->markup,
+						   DOCUMENT_COLUMN, result->doc,
+						   LOCATION_COLUMN, result->location,
+						   LINE_COLUMN, result->line,
+						   LINE_OFFSET_COLUMN, result->line_offset,
+						   LENGTH_COLUMN, result->length,
+						   -1);
+
+		g_free (name_markup);
+	}
+
+	if (batch->job_done)
+	{
+		g_atomic_int_add (&batch->run->pending_jobs, -1);
+	}
+
+	update_status (panel);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+search_batch_free (SearchBatch *batch)
+{
+	search_run_unref (batch->run);
+	g_ptr_array_unref (batch->results);
+	g_free (batch->name);
+
+	g_slice_free (SearchBatch, batch);
+}
+
+/* Worker threads */
+
+static GPtrArray *
+results_new (void)
+{
+	return g_ptr_array_new_with_free_func ((GDestroyNotify) search_result_free);
+}
+
+/* Takes ownership of @results */
+static void
+send_batch (SearchJob *job,
+	    GPtrArray *results,
+	    gboolean   job_done)
+{
+	SearchBatch *batch;
+
+	batch = g_slice_new (SearchBatch);
+	batch->run = search_run_ref (job->run);
+	batch->name = g_strdup (job->name);
+	batch->results = results != NULL ? results : results_new ();
+	batch->job_done = job_done;
+
+	g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+			 (GSourceFunc) deliver_batch,
+			 batch,
+			 (GDestroyNotify) search_batch_free);
+}
+
+static gchar *
+make_preview (const gchar *line_start,
+	      const gchar *line_end,
+	      const gchar *match_start,
+	      const gchar *match_end)
+{
+	const gchar *before;
+	const gchar *after;
+	gchar *before_str;
+	gchar *match_str;
+	gchar *after_str;
+	gchar *markup;
+
+	/* A match spanning lines is only shown up to the end of its first line */
+	if (match_end > line_end)
+	{
+		match_end = line_end;
+	}
+
+	before = line_start;
+	if (match_start - before > PREVIEW_CONTEXT)
+	{
+		before = g_utf8_find_next_char (match_start - PREVIEW_CONTEXT, match_start);
+	}
+
+	after = line_end;
+	if (after - match_end > PREVIEW_CONTEXT)
+	{
+		after = g_utf8_find_prev_char (match_end, match_end + PREVIEW_CONTEXT);
+	}
+
+	/* Skip the indentation */
+	while (before < match_start && g_ascii_isspace (*before))
+	{
+		before++;
+	}
+
+	before_str = g_markup_escape_text (before, match_start - before);
+	match_str = g_markup_escape_text (match_start, match_end - match_start);
+	after_str = g_markup_escape_text (match_end, after - match_end);
+
+	markup = g_strconcat (before_str, "<b>", match_str, "</b>", after_str, NULL);
+
+	g_free (before_str);
+	g_free (match_str);
+	g_free (after_str);
+
+	return markup;
+}
+
+static void
+scan_text (SearchJob   *job,
+	   const gchar *text,
+	   gsize        length)
+{
+	GPtrArray *results;
+	GMatchInfo *match_info;
+	const gchar *text_end = text + length;
+	const gchar *scanned = text;
+	const gchar *line_start = text;
+	const gchar *line_end = NULL;
+	gint line = 0;
+
+	results = results_new ();
+
+	g_regex_match_full (job->run->regex, text, length, 0, 0, &match_info, NULL);
+
+	while (g_match_info_matches (match_info))
+	{
+		SearchResult *result;
+		const gchar *match_start;
+		const gchar *match_end;
+		const gchar *nl;
+		gint start_pos;
+		gint end_pos;
+
+		if (g_cancellable_is_cancelled (job->run->cancellable))
+		{
+			break;
+		}
+
+		/* Enough results, the other jobs are not run anymore */
+		if (g_atomic_int_add (&job->run->n_results, 1) >= MAX_RESULTS)
+		{
+			g_cancellable_cancel (job->run->cancellable);
+			break;
+		}
+
+		g_match_info_fetch_pos (match_info, 0, &start_pos, &end_pos);
+		match_start = text + start_pos;
+		match_end = text + end_pos;
+
+		/* Count the lines incrementally from the previous match */
+		while ((nl = memchr (scanned, '\n', match_start - scanned)) != NULL)
+		{
+			line++;
+			scanned = nl + 1;
+			line_start = scanned;
+			line_end = NULL;
+		}
+
+		scanned = match_start;
+
+		if (line_end == NULL)
+		{
+			line_end = memchr (line_start, '\n', text_end - line_start);
+
+			if (line_end == NULL)
+			{
+				line_end = text_end;
+			}
+		}
+
+		result = g_slice_new0 (SearchResult);
+		result->doc = job->doc;
+		result->location = job->location != NULL ? g_object_ref (job->location) : NULL;
+		result->line = line;
+		result->line_offset = g_utf8_pointer_to_offset (line_start, match_start);
+		result->length = g_utf8_pointer_to_offset (match_start, match_end);
+		result->markup = make_preview (line_start, line_end, match_start, match_end);
+
+		g_ptr_array_add (results, result);
+
+		if (results->len >= RESULTS_BATCH_SIZE)
+		{
+			send_batch (job, results, FALSE);
+			results = results_new ();
+		}
+
+		g_match_info_next (match_info, NULL);
+	}
+
+	g_match_info_free (match_info);
+
+	send_batch (job, results, TRUE);
+}
+
+static void
+scan_file (SearchJob *job)
+{
+	gchar *contents;
+	gsize length;
+
+	if (g_file_load_contents (job->location,
+				  job->run->cancellable,
+				  &contents,
+				  &length,
+				  NULL,
+				  NULL))
+	{
+		/* Binary files and other encodings are skipped */
+		if (g_utf8_validate (contents, length, NULL))
+		{
+			scan_text (job, contents, length);
+			g_free (contents);
+
+			return;
+		}
+
+		g_free (contents);
+	}
+
+	send_batch (job, NULL, TRUE);
+}
+
+static void
+walk_directory (SearchJob *job)
+{
+	GFileEnumerator *enumerator;
+	GFileInfo *info;
+
+	enumerator = g_file_enumerate_children (job->location,
+						DIRECTORY_ATTRIBUTES,
+						G_FILE_QUERY_INFO_NONE,
+						job->run->cancellable,
+						NULL);
+
+	while (enumerator != NULL &&
+	       (info = g_file_enumerator_next_file (enumerator, job->run->cancellable, NULL)) != NULL)
+	{
+		GFile *child;
+
+		if (g_file_info_get_is_hidden (info) ||
+		    g_file_info_get_is_backup (info))
+		{
+			g_object_unref (info);
+			continue;
+		}
+
+		child = g_file_get_child (job->location, g_file_info_get_name (info));
+
+		switch (g_file_info_get_file_type (info))
+		{
+			case G_FILE_TYPE_DIRECTORY:
+				/* Links to directories can make loops */
+				if (!g_file_info_get_is_symlink (info))
+				{
+					push_job (job->run, SEARCH_JOB_DIRECTORY, NULL, child, NULL, NULL);
+				}
+				break;
+
+			case G_FILE_TYPE_REGULAR:
+				if (g_file_info_get_size (info) <= MAX_FILE_SIZE &&
+				    !g_hash_table_contains (job->run->open_locations, child))
+				{
+					push_job (job->run,
+						  SEARCH_JOB_FILE,
+						  NULL,
+						  child,
+						  g_file_get_parse_name (child),
+						  NULL);
+				}
+				break;
+
+			default:
+				break;
+		}
+
+		g_object_unref (child);
+		g_object_unref (info);
+	}
+
+	g_clear_object (&enumerator);
+
+	send_batch (job, NULL, TRUE);
+}
+
+static void
+search_job_run (SearchJob *job,
+		gpointer   user_data)
+{
+	if (g_cancellable_is_cancelled (job->run->cancellable))
+	{
+		/* Still accounted for, the run can have stopped at
+		 * MAX_RESULTS rather than been cancelled */
+		send_batch (job, NULL, TRUE);
+		search_job_free (job);
+		return;
+	}
+
+	switch (job->kind)
+	{
+		case SEARCH_JOB_TEXT:
+			scan_text (job, job->text, strlen (job->text));
+			break;
+
+		case SEARCH_JOB_FILE:
+			scan_file (job);
+			break;
+
+		case SEARCH_JOB_DIRECTORY:
+			walk_directory (job);
+			break;
+	}
+
+	search_job_free (job);
+}
+
+/* Main thread */
+
+static gboolean
+snapshot_idle (GeditSearchPanel *panel)
+{
+	GeditDocument *doc;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	if (panel->priv->pending_docs == NULL)
+	{
+		panel->priv->snapshot_idle_id = 0;
+		update_status (panel);
+
+		return G_SOURCE_REMOVE;
+	}
+
+	doc = panel->priv->pending_docs->data;
+	panel->priv->pending_docs = g_list_delete_link (panel->priv->pending_docs,
+							panel->priv->pending_docs);
+
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+
+	push_job (panel->priv->run,
+		  SEARCH_JOB_TEXT,
+		  doc,
+		  NULL,
+		  gedit_document_get_short_name_for_display (doc),
+		  gtk_text_buffer_get_text (GTK_TEXT_BUFFER (doc), &start, &end, TRUE));
+
+	g_ptr_array_add (panel->priv->docs, doc);
+
+	return G_SOURCE_CONTINUE;
+}
+
+void
+gedit_search_panel_cancel (GeditSearchPanel *panel)
+{
+	g_return_if_fail (GEDIT_IS_SEARCH_PANEL (panel));
+
+	if (panel->priv->snapshot_idle_id != 0)
+	{
+		g_source_remove (panel->priv->snapshot_idle_id);
+		panel->priv->snapshot_idle_id = 0;
+	}
+
+	g_list_free_full (panel->priv->pending_docs, g_object_unref);
+	panel->priv->pending_docs = NULL;
+
+	if (panel->priv->run != NULL)
+	{
+		g_cancellable_cancel (panel->priv->run->cancellable);
+		panel->priv->run->panel = NULL;
+
+		search_run_unref (panel->priv->run);
+		panel->priv->run = NULL;
+	}
+
+	/* Only dropped now that no batch of the run will be delivered */
+	g_ptr_array_set_size (panel->priv->docs, 0);
+}
+
+static GRegex *
+create_regex (GtkSourceSearchSettings  *settings,
+	      GError                  **error)
+{
+	const gchar *search_text;
+	gchar *pattern;
+	gchar *tmp;
+	GRegexCompileFlags flags = G_REGEX_MULTILINE | G_REGEX_OPTIMIZE;
+	GRegex *regex;
+
+	search_text = gtk_source_search_settings_get_search_text (settings);
+
+	if (gtk_source_search_settings_get_regex_enabled (settings))
+	{
+		pattern = g_strdup (search_text);
+	}
+	else
+	{
+		pattern = g_regex_escape_string (search_text, -1);
+	}
+
+	if (gtk_source_search_settings_get_at_word_boundaries (settings))
+	{
+		tmp = g_strdup_printf ("\\b(?:%s)\\b", pattern);
+		g_free (pattern);
+		pattern = tmp;
+	}
+
+	if (!gtk_source_search_settings_get_case_sensitive (settings))
+	{
+		flags |= G_REGEX_CASELESS;
+	}
+
+	regex = g_regex_new (pattern, flags, 0, error);
+	g_free (pattern);
+
+	return regex;
+}
+
+void
+gedit_search_panel_search (GeditSearchPanel        *panel,
+			   GtkSourceSearchSettings *settings,
+			   GFile                   *root)
+{
+	SearchRun *run;
+	GRegex *regex;
+	GList *docs;
+	GList *l;
+	GError *error = NULL;
+
+	g_return_if_fail (GEDIT_IS_SEARCH_PANEL (panel));
+	g_return_if_fail (GTK_SOURCE_IS_SEARCH_SETTINGS (settings));
+	g_return_if_fail (root == NULL || G_IS_FILE (root));
+
+	gedit_debug (DEBUG_SEARCH);
+
+	gedit_search_panel_cancel (panel);
+	gtk_list_store_clear (panel->priv->store);
+
+	if (gtk_source_search_settings_get_search_text (settings) == NULL)
+	{
+		gtk_label_set_text (GTK_LABEL (panel->priv->status_label), "");
+		return;
+	}
+
+	regex = create_regex (settings, &error);
+
+	if (regex == NULL)
+	{
+		gtk_label_set_text (GTK_LABEL (panel->priv->status_label), error->message);
+		g_error_free (error);
+		return;
+	}
+
+	run = g_slice_new0 (SearchRun);
+	run->ref_count = 1;
+	run->panel = panel;
+	run->regex = regex;
+	run->cancellable = g_cancellable_new ();
+	run->open_locations = g_hash_table_new_full (g_file_hash,
+						     (GEqualFunc) g_file_equal,
+						     g_object_unref,
+						     NULL);
+
+	panel->priv->run = run;
+
+	docs = gedit_window_get_documents (panel->priv->window);
+
+	for (l = docs; l != NULL; l = l->next)
+	{
+		GFile *location;
+
+		location = gedit_document_get_location (l->data);
+
+		if (location != NULL)
+		{
+			g_hash_table_add (run->open_locations, location);
+		}
+
+		panel->priv->pending_docs = g_list_prepend (panel->priv->pending_docs,
+							    g_object_ref (l->data));
+	}
+
+	panel->priv->pending_docs = g_list_reverse (panel->priv->pending_docs);
+	g_list_free (docs);
+
+	/* The table is only read by the workers from now on */
+	if (root != NULL)
+	{
+		push_job (run, SEARCH_JOB_DIRECTORY, NULL, root, NULL, NULL);
+	}
+
+	panel->priv->snapshot_idle_id = g_idle_add ((GSourceFunc) snapshot_idle, panel);
+
+	update_status (panel);
+}
+
+static void
+select_result (GeditSearchPanel *panel,
+	       GeditTab         *tab,
+	       gint              line,
+	       gint              line_offset,
+	       gint              length)
+{
+	GeditDocument *doc;
+	GeditView *view;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	doc = gedit_tab_get_document (tab);
+	view = gedit_tab_get_view (tab);
+
+	gedit_window_set_active_tab (panel->priv->window, tab);
+
+	/* The document may have been edited since the search */
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (doc), &start, line);
+
+	if (gtk_text_iter_get_line (&start) != line ||
+	    line_offset > gtk_text_iter_get_chars_in_line (&start))
+	{
+		return;
+	}
+
+	gtk_text_iter_set_line_offset (&start, line_offset);
+
+	end = start;
+	gtk_text_iter_forward_chars (&end, length);
+
+	gtk_text_buffer_select_range (GTK_TEXT_BUFFER (doc), &start, &end);
+	gedit_view_scroll_to_cursor (view);
+
+	gtk_widget_grab_focus (GTK_WIDGET (view));
+}
+
+static void
+treeview_row_activated (GtkTreeView       *treeview,
+			GtkTreePath       *path,
+			GtkTreeViewColumn *column,
+			GeditSearchPanel  *panel)
+{
+	GtkTreeIter iter;
+	GeditDocument *doc;
+	GFile *location;
+	GeditTab *tab = NULL;
+	gint line;
+	gint line_offset;
+	gint length;
+
+	if (!gtk_tree_model_get_iter (GTK_TREE_MODEL (panel->priv->store), &iter, path))
+	{
+		return;
+	}
+
+	gtk_tree_model_get (GTK_TREE_MODEL (panel->priv->store),
+			    &iter,
+			    DOCUMENT_COLUMN, &doc,
+			    LOCATION_COLUMN, &location,
+			    LINE_COLUMN, &line,
+			    LINE_OFFSET_COLUMN, &line_offset,
+			    LENGTH_COLUMN, &length,
+			    -1);
+
+	if (doc != NULL)
+	{
+		tab = gedit_tab_get_from_document (doc);
+	}
+	else if (location != NULL)
+	{
+		tab = gedit_window_get_tab_from_location (panel->priv->window, location);
+
+		if (tab == NULL)
+		{
+			/* Lines and columns start at 1 there */
+			gedit_commands_load_location (panel->priv->window,
+						      location,
+						      NULL,
+						      line + 1,
+						      line_offset + 1);
+		}
+	}
+
+	/* A closed document is still referenced by the list */
+	if (tab != NULL && gtk_widget_get_toplevel (GTK_WIDGET (tab)) == GTK_WIDGET (panel->priv->window))
+	{
+		select_result (panel, tab, line, line_offset, length);
+	}
+
+	g_clear_object (&doc);
+	g_clear_object (&location);
+}
+
+static void
+gedit_search_panel_set_property (GObject      *object,
+				 guint         prop_id,
+				 const GValue *value,
+				 GParamSpec   *pspec)
+{
+	GeditSearchPanel *panel = GEDIT_SEARCH_PANEL (object);
+
+	switch (prop_id)
+	{
+		case PROP_WINDOW:
+			panel->priv->window = g_value_get_object (value);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gedit_search_panel_get_property (GObject    *object,
+				 guint       prop_id,
+				 GValue     *value,
+				 GParamSpec *pspec)
+{
+	GeditSearchPanel *panel = GEDIT_SEARCH_PANEL (object);
+
+	switch (prop_id)
+	{
+		case PROP_WINDOW:
+			g_value_set_object (value, panel->priv->window);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gedit_search_panel_dispose (GObject *object)
+{
+	GeditSearchPanel *panel = GEDIT_SEARCH_PANEL (object);
+
+	gedit_debug (DEBUG_PANEL);
+
+	gedit_search_panel_cancel (panel);
+
+	G_OBJECT_CLASS (gedit_search_panel_parent_class)->dispose (object);
+}
+
+static void
+gedit_search_panel_finalize (GObject *object)
+{
+	GeditSearchPanel *panel = GEDIT_SEARCH_PANEL (object);
+
+	g_ptr_array_unref (panel->priv->docs);
+
+	G_OBJECT_CLASS (gedit_search_panel_parent_class)->finalize (object);
+}
+
+static void
+gedit_search_panel_class_init (GeditSearchPanelClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gedit_search_panel_dispose;
+	object_class->finalize = gedit_search_panel_finalize;
+	object_class->get_property = gedit_search_panel_get_property;
+	object_class->set_property = gedit_search_panel_set_property;
+
+	/* The window owns the panel, so this is not a reference */
+	g_object_class_install_property (object_class,
+					 PROP_WINDOW,
+					 g_param_spec_object ("window",
+							      "Window",
+							      "The GeditWindow this GeditSearchPanel is associated with",
+							      GEDIT_TYPE_WINDOW,
+							      G_PARAM_READWRITE |
+							      G_PARAM_CONSTRUCT_ONLY |
+							      G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gedit_search_panel_init (GeditSearchPanel *panel)
+{
+	GtkWidget *sw;
+	GtkTreeViewColumn *column;
+	GtkCellRenderer *cell;
+
+	gedit_debug (DEBUG_PANEL);
+
+	panel->priv = gedit_search_panel_get_instance_private (panel);
+	panel->priv->docs = g_ptr_array_new_with_free_func (g_object_unref);
+
+	gtk_orientable_set_orientation (GTK_ORIENTABLE (panel),
+	                                GTK_ORIENTATION_VERTICAL);
+
+	panel->priv->status_label = gtk_label_new (NULL);
+	gtk_misc_set_alignment (GTK_MISC (panel->priv->status_label), 0.0, 0.5);
+	gtk_misc_set_padding (GTK_MISC (panel->priv->status_label), 6, 3);
+	gtk_widget_show (panel->priv->status_label);
+	gtk_box_pack_start (GTK_BOX (panel), panel->priv->status_label, FALSE, FALSE, 0);
+
+	sw = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (sw),
+					GTK_POLICY_AUTOMATIC,
+					GTK_POLICY_AUTOMATIC);
+	gtk_widget_show (sw);
+	gtk_box_pack_start (GTK_BOX (panel), sw, TRUE, TRUE, 0);
+
+	panel->priv->store = gtk_list_store_new (N_COLUMNS,
+						 G_TYPE_STRING,
+						 G_TYPE_STRING,
+						 GEDIT_TYPE_DOCUMENT,
+						 G_TYPE_FILE,
+						 G_TYPE_INT,
+						 G_TYPE_INT,
+						 G_TYPE_INT);
+
+	panel->priv->treeview = gtk_tree_view_new_with_model (GTK_TREE_MODEL (panel->priv->store));
+	g_object_unref (panel->priv->store);
+	gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (panel->priv->treeview), FALSE);
+	gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (panel->priv->treeview), TRUE);
+	gtk_container_add (GTK_CONTAINER (sw), panel->priv->treeview);
+	gtk_widget_show (panel->priv->treeview);
+
+	/* Fixed height mode keeps appending thousands of rows cheap */
+	column = gtk_tree_view_column_new ();
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width (column, 250);
+	gtk_tree_view_column_set_resizable (column, TRUE);
+	cell = gtk_cell_renderer_text_new ();
+	g_object_set (cell, "ellipsize", PANGO_ELLIPSIZE_START, NULL);
+	gtk_tree_view_column_pack_start (column, cell, TRUE);
+	gtk_tree_view_column_add_attribute (column, cell, "markup", LOCATION_MARKUP_COLUMN);
+	gtk_tree_view_append_column (GTK_TREE_VIEW (panel->priv->treeview), column);
+
+	column = gtk_tree_view_column_new ();
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_expand (column, TRUE);
+	cell = gtk_cell_renderer_text_new ();
+	g_object_set (cell, "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+	gtk_tree_view_column_pack_start (column, cell, TRUE);
+	gtk_tree_view_column_add_attribute (column, cell, "markup", TEXT_MARKUP_COLUMN);
+	gtk_tree_view_append_column (GTK_TREE_VIEW (panel->priv->treeview), column);
+
+	g_signal_connect (panel->priv->treeview,
+			  "row-activated",
+			  G_CALLBACK (treeview_row_activated),
+			  panel);
+}
+
+GtkWidget *
+gedit_search_panel_new (GeditWindow *window)
+{
+	g_return_val_if_fail (GEDIT_IS_WINDOW (window), NULL);
+
+	return g_object_new (GEDIT_TYPE_SEARCH_PANEL,
+			     "window", window,
+			     NULL);
+}
+
+/* ex:set ts=8 noet: */
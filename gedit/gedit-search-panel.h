@@ -0,0 +1,86 @@
+/*
+ * gedit-search-panel.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GEDIT_SEARCH_PANEL_H__
+#define __GEDIT_SEARCH_PANEL_H__
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+
+#include <gedit/gedit-window.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Type checking and casting macros
+ */
+#define GEDIT_TYPE_SEARCH_PANEL              (gedit_search_panel_get_type())
+#define GEDIT_SEARCH_PANEL(obj)              (G_TYPE_CHECK_INSTANCE_CAST((obj), GEDIT_TYPE_SEARCH_PANEL, GeditSearchPanel))
+#define GEDIT_SEARCH_PANEL_CLASS(klass)      (G_TYPE_CHECK_CLASS_CAST((klass), GEDIT_TYPE_SEARCH_PANEL, GeditSearchPanelClass))
+#define GEDIT_IS_SEARCH_PANEL(obj)           (G_TYPE_CHECK_INSTANCE_TYPE((obj), GEDIT_TYPE_SEARCH_PANEL))
+#define GEDIT_IS_SEARCH_PANEL_CLASS(klass)   (G_TYPE_CHECK_CLASS_TYPE ((klass), GEDIT_TYPE_SEARCH_PANEL))
+#define GEDIT_SEARCH_PANEL_GET_CLASS(obj)    (G_TYPE_INSTANCE_GET_CLASS((obj), GEDIT_TYPE_SEARCH_PANEL, GeditSearchPanelClass))
+
+/* Private structure type */
+typedef struct _GeditSearchPanelPrivate GeditSearchPanelPrivate;
+
+/*
+ * Main object structure
+ */
+typedef struct _GeditSearchPanel GeditSearchPanel;
+
+struct _GeditSearchPanel
+{
+	GtkBox vbox;
+
+	/*< private > */
+	GeditSearchPanelPrivate *priv;
+};
+
+/*
+ * Class definition
+ */
+typedef struct _GeditSearchPanelClass GeditSearchPanelClass;
+
+struct _GeditSearchPanelClass
+{
+	GtkBoxClass parent_class;
+};
+
+/*
+ * Public methods
+ */
+GType		 gedit_search_panel_get_type	(void) G_GNUC_CONST;
+
+GtkWidget	*gedit_search_panel_new		(GeditWindow             *window);
+
+void		 gedit_search_panel_search	(GeditSearchPanel        *panel,
+						 GtkSourceSearchSettings *settings,
+						 GFile                   *root);
+
+void		 gedit_search_panel_cancel	(GeditSearchPanel        *panel);
+
+G_END_DECLS
+
+#endif  /* __GEDIT_SEARCH_PANEL_H__  */
+
+/* ex:set ts=8 noet: */
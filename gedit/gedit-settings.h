@@ -78,6 +78,7 @@ void			 gedit_settings_set_list			(GSettings     *settings,
 #define GEDIT_SETTINGS_CREATE_BACKUP_COPY		"create-backup-copy"
 #define GEDIT_SETTINGS_AUTO_SAVE			"auto-save"
 #define GEDIT_SETTINGS_AUTO_SAVE_INTERVAL		"auto-save-interval"
+#define GEDIT_SETTINGS_MAX_CONCURRENT_SAVES		"max-concurrent-saves"
 #define GEDIT_SETTINGS_MAX_UNDO_ACTIONS			"max-undo-actions"
 #define GEDIT_SETTINGS_WRAP_MODE			"wrap-mode"
 #define GEDIT_SETTINGS_TABS_SIZE			"tabs-size"
@@ -108,6 +109,7 @@ void			 gedit_settings_set_list			(GSettings     *settings,
 #define GEDIT_SETTINGS_ENCODING_AUTO_DETECTED		"auto-detected"
 #define GEDIT_SETTINGS_ENCODING_SHOWN_IN_MENU		"shown-in-menu"
 #define GEDIT_SETTINGS_ACTIVE_PLUGINS			"active-plugins"
+#define GEDIT_SETTINGS_LAZY_PLUGIN_LOADING		"lazy-loading"
 
 /* window state keys */
 #define GEDIT_SETTINGS_WINDOW_STATE			"state"
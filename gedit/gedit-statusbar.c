@@ -37,6 +37,10 @@
 #include <gtk/gtk.h>
 
 #include "gedit-statusbar.h"
+#include "gedit-timer.h"
+
+/* How late the flash message can be removed, in ms */
+#define FLASH_SLACK 250
 
 struct _GeditStatusbarPrivate
 {
@@ -79,7 +83,7 @@ gedit_statusbar_dispose (GObject *object)
 
 	if (statusbar->priv->flash_timeout > 0)
 	{
-		g_source_remove (statusbar->priv->flash_timeout);
+		_gedit_timer_remove (statusbar->priv->flash_timeout);
 		statusbar->priv->flash_timeout = 0;
 	}
 
@@ -293,7 +297,7 @@ gedit_statusbar_flash_message (GeditStatusbar *statusbar,
 	/* remove a currently ongoing flash message */
 	if (statusbar->priv->flash_timeout > 0)
 	{
-		g_source_remove (statusbar->priv->flash_timeout);
+		_gedit_timer_remove (statusbar->priv->flash_timeout);
 		statusbar->priv->flash_timeout = 0;
 
 		gtk_statusbar_remove (GTK_STATUSBAR (statusbar),
@@ -306,9 +310,10 @@ gedit_statusbar_flash_message (GeditStatusbar *statusbar,
 								context_id,
 								msg);
 
-	statusbar->priv->flash_timeout = g_timeout_add (flash_length,
-							(GSourceFunc) remove_message_timeout,
-							statusbar);
+	statusbar->priv->flash_timeout = _gedit_timer_add (flash_length,
+							   FLASH_SLACK,
+							   (GSourceFunc) remove_message_timeout,
+							   statusbar);
 
 	g_free (msg);
 }
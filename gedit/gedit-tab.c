@@ -41,9 +41,11 @@
 #include "gedit-print-job.h"
 #include "gedit-print-preview.h"
 #include "gedit-progress-info-bar.h"
+#include "gedit-recovery.h"
 #include "gedit-debug.h"
 #include "gedit-enum-types.h"
 #include "gedit-settings.h"
+#include "gedit-timer.h"
 #include "gedit-view-frame.h"
 
 #define GEDIT_TAB_KEY "GEDIT_TAB_KEY"
@@ -61,6 +63,8 @@ struct _GeditTabPrivate
 
 	GeditPrintJob          *print_job;
 
+	GeditRecoveryJournal   *journal;
+
 	/* tmp data for saving */
 	GFile		       *tmp_save_location;
 
@@ -131,9 +135,9 @@ install_auto_save_timeout (GeditTab *tab)
 	g_return_if_fail (tab->priv->state != GEDIT_TAB_STATE_REVERTING_ERROR);
 
 	/* Add a new timeout */
-	timeout = g_timeout_add_seconds (tab->priv->auto_save_interval * 60,
-					 (GSourceFunc) gedit_tab_auto_save,
-					 tab);
+	timeout = _gedit_timer_add_seconds (tab->priv->auto_save_interval * 60,
+					    (GSourceFunc) gedit_tab_auto_save,
+					    tab);
 
 	tab->priv->auto_save_timeout = timeout;
 }
@@ -176,7 +180,7 @@ remove_auto_save_timeout (GeditTab *tab)
 
 	g_return_if_fail (tab->priv->auto_save_timeout > 0);
 
-	g_source_remove (tab->priv->auto_save_timeout);
+	_gedit_timer_remove (tab->priv->auto_save_timeout);
 	tab->priv->auto_save_timeout = 0;
 }
 
@@ -254,6 +258,12 @@ gedit_tab_dispose (GObject *object)
 		tab->priv->print_preview = NULL;
 	}
 
+	if (tab->priv->journal != NULL)
+	{
+		_gedit_recovery_journal_free (tab->priv->journal);
+		tab->priv->journal = NULL;
+	}
+
 	g_clear_object (&tab->priv->tmp_save_location);
 	g_clear_object (&tab->priv->editor);
 
@@ -394,7 +404,6 @@ set_cursor_according_to_state (GtkTextView   *view,
 	if ((state == GEDIT_TAB_STATE_LOADING)          ||
 	    (state == GEDIT_TAB_STATE_REVERTING)        ||
 	    (state == GEDIT_TAB_STATE_SAVING)           ||
-	    (state == GEDIT_TAB_STATE_PRINTING)         ||
 	    (state == GEDIT_TAB_STATE_PRINT_PREVIEWING) ||
 	    (state == GEDIT_TAB_STATE_CLOSING))
 	{
@@ -444,7 +453,10 @@ set_view_properties_according_to_state (GeditTab      *tab,
 
 	view = gedit_view_frame_get_view (tab->priv->frame);
 
-	val = ((state == GEDIT_TAB_STATE_NORMAL) &&
+	/* The print job works on a snapshot of the document, so it
+	 * can still be edited while printing */
+	val = (((state == GEDIT_TAB_STATE_NORMAL) ||
+	        (state == GEDIT_TAB_STATE_PRINTING)) &&
 	       (tab->priv->print_preview == NULL) &&
 	       !tab->priv->not_editable);
 	gtk_text_view_set_editable (GTK_TEXT_VIEW (view), val);
@@ -1254,12 +1266,76 @@ unrecoverable_saving_error_info_bar_response (GtkWidget        *info_bar,
 	gtk_widget_grab_focus (GTK_WIDGET (view));
 }
 
+/* Selects the next or previous range of invalid chars from the selection,
+ * wrapping around the document.
+ */
+static void
+select_invalid_range (GeditTab *tab,
+                      gboolean  forward)
+{
+	GtkTextBuffer *buffer;
+	GtkTextIter sel_start;
+	GtkTextIter sel_end;
+	GtkTextIter start;
+	GtkTextIter end;
+	gboolean found;
+
+	buffer = GTK_TEXT_BUFFER (gedit_tab_get_document (tab));
+
+	gtk_text_buffer_get_selection_bounds (buffer, &sel_start, &sel_end);
+
+	if (forward)
+	{
+		found = _gedit_document_forward_invalid_range (GEDIT_DOCUMENT (buffer),
+		                                               &sel_end,
+		                                               &start,
+		                                               &end);
+
+		if (!found)
+		{
+			gtk_text_buffer_get_start_iter (buffer, &sel_end);
+			found = _gedit_document_forward_invalid_range (GEDIT_DOCUMENT (buffer),
+			                                               &sel_end,
+			                                               &start,
+			                                               &end);
+		}
+	}
+	else
+	{
+		found = _gedit_document_backward_invalid_range (GEDIT_DOCUMENT (buffer),
+		                                                &sel_start,
+		                                                &start,
+		                                                &end);
+
+		if (!found)
+		{
+			gtk_text_buffer_get_end_iter (buffer, &sel_start);
+			found = _gedit_document_backward_invalid_range (GEDIT_DOCUMENT (buffer),
+			                                                &sel_start,
+			                                                &start,
+			                                                &end);
+		}
+	}
+
+	if (found)
+	{
+		gtk_text_buffer_select_range (buffer, &start, &end);
+		scroll_to_cursor (tab);
+	}
+}
+
 static void
 invalid_character_info_bar_response (GtkWidget *info_bar,
                                      gint       response_id,
                                      GeditTab  *tab)
 {
-	if (response_id == GTK_RESPONSE_YES)
+	if (response_id == GEDIT_INVALID_CHARACTER_RESPONSE_PREVIOUS ||
+	    response_id == GEDIT_INVALID_CHARACTER_RESPONSE_NEXT)
+	{
+		select_invalid_range (tab,
+		                      response_id == GEDIT_INVALID_CHARACTER_RESPONSE_NEXT);
+	}
+	else if (response_id == GTK_RESPONSE_YES)
 	{
 		GeditDocument *doc;
 
@@ -1467,11 +1543,19 @@ document_saved (GeditDocument *document,
 		else if (error->domain == GEDIT_DOCUMENT_ERROR &&
 		         error->code == GEDIT_DOCUMENT_ERROR_CONVERSION_FALLBACK)
 		{
+			GtkTextIter start;
+
 			/* If we have any invalid char in the document we must warn the user
 			   as it can make the document useless if it is saved */
-			emsg = gedit_invalid_character_info_bar_new (tab->priv->tmp_save_location);
+			emsg = gedit_invalid_character_info_bar_new (tab->priv->tmp_save_location,
+			                                             _gedit_document_get_n_invalid_ranges (document));
 			g_return_if_fail (emsg != NULL);
 
+			/* Show the user where the first invalid chars are */
+			gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (document), &start);
+			gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (document), &start);
+			select_invalid_range (tab, TRUE);
+
 			g_signal_connect (emsg,
 			                  "response",
 			                  G_CALLBACK (invalid_character_info_bar_response),
@@ -1691,6 +1775,8 @@ gedit_tab_init (GeditTab *tab)
 	view = gedit_view_frame_get_view (tab->priv->frame);
 	g_object_set_data (G_OBJECT (view), GEDIT_TAB_KEY, tab);
 
+	tab->priv->journal = _gedit_recovery_journal_new (doc);
+
 	g_signal_connect (doc,
 			  "notify::location",
 			  G_CALLBACK (document_location_notify_handler),
@@ -2209,9 +2295,9 @@ gedit_tab_auto_save (GeditTab *tab)
 		gedit_debug_message (DEBUG_TAB, "Retry after 30 seconds");
 
 		/* Add a new timeout */
-		timeout = g_timeout_add_seconds (30,
-						 (GSourceFunc) gedit_tab_auto_save,
-						 tab);
+		timeout = _gedit_timer_add_seconds (30,
+						    (GSourceFunc) gedit_tab_auto_save,
+						    tab);
 
 		tab->priv->auto_save_timeout = timeout;
 
@@ -2708,7 +2794,8 @@ void
 _gedit_tab_mark_for_closing (GeditTab *tab)
 {
 	g_return_if_fail (GEDIT_IS_TAB (tab));
-	g_return_if_fail (tab->priv->state == GEDIT_TAB_STATE_NORMAL);
+	g_return_if_fail ((tab->priv->state == GEDIT_TAB_STATE_NORMAL) ||
+			  (tab->priv->state == GEDIT_TAB_STATE_GENERIC_NOT_EDITABLE));
 
 	gedit_tab_set_state (tab, GEDIT_TAB_STATE_CLOSING);
 }
@@ -2909,4 +2996,24 @@ _gedit_tab_get_view_frame (GeditTab *tab)
 	return GTK_WIDGET (tab->priv->frame);
 }
 
+/* Keeps the document from being edited, undone or saved while a long
+ * running operation changes it */
+void
+_gedit_tab_set_generic_not_editable (GeditTab *tab,
+				     gboolean  not_editable)
+{
+	g_return_if_fail (GEDIT_IS_TAB (tab));
+
+	if (not_editable)
+	{
+		g_return_if_fail (tab->priv->state == GEDIT_TAB_STATE_NORMAL);
+
+		gedit_tab_set_state (tab, GEDIT_TAB_STATE_GENERIC_NOT_EDITABLE);
+	}
+	else if (tab->priv->state == GEDIT_TAB_STATE_GENERIC_NOT_EDITABLE)
+	{
+		gedit_tab_set_state (tab, GEDIT_TAB_STATE_NORMAL);
+	}
+}
+
 /* ex:set ts=8 noet: */
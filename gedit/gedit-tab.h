@@ -177,6 +177,10 @@ gboolean	 _gedit_tab_get_can_close	(GeditTab	     *tab);
 
 GtkWidget	*_gedit_tab_get_view_frame	(GeditTab            *tab);
 
+void		 _gedit_tab_set_generic_not_editable
+						(GeditTab            *tab,
+						 gboolean             not_editable);
+
 G_END_DECLS
 
 #endif  /* __GEDIT_TAB_H__  */
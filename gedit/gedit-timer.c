@@ -0,0 +1,296 @@
+/*
+ * gedit-timer.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+/* A single main loop source for the timers that do not need to be run at
+ * an exact time, such as the autosave of each tab: with many tabs open,
+ * a source per tab means as many separate wakeups.
+ *
+ * Each timer is due at its deadline rounded up to a multiple of the
+ * largest power of two that fits in its slack, so timers of a similar interval
+ * end up due at the very same time. When the source wakes up, it also
+ * runs the timers that are past their deadline but could have waited a
+ * bit longer, so they don't need a wakeup of their own later.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gedit-timer.h"
+#include "gedit-debug.h"
+
+/* In ms. Also bounds how far in the queue a wakeup looks for timers
+ * that can be run early. */
+#define MAX_SLACK 60000
+
+typedef struct
+{
+	guint          id;
+	guint          interval;
+	guint          slack;
+
+	/* In ms of monotonic time */
+	gint64         deadline;
+	gint64         due;
+
+	GSourceFunc    function;
+	gpointer       data;
+
+	/* NULL while the timer is being run */
+	GSequenceIter *iter;
+
+	guint          removed : 1;
+} Timer;
+
+static GSequence *queue = NULL;
+static GHashTable *timers = NULL;
+static guint last_id = 0;
+
+static guint source_id = 0;
+static gint64 source_due = 0;
+static guint n_wakeups = 0;
+
+static gboolean dispatch_timers (gpointer user_data);
+
+static gint64
+get_now (void)
+{
+	return g_get_monotonic_time () / 1000;
+}
+
+static gint
+compare_timers (gconstpointer a,
+		gconstpointer b,
+		gpointer      user_data)
+{
+	const Timer *timer_a = a;
+	const Timer *timer_b = b;
+
+	if (timer_a->due != timer_b->due)
+		return timer_a->due < timer_b->due ? -1 : 1;
+
+	/* Keeps the order in which they were added */
+	if (timer_a->id != timer_b->id)
+		return timer_a->id < timer_b->id ? -1 : 1;
+
+	return 0;
+}
+
+static void
+arm_source (void)
+{
+	GSequenceIter *first;
+	Timer *timer;
+	gint64 now;
+
+	first = g_sequence_get_begin_iter (queue);
+
+	if (g_sequence_iter_is_end (first))
+	{
+		if (source_id != 0)
+		{
+			g_source_remove (source_id);
+			source_id = 0;
+		}
+
+		return;
+	}
+
+	timer = g_sequence_get (first);
+
+	if (source_id != 0)
+	{
+		if (source_due == timer->due)
+			return;
+
+		g_source_remove (source_id);
+	}
+
+	now = get_now ();
+
+	source_due = timer->due;
+	source_id = g_timeout_add (source_due > now ? source_due - now : 0,
+				   dispatch_timers,
+				   NULL);
+}
+
+static void
+schedule_timer (Timer  *timer,
+		gint64  now)
+{
+	gint64 granularity = 1;
+
+	while (granularity * 2 <= timer->slack)
+		granularity *= 2;
+
+	timer->deadline = now + timer->interval;
+	timer->due = (timer->deadline + granularity - 1) / granularity * granularity;
+
+	timer->iter = g_sequence_insert_sorted (queue, timer, compare_timers, NULL);
+}
+
+static void
+free_timer (Timer *timer)
+{
+	g_hash_table_remove (timers, GUINT_TO_POINTER (timer->id));
+	g_slice_free (Timer, timer);
+}
+
+static gboolean
+dispatch_timers (gpointer user_data)
+{
+	GSequenceIter *iter;
+	GSList *ready = NULL;
+	GSList *l;
+	guint n_run = 0;
+	gint64 now;
+
+	source_id = 0;
+	n_wakeups++;
+
+	now = get_now ();
+
+	/* The timers are taken out of the queue before running any of
+	 * them, since they can add and remove timers. */
+	iter = g_sequence_get_begin_iter (queue);
+
+	while (!g_sequence_iter_is_end (iter))
+	{
+		Timer *timer = g_sequence_get (iter);
+		GSequenceIter *next;
+
+		if (timer->due > now + MAX_SLACK)
+			break;
+
+		next = g_sequence_iter_next (iter);
+
+		if (timer->deadline <= now)
+		{
+			g_sequence_remove (iter);
+			timer->iter = NULL;
+
+			ready = g_slist_prepend (ready, timer);
+		}
+
+		iter = next;
+	}
+
+	ready = g_slist_reverse (ready);
+
+	for (l = ready; l != NULL; l = l->next)
+	{
+		Timer *timer = l->data;
+		gboolean again = FALSE;
+
+		if (!timer->removed)
+		{
+			again = timer->function (timer->data);
+			n_run++;
+		}
+
+		if (again && !timer->removed)
+			schedule_timer (timer, now);
+		else
+			free_timer (timer);
+	}
+
+	g_slist_free (ready);
+
+	gedit_debug_message (DEBUG_UTILS, "Wakeup %u: %u timers run, %d queued",
+			     n_wakeups,
+			     n_run,
+			     g_sequence_get_length (queue));
+
+	arm_source ();
+
+	return G_SOURCE_REMOVE;
+}
+
+guint
+_gedit_timer_add (guint        interval,
+		  guint        slack,
+		  GSourceFunc  function,
+		  gpointer     data)
+{
+	Timer *timer;
+
+	g_return_val_if_fail (function != NULL, 0);
+
+	if (queue == NULL)
+	{
+		queue = g_sequence_new (NULL);
+		timers = g_hash_table_new (g_direct_hash, g_direct_equal);
+	}
+
+	timer = g_slice_new0 (Timer);
+	timer->id = ++last_id;
+	timer->interval = interval;
+	timer->slack = MIN (slack, MAX_SLACK);
+	timer->function = function;
+	timer->data = data;
+
+	g_hash_table_insert (timers, GUINT_TO_POINTER (timer->id), timer);
+
+	schedule_timer (timer, get_now ());
+	arm_source ();
+
+	gedit_debug_message (DEBUG_UTILS, "Timer %u added, %d queued",
+			     timer->id,
+			     g_sequence_get_length (queue));
+
+	return timer->id;
+}
+
+guint
+_gedit_timer_add_seconds (guint        interval,
+			  GSourceFunc  function,
+			  gpointer     data)
+{
+	return _gedit_timer_add (interval * 1000,
+				 MAX (interval * 100, 1000),
+				 function,
+				 data);
+}
+
+void
+_gedit_timer_remove (guint id)
+{
+	Timer *timer;
+
+	timer = timers != NULL ? g_hash_table_lookup (timers, GUINT_TO_POINTER (id)) : NULL;
+
+	g_return_if_fail (timer != NULL);
+
+	/* It is freed once the wakeup running it is done with it */
+	if (timer->iter == NULL)
+	{
+		timer->removed = TRUE;
+		return;
+	}
+
+	g_sequence_remove (timer->iter);
+	free_timer (timer);
+
+	arm_source ();
+}
+
+/* ex:set ts=8 noet: */
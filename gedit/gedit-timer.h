@@ -0,0 +1,52 @@
+/*
+ * gedit-timer.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GEDIT_TIMER_H__
+#define __GEDIT_TIMER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Like g_timeout_add(), but the callback can be run up to @slack ms
+ * late, so that it shares the wakeup of the other timers due around the
+ * same time. Returns an id for _gedit_timer_remove(), never 0.
+ */
+guint		 _gedit_timer_add		(guint          interval,
+						 guint          slack,
+						 GSourceFunc    function,
+						 gpointer       data);
+
+/* Like g_timeout_add_seconds(), with a slack of a tenth of the interval,
+ * of at least one second.
+ */
+guint		 _gedit_timer_add_seconds	(guint          interval,
+						 GSourceFunc    function,
+						 gpointer       data);
+
+void		 _gedit_timer_remove		(guint          id);
+
+G_END_DECLS
+
+#endif /* __GEDIT_TIMER_H__ */
+
+/* ex:set ts=8 noet: */
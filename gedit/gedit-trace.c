@@ -0,0 +1,199 @@
+/*
+ * gedit-trace.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+/* Records how long each phase of opening and saving files takes, so that
+ * slow loads and saves can be looked at after the fact, for example from
+ * a network mount.
+ *
+ * The spans are kept in a fixed ring of the last TRACE_RING_SIZE events.
+ * Recording a span never takes a lock: a slot is claimed with an atomic
+ * increment and its sequence number is only published once the slot is
+ * filled in, so a reader running at the same time just skips the slots
+ * being written. The ring is exported in the Chrome trace event format,
+ * which can be opened in chrome://tracing.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gedit-trace.h"
+
+#include <unistd.h>
+
+/* Must be a power of two */
+#define TRACE_RING_SIZE 4096
+
+typedef struct
+{
+	/* 0 while the slot is being written, otherwise its index + 1 */
+	guint          seq;
+
+	const gchar   *category;
+	const gchar   *name;
+	gconstpointer  id;
+	gint64         begin;
+	gint64         duration;
+	gint64         bytes;
+} TraceEvent;
+
+static TraceEvent ring[TRACE_RING_SIZE];
+static gint ring_head = 0;
+
+void
+gedit_trace_end (const gchar   *category,
+		 const gchar   *name,
+		 gconstpointer  id,
+		 gint64         begin,
+		 gint64         bytes)
+{
+	TraceEvent *event;
+	gint64 now;
+	guint index;
+
+	now = g_get_monotonic_time ();
+
+	index = (guint) g_atomic_int_add (&ring_head, 1);
+	event = &ring[index & (TRACE_RING_SIZE - 1)];
+
+	g_atomic_int_set ((gint *) &event->seq, 0);
+
+	event->category = category;
+	event->name = name;
+	event->id = id;
+	event->begin = begin;
+	event->duration = now - begin;
+	event->bytes = bytes;
+
+	g_atomic_int_set ((gint *) &event->seq, (gint) (index + 1));
+}
+
+static gboolean
+read_event (guint       index,
+	    TraceEvent *copy)
+{
+	TraceEvent *event = &ring[index & (TRACE_RING_SIZE - 1)];
+
+	if ((guint) g_atomic_int_get ((gint *) &event->seq) != index + 1)
+		return FALSE;
+
+	*copy = *event;
+
+	/* It was overwritten while we were copying it */
+	return (guint) g_atomic_int_get ((gint *) &event->seq) == index + 1;
+}
+
+/**
+ * gedit_trace_to_json:
+ *
+ * Returns: the recorded spans as a Chrome trace, free with g_free().
+ */
+gchar *
+gedit_trace_to_json (void)
+{
+	GString *json;
+	GHashTable *tracks;
+	guint head;
+	guint first;
+	guint index;
+	gint pid;
+	gboolean empty = TRUE;
+
+	json = g_string_new ("{\"traceEvents\":[");
+
+	/* Each document gets a track of its own, numbered in the order
+	 * they appear, since the spans of different documents overlap. */
+	tracks = g_hash_table_new (g_direct_hash, g_direct_equal);
+	pid = getpid ();
+
+	head = (guint) g_atomic_int_get (&ring_head);
+	first = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+
+	for (index = first; index != head; index++)
+	{
+		TraceEvent event;
+		guint tid;
+
+		if (!read_event (index, &event))
+			continue;
+
+		tid = GPOINTER_TO_UINT (g_hash_table_lookup (tracks, event.id));
+
+		if (tid == 0)
+		{
+			tid = g_hash_table_size (tracks) + 1;
+			g_hash_table_insert (tracks, (gpointer) event.id, GUINT_TO_POINTER (tid));
+
+			g_string_append_printf (json,
+						"%s{\"name\":\"thread_name\",\"ph\":\"M\","
+						"\"pid\":%d,\"tid\":%u,"
+						"\"args\":{\"name\":\"document %u\"}}",
+						empty ? "" : ",",
+						pid, tid, tid);
+
+			empty = FALSE;
+		}
+
+		g_string_append_printf (json,
+					"%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+					"\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ","
+					"\"pid\":%d,\"tid\":%u",
+					empty ? "" : ",",
+					event.name, event.category,
+					event.begin, event.duration,
+					pid, tid);
+
+		if (event.bytes >= 0)
+		{
+			g_string_append_printf (json,
+						",\"args\":{\"bytes\":%" G_GINT64_FORMAT "}",
+						event.bytes);
+		}
+
+		g_string_append_c (json, '}');
+		empty = FALSE;
+	}
+
+	g_string_append (json, "],\"displayTimeUnit\":\"ms\"}\n");
+
+	g_hash_table_destroy (tracks);
+
+	return g_string_free (json, FALSE);
+}
+
+gboolean
+gedit_trace_write_file (const gchar  *filename,
+			GError      **error)
+{
+	gchar *json;
+	gboolean ret;
+
+	g_return_val_if_fail (filename != NULL, FALSE);
+
+	json = gedit_trace_to_json ();
+	ret = g_file_set_contents (filename, json, -1, error);
+	g_free (json);
+
+	return ret;
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,56 @@
+/*
+ * gedit-trace.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GEDIT_TRACE_H__
+#define __GEDIT_TRACE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define GEDIT_TRACE_LOADER	"loader"
+#define GEDIT_TRACE_SAVER	"saver"
+#define GEDIT_TRACE_DOCUMENT	"document"
+
+/* The start of a span, to be given back to gedit_trace_end() */
+#define gedit_trace_begin()	g_get_monotonic_time ()
+
+/* @category and @name must be static strings. @id identifies the
+ * document the span belongs to, spans with the same id are shown on the
+ * same track. @bytes is -1 when the span did not move any data.
+ */
+void		 gedit_trace_end		(const gchar   *category,
+						 const gchar   *name,
+						 gconstpointer  id,
+						 gint64         begin,
+						 gint64         bytes);
+
+gchar		*gedit_trace_to_json		(void);
+
+gboolean	 gedit_trace_write_file		(const gchar   *filename,
+						 GError       **error);
+
+G_END_DECLS
+
+#endif /* __GEDIT_TRACE_H__ */
+
+/* ex:set ts=8 noet: */
@@ -27,6 +27,8 @@
 
 #include "gedit-view-frame.h"
 #include "gedit-debug.h"
+#include "gedit-occurrence-index.h"
+#include "gedit-timer.h"
 #include "gedit-utils.h"
 #include "libgd/gd.h"
 
@@ -88,6 +90,11 @@ struct _GeditViewFramePrivate
 	 */
 	gchar *search_text;
 	gchar *old_search_text;
+
+	/* Counts the occurrences incrementally, so the entry tag can be
+	 * shown before the search context has scanned the whole buffer.
+	 */
+	GeditOccurrenceIndex *occurrence_index;
 };
 
 enum
@@ -99,6 +106,8 @@ enum
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeditViewFrame, gedit_view_frame, GTK_TYPE_OVERLAY)
 
+static void install_update_entry_tag_idle (GeditViewFrame *frame);
+
 static void
 gedit_view_frame_dispose (GObject *object)
 {
@@ -114,7 +123,7 @@ gedit_view_frame_dispose (GObject *object)
 
 	if (frame->priv->flush_timeout_id != 0)
 	{
-		g_source_remove (frame->priv->flush_timeout_id);
+		_gedit_timer_remove (frame->priv->flush_timeout_id);
 		frame->priv->flush_timeout_id = 0;
 	}
 
@@ -130,6 +139,12 @@ gedit_view_frame_dispose (GObject *object)
 		frame->priv->remove_entry_tag_timeout_id = 0;
 	}
 
+	if (frame->priv->occurrence_index != NULL)
+	{
+		gedit_occurrence_index_free (frame->priv->occurrence_index);
+		frame->priv->occurrence_index = NULL;
+	}
+
 	g_clear_object (&frame->priv->entry_tag);
 	g_clear_object (&frame->priv->search_settings);
 	g_clear_object (&frame->priv->old_search_settings);
@@ -192,7 +207,7 @@ hide_search_widget (GeditViewFrame *frame,
 
 	if (frame->priv->flush_timeout_id != 0)
 	{
-		g_source_remove (frame->priv->flush_timeout_id);
+		_gedit_timer_remove (frame->priv->flush_timeout_id);
 		frame->priv->flush_timeout_id = 0;
 	}
 
@@ -217,6 +232,13 @@ hide_search_widget (GeditViewFrame *frame,
 		frame->priv->start_mark = NULL;
 	}
 
+	/* Don't keep the index up to date while the search is not shown */
+	if (frame->priv->occurrence_index != NULL)
+	{
+		gedit_occurrence_index_free (frame->priv->occurrence_index);
+		frame->priv->occurrence_index = NULL;
+	}
+
 	gtk_widget_grab_focus (GTK_WIDGET (frame->priv->view));
 }
 
@@ -234,13 +256,13 @@ renew_flush_timeout (GeditViewFrame *frame)
 {
 	if (frame->priv->flush_timeout_id != 0)
 	{
-		g_source_remove (frame->priv->flush_timeout_id);
+		_gedit_timer_remove (frame->priv->flush_timeout_id);
 	}
 
 	frame->priv->flush_timeout_id =
-		g_timeout_add_seconds (FLUSH_TIMEOUT_DURATION,
-				       (GSourceFunc)search_entry_flush_timeout,
-				       frame);
+		_gedit_timer_add_seconds (FLUSH_TIMEOUT_DURATION,
+					  (GSourceFunc)search_entry_flush_timeout,
+					  frame);
 }
 
 static GtkSourceSearchContext *
@@ -268,6 +290,29 @@ get_search_context (GeditViewFrame *frame)
 	return NULL;
 }
 
+/* Returns NULL while the search is not shown, the index is only kept
+ * up to date as long as it is */
+static GeditOccurrenceIndex *
+get_occurrence_index (GeditViewFrame *frame)
+{
+	if (!gtk_revealer_get_reveal_child (frame->priv->revealer))
+	{
+		return NULL;
+	}
+
+	if (frame->priv->occurrence_index == NULL)
+	{
+		GtkTextBuffer *buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (frame->priv->view));
+
+		frame->priv->occurrence_index =
+			gedit_occurrence_index_new (buffer,
+						    (GeditOccurrenceIndexNotify)install_update_entry_tag_idle,
+						    frame);
+	}
+
+	return frame->priv->occurrence_index;
+}
+
 static void
 set_search_state (GeditViewFrame *frame,
 		  SearchState     state)
@@ -356,6 +401,7 @@ start_search (GeditViewFrame *frame)
 	GtkTextIter start_at;
 	GtkTextBuffer *buffer;
 	GtkSourceSearchContext *search_context;
+	GeditOccurrenceIndex *index;
 
 	g_return_if_fail (frame->priv->search_mode == SEARCH);
 
@@ -372,6 +418,31 @@ start_search (GeditViewFrame *frame)
 					  &start_at,
 					  frame->priv->start_mark);
 
+	/* The region around the start mark is indexed synchronously, so if a
+	 * match is there we can select it directly instead of waiting for the
+	 * search context. The asynchronous search is still needed for the
+	 * cases not handled by the index, and it selects the same match.
+	 */
+	index = get_occurrence_index (frame);
+
+	if (index != NULL &&
+	    gedit_occurrence_index_set_settings (index,
+						 frame->priv->search_settings,
+						 &start_at))
+	{
+		GtkTextIter match_start;
+		GtkTextIter match_end;
+
+		if (gedit_occurrence_index_forward (index,
+						    &start_at,
+						    &match_start,
+						    &match_end))
+		{
+			gtk_text_buffer_select_range (buffer, &match_start, &match_end);
+			finish_search (frame, TRUE);
+		}
+	}
+
 	gtk_source_search_context_forward_async (search_context,
 						 &start_at,
 						 NULL,
@@ -643,6 +714,7 @@ static void
 update_entry_tag (GeditViewFrame *frame)
 {
 	GtkSourceSearchContext *search_context;
+	GeditOccurrenceIndex *index;
 	GtkTextBuffer *buffer;
 	GtkTextIter select_start;
 	GtkTextIter select_end;
@@ -650,6 +722,12 @@ update_entry_tag (GeditViewFrame *frame)
 	gint pos;
 	gchar *label;
 
+	/* Nothing to show, and the index must not be created again */
+	if (!gtk_revealer_get_reveal_child (frame->priv->revealer))
+	{
+		return;
+	}
+
 	if (frame->priv->search_mode == GOTO_LINE)
 	{
 		gd_tagged_entry_remove_tag (frame->priv->search_entry,
@@ -664,14 +742,55 @@ update_entry_tag (GeditViewFrame *frame)
 		return;
 	}
 
-	count = gtk_source_search_context_get_occurrences_count (search_context);
-
 	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (frame->priv->view));
 	gtk_text_buffer_get_selection_bounds (buffer, &select_start, &select_end);
 
-	pos = gtk_source_search_context_get_occurrence_position (search_context,
-								 &select_start,
-								 &select_end);
+	index = get_occurrence_index (frame);
+
+	if (index != NULL &&
+	    gedit_occurrence_index_set_settings (index,
+						 frame->priv->search_settings,
+						 &select_start))
+	{
+		gboolean complete;
+
+		count = gedit_occurrence_index_get_count (index, &complete);
+
+		pos = gedit_occurrence_index_get_position (index,
+							   &select_start,
+							   &select_end);
+
+		if (!complete && count > 0)
+		{
+			if (frame->priv->remove_entry_tag_timeout_id != 0)
+			{
+				g_source_remove (frame->priv->remove_entry_tag_timeout_id);
+				frame->priv->remove_entry_tag_timeout_id = 0;
+			}
+
+			/* Translators: %d is the number of search occurrences
+			 * found so far, the rest of the document is still being
+			 * scanned.
+			 */
+			label = g_strdup_printf (_("%d so far"), count);
+
+			gd_tagged_entry_tag_set_label (frame->priv->entry_tag, label);
+
+			gd_tagged_entry_add_tag (frame->priv->search_entry,
+						 frame->priv->entry_tag);
+
+			g_free (label);
+			return;
+		}
+	}
+	else
+	{
+		count = gtk_source_search_context_get_occurrences_count (search_context);
+
+		pos = gtk_source_search_context_get_occurrence_position (search_context,
+									 &select_start,
+									 &select_end);
+	}
 
 	if (count == -1 || pos == -1)
 	{
@@ -870,7 +989,7 @@ setup_popup_menu (GeditViewFrame *frame,
 {
 	if (frame->priv->flush_timeout_id != 0)
 	{
-		g_source_remove (frame->priv->flush_timeout_id);
+		_gedit_timer_remove (frame->priv->flush_timeout_id);
 		frame->priv->flush_timeout_id = 0;
 	}
 
@@ -54,6 +54,11 @@
 
 #define GEDIT_VIEW_SCROLL_MARGIN 0.02
 
+/* Beyond this number of characters between the cached position and the
+ * new one, the visual column is computed from the start of the line.
+ */
+#define VISUAL_COLUMN_MAX_DELTA 256
+
 enum
 {
 	TARGET_URI_LIST = 100,
@@ -67,6 +72,16 @@ struct _GeditViewPrivate
 	GtkTextBuffer *current_buffer;
 	PeasExtensionSet *extensions;
 	gchar *direct_save_uri;
+
+	/* Last position whose visual column was computed. The mark has a
+	 * left gravity, and the cache is invalidated when the text before
+	 * it on its line changes, so the column can be updated from the
+	 * characters between the mark and the next position.
+	 */
+	GtkTextMark *column_mark;
+	guint column;
+	guint column_tab_width;
+	guint column_valid : 1;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeditView, gedit_view, GTK_SOURCE_TYPE_VIEW)
@@ -91,11 +106,103 @@ document_read_only_notify_handler (GeditDocument *document,
 				    !gedit_document_get_readonly (document));
 }
 
+static void
+column_insert_text_cb (GtkTextBuffer *buffer,
+		       GtkTextIter   *location,
+		       const gchar   *text,
+		       gint           len,
+		       GeditView     *view)
+{
+	GtkTextIter mark_iter;
+
+	if (!view->priv->column_valid)
+		return;
+
+	gtk_text_buffer_get_iter_at_mark (buffer, &mark_iter, view->priv->column_mark);
+
+	if (gtk_text_iter_get_line (location) == gtk_text_iter_get_line (&mark_iter) &&
+	    gtk_text_iter_compare (location, &mark_iter) < 0)
+	{
+		view->priv->column_valid = FALSE;
+	}
+}
+
+static void
+column_delete_range_cb (GtkTextBuffer *buffer,
+			GtkTextIter   *start,
+			GtkTextIter   *end,
+			GeditView     *view)
+{
+	GtkTextIter mark_iter;
+	GtkTextIter iter;
+	gint n_chars;
+
+	if (!view->priv->column_valid)
+		return;
+
+	gtk_text_buffer_get_iter_at_mark (buffer, &mark_iter, view->priv->column_mark);
+
+	if (gtk_text_iter_compare (start, &mark_iter) >= 0)
+		return;
+
+	if (gtk_text_iter_get_line (start) != gtk_text_iter_get_line (&mark_iter))
+	{
+		/* Only the lines before are modified, unless the newline
+		 * that ends the previous line is removed.
+		 */
+		if (gtk_text_iter_get_line (end) >= gtk_text_iter_get_line (&mark_iter))
+		{
+			view->priv->column_valid = FALSE;
+		}
+
+		return;
+	}
+
+	/* Typically a backspace: the mark moves to @start, the column
+	 * decreases by the number of removed characters if none of them is a
+	 * tab.
+	 */
+	n_chars = gtk_text_iter_get_offset (&mark_iter) - gtk_text_iter_get_offset (start);
+
+	if (n_chars > VISUAL_COLUMN_MAX_DELTA)
+	{
+		view->priv->column_valid = FALSE;
+		return;
+	}
+
+	for (iter = *start; gtk_text_iter_compare (&iter, &mark_iter) < 0; gtk_text_iter_forward_char (&iter))
+	{
+		if (gtk_text_iter_get_char (&iter) == '\t')
+		{
+			view->priv->column_valid = FALSE;
+			return;
+		}
+	}
+
+	view->priv->column -= n_chars;
+}
+
 static void
 current_buffer_removed (GeditView *view)
 {
 	if (view->priv->current_buffer)
 	{
+		g_signal_handlers_disconnect_by_func (view->priv->current_buffer,
+						      column_insert_text_cb,
+						      view);
+		g_signal_handlers_disconnect_by_func (view->priv->current_buffer,
+						      column_delete_range_cb,
+						      view);
+
+		if (view->priv->column_mark != NULL)
+		{
+			gtk_text_buffer_delete_mark (view->priv->current_buffer,
+						     view->priv->column_mark);
+			view->priv->column_mark = NULL;
+		}
+
+		view->priv->column_valid = FALSE;
+
 		g_signal_handlers_disconnect_by_func (view->priv->current_buffer,
 						      document_read_only_notify_handler,
 						      view);
@@ -123,6 +230,14 @@ on_notify_buffer_cb (GeditView  *view,
 			  "notify::read-only",
 			  G_CALLBACK (document_read_only_notify_handler),
 			  view);
+	g_signal_connect (buffer,
+			  "insert-text",
+			  G_CALLBACK (column_insert_text_cb),
+			  view);
+	g_signal_connect (buffer,
+			  "delete-range",
+			  G_CALLBACK (column_delete_range_cb),
+			  view);
 
 	gtk_text_view_set_editable (GTK_TEXT_VIEW (view),
 				    !gedit_document_get_readonly (GEDIT_DOCUMENT (buffer)));
@@ -1000,6 +1115,96 @@ gedit_view_scroll_to_cursor (GeditView *view)
 	                              0.0);
 }
 
+/* Same as gtk_source_view_get_visual_column(), but when @iter is near the
+ * position of the previous call on the same line, only the characters in
+ * between are looked at. This keeps the statusbar fast on very long lines.
+ */
+guint
+_gedit_view_get_visual_column (GeditView         *view,
+			       const GtkTextIter *iter)
+{
+	GtkTextBuffer *buffer;
+	guint tab_width;
+
+	g_return_val_if_fail (GEDIT_IS_VIEW (view), 0);
+	g_return_val_if_fail (iter != NULL, 0);
+
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+	tab_width = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view));
+
+	/* The edits are only tracked on the current document */
+	if (buffer != view->priv->current_buffer)
+	{
+		return gtk_source_view_get_visual_column (GTK_SOURCE_VIEW (view), iter);
+	}
+
+	if (view->priv->column_valid &&
+	    view->priv->column_tab_width == tab_width)
+	{
+		GtkTextIter mark_iter;
+		gint delta;
+
+		gtk_text_buffer_get_iter_at_mark (buffer, &mark_iter, view->priv->column_mark);
+		delta = gtk_text_iter_get_offset (iter) - gtk_text_iter_get_offset (&mark_iter);
+
+		if (gtk_text_iter_get_line (iter) == gtk_text_iter_get_line (&mark_iter) &&
+		    ABS (delta) <= VISUAL_COLUMN_MAX_DELTA)
+		{
+			guint column = view->priv->column;
+			GtkTextIter pos;
+			gboolean found_tab = FALSE;
+
+			if (delta >= 0)
+			{
+				for (pos = mark_iter; gtk_text_iter_compare (&pos, iter) < 0; gtk_text_iter_forward_char (&pos))
+				{
+					if (gtk_text_iter_get_char (&pos) == '\t')
+						column += tab_width - (column % tab_width);
+					else
+						column++;
+				}
+			}
+			else
+			{
+				/* Going backward, tabs can't be undone */
+				for (pos = *iter; gtk_text_iter_compare (&pos, &mark_iter) < 0; gtk_text_iter_forward_char (&pos))
+				{
+					if (gtk_text_iter_get_char (&pos) == '\t')
+					{
+						found_tab = TRUE;
+						break;
+					}
+				}
+
+				column += delta;
+			}
+
+			if (!found_tab)
+			{
+				view->priv->column = column;
+				gtk_text_buffer_move_mark (buffer, view->priv->column_mark, iter);
+
+				return column;
+			}
+		}
+	}
+
+	view->priv->column = gtk_source_view_get_visual_column (GTK_SOURCE_VIEW (view), iter);
+	view->priv->column_tab_width = tab_width;
+	view->priv->column_valid = TRUE;
+
+	if (view->priv->column_mark == NULL)
+	{
+		view->priv->column_mark = gtk_text_buffer_create_mark (buffer, NULL, iter, TRUE);
+	}
+	else
+	{
+		gtk_text_buffer_move_mark (buffer, view->priv->column_mark, iter);
+	}
+
+	return view->priv->column;
+}
+
 /* FIXME this is an issue for introspection */
 /**
  * gedit_view_set_font:
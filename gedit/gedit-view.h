@@ -98,6 +98,12 @@ void 		 gedit_view_set_font		(GeditView       *view,
 						 gboolean         def,
 						 const gchar     *font_name);
 
+/*
+ * Non exported functions
+ */
+guint		 _gedit_view_get_visual_column	(GeditView         *view,
+						 const GtkTextIter *iter);
+
 G_END_DECLS
 
 #endif /* __GEDIT_VIEW_H__ */
@@ -57,6 +57,7 @@ struct _GeditWindowPrivate
 	GtkWidget      *side_panel;
 	GtkWidget      *bottom_panel_box;
 	GtkWidget      *bottom_panel;
+	GtkWidget      *search_panel;
 
 	GtkWidget      *hpaned;
 	GtkWidget      *vpaned;
@@ -74,6 +75,7 @@ struct _GeditWindowPrivate
 
 	/* statusbar and context ids for statusbar messages */
 	GtkWidget      *statusbar;
+	guint           cursor_position_tick_id;
 	GtkWidget      *tab_width_combo;
 	GtkWidget      *tab_width_combo_menu;
 	GtkWidget      *language_button;
@@ -113,6 +115,9 @@ struct _GeditWindowPrivate
 
 	gint            bottom_panel_item_removed_handler_id;
 
+	gulong          save_progress_handler_id;
+	guint           save_progress_message_id;
+
 	GtkWindowGroup *window_group;
 
 	GFile          *default_location;
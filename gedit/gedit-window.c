@@ -53,6 +53,7 @@
 #include "gedit-debug.h"
 #include "gedit-open-menu-button.h"
 #include "gedit-documents-panel.h"
+#include "gedit-search-panel.h"
 #include "gedit-plugins-engine.h"
 #include "gedit-window-activatable.h"
 #include "gedit-enum-types.h"
@@ -63,6 +64,7 @@
 #include "gedit-document.h"
 #include "gedit-small-button.h"
 #include "gedit-menu-stack-switcher.h"
+#include "gedit-save-scheduler.h"
 
 #define TAB_WIDTH_DATA "GeditWindowTabWidthData"
 #define FULLSCREEN_ANIMATION_SPEED 4
@@ -198,6 +200,13 @@ gedit_window_dispose (GObject *object)
 		window->priv->bottom_panel_item_removed_handler_id = 0;
 	}
 
+	if (window->priv->save_progress_handler_id != 0)
+	{
+		g_signal_handler_disconnect (_gedit_save_scheduler_get_default (),
+					     window->priv->save_progress_handler_id);
+		window->priv->save_progress_handler_id = 0;
+	}
+
 	/* First of all, force collection so that plugins
 	 * really drop some of the references.
 	 */
@@ -225,6 +234,13 @@ gedit_window_dispose (GObject *object)
 		window->priv->fullscreen_animation_timeout_id = 0;
 	}
 
+	if (window->priv->cursor_position_tick_id != 0)
+	{
+		gtk_widget_remove_tick_callback (window->priv->statusbar,
+						 window->priv->cursor_position_tick_id);
+		window->priv->cursor_position_tick_id = 0;
+	}
+
 	if (window->priv->fullscreen_controls != NULL)
 	{
 		gtk_widget_destroy (window->priv->fullscreen_controls);
@@ -509,12 +525,13 @@ received_clipboard_contents (GtkClipboard     *clipboard,
 	if (tab != NULL)
 	{
 		GeditTabState state;
-		gboolean state_normal;
+		gboolean state_editing;
 
 		state = gedit_tab_get_state (tab);
-		state_normal = (state == GEDIT_TAB_STATE_NORMAL);
+		state_editing = (state == GEDIT_TAB_STATE_NORMAL ||
+		                 state == GEDIT_TAB_STATE_PRINTING);
 
-		enabled = state_normal &&
+		enabled = state_editing &&
 		          gtk_selection_data_targets_include_text (selection_data);
 	}
 	else
@@ -572,6 +589,7 @@ set_sensitivity_according_to_tab (GeditWindow *window,
 	GAction *action;
 	gboolean b;
 	gboolean state_normal;
+	gboolean state_editing;
 	gboolean editable;
 	GeditTabState state;
 	GtkClipboard *clipboard;
@@ -590,6 +608,11 @@ set_sensitivity_according_to_tab (GeditWindow *window,
 	state = gedit_tab_get_state (tab);
 	state_normal = (state == GEDIT_TAB_STATE_NORMAL);
 
+	/* The document can be edited while it is printed, the print job
+	 * works on a snapshot of it */
+	state_editing = (state_normal ||
+	                 state == GEDIT_TAB_STATE_PRINTING);
+
 	view = gedit_tab_get_view (tab);
 	editable = gtk_text_view_get_editable (GTK_TEXT_VIEW (view));
 
@@ -637,28 +660,28 @@ set_sensitivity_according_to_tab (GeditWindow *window,
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "undo");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     state_normal &&
+				     state_editing &&
 				     gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (doc)));
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "redo");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     state_normal &&
+				     state_editing &&
 				     gtk_source_buffer_can_redo (GTK_SOURCE_BUFFER (doc)));
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "cut");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     state_normal &&
+				     state_editing &&
 				     editable &&
 				     gtk_text_buffer_get_has_selection (GTK_TEXT_BUFFER (doc)));
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "copy");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     (state_normal ||
+				     (state_editing ||
 				      state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION) &&
 				     gtk_text_buffer_get_has_selection (GTK_TEXT_BUFFER (doc)));
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "paste");
-	if (state_normal && editable)
+	if (state_editing && editable)
 	{
 		set_paste_sensitivity_according_to_clipboard (window,
 							      clipboard);
@@ -670,39 +693,39 @@ set_sensitivity_according_to_tab (GeditWindow *window,
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "delete");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     state_normal &&
+				     state_editing &&
 				     editable &&
 				     gtk_text_buffer_get_has_selection (GTK_TEXT_BUFFER (doc)));
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "find");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     (state_normal ||
+				     (state_editing ||
 				      state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION));
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "replace");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     state_normal &&
+				     state_editing &&
 				     editable);
 
 	b = !_gedit_document_get_empty_search (doc);
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "find_next");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     (state_normal ||
+				     (state_editing ||
 				      state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION) && b);
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "find_prev");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     (state_normal ||
+				     (state_editing ||
 				      state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION) && b);
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "clear_highlight");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     (state_normal ||
+				     (state_editing ||
 				      state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION) && b);
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "goto_line");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     (state_normal ||
+				     (state_editing ||
 				      state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION));
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "highlight_mode");
@@ -962,6 +985,42 @@ create_language_button (GeditWindow *window)
 	                  G_CALLBACK (on_language_button_clicked), window);
 }
 
+/* When several files are being saved, for example with Save All, show
+ * how many of them are done */
+static void
+save_progress (GeditSaveScheduler *scheduler,
+	       guint               n_saved,
+	       guint               n_total,
+	       GeditWindow        *window)
+{
+	/* Only the message pushed here is removed, the scheduler is shared
+	 * by all the windows */
+	if (window->priv->save_progress_message_id != 0)
+	{
+		gtk_statusbar_remove (GTK_STATUSBAR (window->priv->statusbar),
+				      window->priv->generic_message_cid,
+				      window->priv->save_progress_message_id);
+		window->priv->save_progress_message_id = 0;
+	}
+
+	if (n_total > 1 && n_saved < n_total)
+	{
+		gchar *msg;
+
+		msg = g_strdup_printf (ngettext ("Saved %u of %u file",
+						 "Saved %u of %u files",
+						 n_total),
+				       n_saved, n_total);
+
+		window->priv->save_progress_message_id =
+			gtk_statusbar_push (GTK_STATUSBAR (window->priv->statusbar),
+					    window->priv->generic_message_cid,
+					    msg);
+
+		g_free (msg);
+	}
+}
+
 static void
 setup_statusbar (GeditWindow *window)
 {
@@ -977,6 +1036,12 @@ setup_statusbar (GeditWindow *window)
 	create_tab_width_combo (window);
 	create_language_button (window);
 
+	window->priv->save_progress_handler_id =
+		g_signal_connect (_gedit_save_scheduler_get_default (),
+				  "progress",
+				  G_CALLBACK (save_progress),
+				  window);
+
 	g_settings_bind (window->priv->ui_settings,
 	                 "statusbar-visible",
 	                 window->priv->statusbar,
@@ -1088,7 +1153,7 @@ update_cursor_position_statusbar (GtkTextBuffer *buffer,
 					  gtk_text_buffer_get_insert (buffer));
 
 	row = gtk_text_iter_get_line (&iter);
-	col = gtk_source_view_get_visual_column (GTK_SOURCE_VIEW (view), &iter);
+	col = _gedit_view_get_visual_column (view, &iter);
 
 	gedit_statusbar_set_cursor_position (
 				GEDIT_STATUSBAR (window->priv->statusbar),
@@ -1096,6 +1161,49 @@ update_cursor_position_statusbar (GtkTextBuffer *buffer,
 				col + 1);
 }
 
+static gboolean
+cursor_position_tick_cb (GtkWidget     *widget,
+			 GdkFrameClock *frame_clock,
+			 GeditWindow   *window)
+{
+	GeditDocument *doc;
+
+	window->priv->cursor_position_tick_id = 0;
+
+	doc = gedit_window_get_active_document (window);
+
+	if (doc != NULL)
+	{
+		update_cursor_position_statusbar (GTK_TEXT_BUFFER (doc), window);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* The cursor can move many times between two frames, e.g. when
+ * inserting text, so the statusbar is updated at most once per frame.
+ */
+static void
+cursor_moved_cb (GtkTextBuffer *buffer,
+		 GeditWindow   *window)
+{
+	if (buffer != GTK_TEXT_BUFFER (gedit_window_get_active_document (window)))
+		return;
+
+	if (!gtk_widget_get_mapped (window->priv->statusbar))
+	{
+		update_cursor_position_statusbar (buffer, window);
+	}
+	else if (window->priv->cursor_position_tick_id == 0)
+	{
+		window->priv->cursor_position_tick_id =
+			gtk_widget_add_tick_callback (window->priv->statusbar,
+						      (GtkTickCallback)cursor_position_tick_cb,
+						      window,
+						      NULL);
+	}
+}
+
 static void
 update_overwrite_mode_statusbar (GtkTextView *view,
 				 GeditWindow *window)
@@ -2126,7 +2234,7 @@ selection_changed (GeditDocument *doc,
 	GeditView *view;
 	GAction *action;
 	GeditTabState state;
-	gboolean state_normal;
+	gboolean state_editing;
 	gboolean editable;
 
 	gedit_debug (DEBUG_WINDOW);
@@ -2136,26 +2244,27 @@ selection_changed (GeditDocument *doc,
 
 	tab = gedit_tab_get_from_document (doc);
 	state = gedit_tab_get_state (tab);
-	state_normal = (state == GEDIT_TAB_STATE_NORMAL);
+	state_editing = (state == GEDIT_TAB_STATE_NORMAL ||
+	                 state == GEDIT_TAB_STATE_PRINTING);
 
 	view = gedit_tab_get_view (tab);
 	editable = gtk_text_view_get_editable (GTK_TEXT_VIEW (view));
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "cut");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     state_normal &&
+				     state_editing &&
 				     editable &&
 				     gtk_text_buffer_get_has_selection (GTK_TEXT_BUFFER (doc)));
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "copy");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     (state_normal ||
+				     (state_editing ||
 				      state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION) &&
 				     gtk_text_buffer_get_has_selection (GTK_TEXT_BUFFER (doc)));
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "delete");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-				     state_normal &&
+				     state_editing &&
 				     editable &&
 				     gtk_text_buffer_get_has_selection (GTK_TEXT_BUFFER (doc)));
 
@@ -2302,7 +2411,7 @@ on_tab_added (GeditMultiNotebook *multi,
 			  window);
 	g_signal_connect (doc,
 			  "cursor-moved",
-			  G_CALLBACK (update_cursor_position_statusbar),
+			  G_CALLBACK (cursor_moved_cb),
 			  window);
 	g_signal_connect (doc,
 			  "notify::empty-search",
@@ -2374,7 +2483,7 @@ on_tab_removed (GeditMultiNotebook *multi,
 					      G_CALLBACK (bracket_matched_cb),
 					      window);
 	g_signal_handlers_disconnect_by_func (doc,
-					      G_CALLBACK (update_cursor_position_statusbar),
+					      G_CALLBACK (cursor_moved_cb),
 					      window);
 	g_signal_handlers_disconnect_by_func (doc,
 					      G_CALLBACK (empty_search_notify_cb),
@@ -3229,6 +3338,25 @@ _gedit_window_get_multi_notebook (GeditWindow *window)
 	return GTK_WIDGET (window->priv->multi_notebook);
 }
 
+GtkWidget *
+_gedit_window_get_search_panel (GeditWindow *window)
+{
+	g_return_val_if_fail (GEDIT_IS_WINDOW (window), NULL);
+
+	/* Created on demand, most windows never search in all documents */
+	if (window->priv->search_panel == NULL)
+	{
+		window->priv->search_panel = gedit_search_panel_new (window);
+		gtk_widget_show (window->priv->search_panel);
+		gtk_stack_add_titled (GTK_STACK (window->priv->bottom_panel),
+		                      window->priv->search_panel,
+		                      "GeditWindowSearchPanel",
+		                      _("Search Results"));
+	}
+
+	return window->priv->search_panel;
+}
+
 GtkWidget *
 _gedit_window_get_notebook (GeditWindow *window)
 {
@@ -154,6 +154,7 @@ GMenuModel       *_gedit_window_get_gear_menu           (GeditWindow         *wi
  */
 GtkWidget	*_gedit_window_get_multi_notebook	(GeditWindow         *window);
 GtkWidget	*_gedit_window_get_notebook		(GeditWindow         *window);
+GtkWidget	*_gedit_window_get_search_panel		(GeditWindow         *window);
 
 GeditWindow	*_gedit_window_move_tab_to_new_window	(GeditWindow         *window,
 							 GeditTab            *tab);
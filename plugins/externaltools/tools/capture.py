@@ -22,7 +22,7 @@ import os, sys, signal
 import locale
 import subprocess
 import fcntl
-from gi.repository import GLib, GObject
+from gi.repository import GLib, GObject, Gio
 
 class Capture(GObject.Object):
     CAPTURE_STDOUT = 0x01
@@ -30,12 +30,18 @@ class Capture(GObject.Object):
     CAPTURE_BOTH   = 0x03
     CAPTURE_NEEDS_SHELL = 0x04
     
-    WRITE_BUFFER_SIZE = 0x4000
+    WRITE_BUFFER_SIZE = 0x10000
+
+    # Output is read in large blocks and emitted as runs of complete lines,
+    # instead of one signal per line.
+    READ_BUFFER_SIZE = 0x10000
+    MAX_READS_PER_DISPATCH = 16
 
     __gsignals__ = {
         'stdout-line'  : (GObject.SIGNAL_RUN_LAST, GObject.TYPE_NONE, (GObject.TYPE_STRING,)),
         'stderr-line'  : (GObject.SIGNAL_RUN_LAST, GObject.TYPE_NONE, (GObject.TYPE_STRING,)),
         'begin-execute': (GObject.SIGNAL_RUN_LAST, GObject.TYPE_NONE, tuple()),
+        'end-input'    : (GObject.SIGNAL_RUN_LAST, GObject.TYPE_NONE, tuple()),
         'end-execute'  : (GObject.SIGNAL_RUN_LAST, GObject.TYPE_NONE, (GObject.TYPE_INT,))
     }
 
@@ -47,6 +53,7 @@ class Capture(GObject.Object):
         self.flags = self.CAPTURE_BOTH | self.CAPTURE_NEEDS_SHELL
         self.command = command
         self.input_text = None
+        self.input_document = None
 
     def set_env(self, **values):
         self.env.update(**values)
@@ -59,6 +66,20 @@ class Capture(GObject.Object):
 
     def set_input(self, text):
         self.input_text = text
+        self.input_document = None
+
+    def set_input_range(self, document, start, end):
+        """
+        Feeds the text between start and end to the command, read from the
+        document a chunk at a time while the command runs instead of being
+        copied first. Text inserted at start while the command runs, e.g.
+        its own output, is not fed back; neither is text inserted at end.
+        'end-input' is emitted once the document is not read anymore.
+        """
+        self.input_text = None
+        self.input_document = document
+        self.input_mark = document.create_mark(None, start, False)
+        self.input_end_mark = document.create_mark(None, end, True)
 
     def set_cwd(self, cwd):
         self.cwd = cwd
@@ -74,7 +95,7 @@ class Capture(GObject.Object):
             'env'  : self.env
         }
         
-        if self.input_text is not None:
+        if self.input_text is not None or self.input_document is not None:
             popen_args['stdin'] = subprocess.PIPE
         if self.flags & self.CAPTURE_STDOUT:
             popen_args['stdout'] = subprocess.PIPE
@@ -82,16 +103,19 @@ class Capture(GObject.Object):
             popen_args['stderr'] = subprocess.PIPE
 
         self.tried_killing = False
-        self.idle_write_id = 0
+        self.input_stream = None
+        self.input_cancellable = None
         self.out_channel = None
         self.err_channel = None
         self.out_channel_id = 0
         self.err_channel_id = 0
+        self.remainders = {'stdout-line': bytearray(), 'stderr-line': bytearray()}
 
         try:
             self.pipe = subprocess.Popen(self.command, **popen_args)
         except OSError as e:
             self.pipe = None
+            self.release_input_document()
             self.emit('stderr-line', _('Could not execute command: %s') % (e, ))
             return
         
@@ -121,59 +145,145 @@ class Capture(GObject.Object):
                                                     self.on_err_output)
 
         # IO
-        if self.input_text is not None:
-            # Write async, in chunks of something
-            self.write_buffer = self.input_text.encode('utf-8')
+        if popen_args.get('stdin') is not None:
+            self.stdin = self.pipe.stdin
 
-            if self.idle_write_chunk():
-                self.idle_write_id = GLib.idle_add(self.idle_write_chunk)
+            # Set non blocking, the writes must not stall the main loop
+            flags = fcntl.fcntl(self.stdin.fileno(), fcntl.F_GETFL) | os.O_NONBLOCK
+            fcntl.fcntl(self.stdin.fileno(), fcntl.F_SETFL, flags)
+
+            self.input_offset = 0
+            self.input_cancellable = Gio.Cancellable()
+            self.input_stream = Gio.UnixOutputStream.new(self.stdin.fileno(), False)
+
+            if self.input_text is not None:
+                self.input_bytes = self.input_text.encode('utf-8')
+            else:
+                self.input_bytes = self.next_document_chunk()
+
+            self.write_input()
 
         # Wait for the process to complete
         GLib.child_watch_add(GLib.PRIORITY_DEFAULT, self.pipe.pid, self.on_child_end)
 
-    def idle_write_chunk(self):
-        if not self.pipe:
-            self.idle_write_id = 0
-            return False
+    def next_document_chunk(self):
+        document = self.input_document
+        start = document.get_iter_at_mark(self.input_mark)
+        end = document.get_iter_at_mark(self.input_end_mark)
 
+        if start.compare(end) >= 0:
+            return b''
+
+        chunk_end = start.copy()
+        chunk_end.forward_chars(self.WRITE_BUFFER_SIZE)
+
+        if chunk_end.compare(end) > 0:
+            chunk_end = end
+
+        document.move_mark(self.input_mark, chunk_end)
+
+        return document.get_text(start, chunk_end, False).encode('utf-8')
+
+    def write_input(self):
+        # Writes the current chunk from input_offset, without slicing the
+        # remaining input each time.
+        if self.input_offset >= len(self.input_bytes) and self.input_document is not None:
+            self.input_bytes = self.next_document_chunk()
+            self.input_offset = 0
+
+        if self.input_offset >= len(self.input_bytes):
+            self.finish_input()
+            return
+
+        m = min(len(self.input_bytes) - self.input_offset, self.WRITE_BUFFER_SIZE)
+        data = GLib.Bytes.new(self.input_bytes[self.input_offset:self.input_offset + m])
+
+        self.input_stream.write_bytes_async(data,
+                                            GLib.PRIORITY_DEFAULT,
+                                            self.input_cancellable,
+                                            self.on_input_written,
+                                            None)
+
+    def on_input_written(self, stream, result, user_data):
         try:
-            l = len(self.write_buffer)
-            m = min(l, self.WRITE_BUFFER_SIZE)
+            written = stream.write_bytes_finish(result)
+        except GLib.Error:
+            # Cancelled, or the command closed its input
+            self.finish_input()
+            return
 
-            self.pipe.stdin.write(self.write_buffer[:m])
+        self.input_offset += written
+        self.write_input()
 
-            if m == l:
-                self.write_buffer = b''
-                self.pipe.stdin.close()
+    def finish_input(self):
+        if self.input_stream is None:
+            return
 
-                self.idle_write_id = 0
+        self.input_stream = None
+        self.input_cancellable = None
+        self.input_bytes = b''
 
-                return False
-            else:
-                self.write_buffer = self.write_buffer[m:]
-                return True
+        try:
+            self.stdin.close()
         except IOError:
-            self.pipe.stdin.close()
-            self.idle_write_id = 0
-
-            return False
+            pass
+
+        self.release_input_document()
+
+    def release_input_document(self):
+        if self.input_document is not None:
+            self.input_document.delete_mark(self.input_mark)
+            self.input_document.delete_mark(self.input_end_mark)
+            self.input_document = None
+            self.emit('end-input')
+
+    def read_source(self, source, signalname):
+        """
+        Reads what is available on the source, a few blocks at most so that
+        the main loop is not starved, and emits the complete lines that were
+        read. The last partial line is kept for the next call. Returns True
+        when the end of the stream has been reached.
+        """
+        fd = source.unix_get_fd()
+        buf = self.remainders[signalname]
+        eof = False
+
+        for i in range(self.MAX_READS_PER_DISPATCH):
+            try:
+                data = os.read(fd, self.READ_BUFFER_SIZE)
+            except (BlockingIOError, InterruptedError):
+                break
+            except OSError:
+                eof = True
+                break
+
+            if not data:
+                eof = True
+                break
+
+            buf.extend(data)
+
+        end = buf.rfind(b'\n') + 1
+
+        if end > 0:
+            self.emit(signalname, buf[:end].decode('utf-8', 'replace'))
+            del buf[:end]
+
+        return eof
 
     def handle_source(self, source, condition, signalname):
+        eof = False
+
         if condition & (GObject.IO_IN | GObject.IO_PRI):
-            status = GLib.IOStatus.NORMAL
-            while status == GLib.IOStatus.NORMAL:
-                try:
-                    (status, buf, length, terminator_pos) = source.read_line()
-                except Exception as e:
-                    # FIXME: why do we get here? read_line should not raise, should it?
-                    # print(e)
-                    return False
-                if buf:
-                    self.emit(signalname, buf)
-            if status != GLib.IOStatus.AGAIN:
-                return False
-
-        if condition & ~(GObject.IO_IN | GObject.IO_PRI):
+            eof = self.read_source(source, signalname)
+
+        if eof or condition & ~(GObject.IO_IN | GObject.IO_PRI):
+            buf = self.remainders[signalname]
+
+            if buf:
+                self.emit(signalname, buf.decode('utf-8', 'replace'))
+                del buf[:]
+
             return False
 
         return True
@@ -203,11 +313,9 @@ class Capture(GObject.Object):
         return ret
 
     def stop(self, error_code = -1):
-        if self.idle_write_id:
-            GLib.source_remove(self.idle_write_id)
-            self.idle_write_id = 0
-            if self.pipe:
-                self.pipe.stdin.close()
+        if self.input_cancellable is not None:
+            # finish_input() is called from the pending write callback
+            self.input_cancellable.cancel()
 
         if self.out_channel_id:
             GLib.source_remove(self.out_channel_id)
@@ -27,7 +27,11 @@ class FileLookup:
     methods of trying to find the real file.
     """
 
+    # Bound the number of cached lookups, tools can output a lot of links
+    MAX_CACHE_SIZE = 4096
+
     def __init__(self, window):
+        self.cache = {}
         self.providers = []
         self.providers.append(AbsoluteFileLookupProvider())
         self.providers.append(BrowserRootFileLookupProvider(window))
@@ -43,14 +47,29 @@ class FileLookup:
 
         path -- the path to find
         """
+        if path in self.cache:
+            return self.cache[path]
+
         found_file = None
         for provider in self.providers:
             found_file = provider.lookup(path)
             if found_file is not None:
                 break
 
+        if len(self.cache) >= self.MAX_CACHE_SIZE:
+            self.cache.clear()
+
+        self.cache[path] = found_file
+
         return found_file
 
+    def clear_cache(self):
+        """
+        Forgets the previous lookups, files may have been created or removed
+        since then.
+        """
+        self.cache.clear()
+
 
 class FileLookupProvider:
     """
@@ -148,6 +148,8 @@ def run_external_tool(window, panel, node):
     # Assign the error output to the output panel
     panel.set_process(capture)
 
+    input_start = None
+
     if input_type != 'nothing' and view is not None:
         if input_type == 'document':
             start, end = document.get_bounds()
@@ -183,8 +185,15 @@ def run_external_tool(window, panel, node):
             if not end.ends_word():
                 end.forward_word_end()
 
-        input_text = document.get_text(start, end, False)
-        capture.set_input(input_text)
+        input_start, input_end = start, end
+
+    # The output may go to another document, the input is read from this one
+    input_view = view
+    input_document = view.get_buffer() if view is not None else None
+
+    # The input is fed to the command while its output comes in, so output
+    # inserted inside the input range would be fed back to it.
+    output_pos = None
 
     # Assign the standard output to the chosen "file"
     if output_type == 'new-document':
@@ -210,18 +219,40 @@ def run_external_tool(window, panel, node):
                     end_iter = start_iter.copy()
             elif output_type == 'replace-document':
                 start_iter, end_iter = document.get_bounds()
-            capture.connect('stdout-line', capture_delayed_replace,
-                            document, start_iter, end_iter)
+
+            # The output is inserted before the replaced text, which is only
+            # removed once the command is done since it may still be reading
+            # it.
+            output_pos = start_iter
+            replace = ReplaceRange(document, start_iter, end_iter)
+            capture.connect('stdout-line', replace.on_stdout_line)
+            capture.connect('end-execute', replace.on_end_execute)
         else:
             if output_type == 'insert':
                 pos = document.get_iter_at_mark(document.get_insert())
             else:
                 pos = document.get_end_iter()
+            output_pos = pos.copy()
             capture.connect('stdout-line', capture_stdout_line_document, document, pos)
     elif output_type != 'nothing':
         capture.connect('stdout-line', capture_stdout_line_panel, panel)
         document.begin_user_action()
 
+    if input_start is not None:
+        if output_pos is not None and \
+           input_start.compare(output_pos) < 0 and output_pos.compare(input_end) < 0:
+            capture.set_input(input_document.get_text(input_start, input_end, False))
+        else:
+            capture.set_input_range(input_document, input_start, input_end)
+
+            # The input is read while the command runs, so it must not be
+            # edited until then. The view is already locked when the output
+            # goes into it.
+            if input_view.get_editable() and \
+               output_type in ('output-panel', 'new-document', 'nothing'):
+                input_view.set_editable(False)
+                capture.connect('end-input', capture_end_input, input_view)
+
     capture.connect('stderr-line', capture_stderr_line_panel, panel)
     capture.connect('begin-execute', capture_begin_execute_panel, panel, view, node.name)
     capture.connect('end-execute', capture_end_execute_panel, panel, view, output_type)
@@ -346,21 +377,41 @@ def capture_end_execute_panel(capture, exit_code, panel, view, output_type):
         panel.write("\n" + _("Exited") + ":", panel.italic_tag)
         panel.write(" %d\n" % exit_code, panel.bold_tag)
 
+def capture_end_input(capture, view):
+    view.set_editable(True)
+
 def capture_stdout_line_panel(capture, line, panel):
     panel.write(line)
 
 def capture_stdout_line_document(capture, line, document, pos):
     document.insert(pos, line)
 
-def capture_delayed_replace(capture, line, document, start_iter, end_iter):
-    document.delete(start_iter, end_iter)
-
-    # Must be done after deleting the text
-    pos = document.get_iter_at_mark(document.get_insert())
-
-    capture_stdout_line_document(capture, line, document, pos)
-
-    capture.disconnect_by_func(capture_delayed_replace)
-    capture.connect('stdout-line', capture_stdout_line_document, document, pos)
+class ReplaceRange:
+    def __init__(self, document, start, end):
+        self.document = document
+        self.received = False
+
+        # Output is inserted at start_mark, which moves past it, so the
+        # replaced text is always between start_mark and end_mark.
+        self.start_mark = document.create_mark(None, start, False)
+        self.end_mark = document.create_mark(None, end, False)
+
+    def on_stdout_line(self, capture, line):
+        self.received = True
+        pos = self.document.get_iter_at_mark(self.start_mark)
+        self.document.insert(pos, line)
+
+    def on_end_execute(self, capture, exit_code):
+        start = self.document.get_iter_at_mark(self.start_mark)
+        end = self.document.get_iter_at_mark(self.end_mark)
+
+        # Like before, nothing is replaced if the command had no output
+        if self.received and start.compare(end) < 0:
+            self.document.begin_user_action()
+            self.document.delete(start, end)
+            self.document.end_user_action()
+
+        self.document.delete_mark(self.start_mark)
+        self.document.delete_mark(self.end_mark)
 
 # ex:ts=4:et:
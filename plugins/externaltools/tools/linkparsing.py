@@ -62,6 +62,8 @@ class LinkParser:
 
     def __init__(self):
         self._providers = []
+        self._regexp_parsers = []
+        self._combined = None
         self.add_regexp(REGEXP_STANDARD)
         self.add_regexp(REGEXP_PYTHON)
         self.add_regexp(REGEXP_VALAC)
@@ -82,7 +84,27 @@ class LinkParser:
         a group named ln. To read more about this look at the documentation
         for the RegexpLinkParser constructor.
         """
-        self.add_parser(RegexpLinkParser(regexp))
+        parser = RegexpLinkParser(regexp)
+
+        self._regexp_parsers.append(parser)
+        self._combined = None
+        self.add_parser(parser)
+
+    def _get_combined(self):
+        if self._combined is None:
+            alternatives = []
+
+            for i, parser in enumerate(self._regexp_parsers):
+                # group names must be unique in the combined expression
+                regexp = re.sub(r'\(\?P<(lnk|pth|ln|col)>',
+                                lambda m: '(?P<%s_%d>' % (m.group(1), i),
+                                parser.re.pattern)
+                alternatives.append('(?:%s)' % (regexp, ))
+
+            self._combined = re.compile('|'.join(alternatives),
+                                        re.MULTILINE | re.VERBOSE)
+
+        return self._combined
 
     def parse(self, text):
         """
@@ -98,11 +120,50 @@ class LinkParser:
 
         links = []
 
+        # Most of the output has no link at all, so the text is first
+        # scanned once with all the regular expressions combined, to find
+        # the lines that have a link. The links are then found with each
+        # expression on its own on those lines only, since the matches of
+        # different expressions can overlap.
+        regions = self._get_link_regions(text)
+
         for provider in self._providers:
-            links.extend(provider.parse(text))
+            if provider in self._regexp_parsers:
+                for start, end in regions:
+                    links.extend(provider.parse(text, start, end))
+            else:
+                links.extend(provider.parse(text))
 
         return links
 
+    def _get_link_regions(self, text):
+        """
+        Returns the (start, end) ranges of the lines of text where the
+        combined regular expression matches, merged when they touch. The
+        newline ending the last line is included, as some expressions end
+        with a whitespace.
+        """
+        regions = []
+
+        if len(self._regexp_parsers) == 0:
+            return regions
+
+        for m in self._get_combined().finditer(text):
+            start = text.rfind('\n', 0, m.start()) + 1
+            end = text.find('\n', m.end())
+
+            if end == -1:
+                end = len(text)
+            else:
+                end += 1
+
+            if regions and start <= regions[-1][1]:
+                regions[-1] = (regions[-1][0], max(end, regions[-1][1]))
+            else:
+                regions.append((start, end))
+
+        return regions
+
 class AbstractLinkParser(object):
     """The "abstract" base class for link parses"""
 
@@ -136,9 +197,16 @@ class RegexpLinkParser(AbstractLinkParser):
         """
         self.re = re.compile(regex, re.MULTILINE | re.VERBOSE)
 
-    def parse(self, text):
+    def parse(self, text, pos=0, endpos=None):
+        """
+        Parses the text between pos and endpos, the whole text by default.
+        The boundaries of the links are still relative to the whole text.
+        """
+        if endpos is None:
+            endpos = len(text)
+
         links = []
-        for m in re.finditer(self.re, text):
+        for m in self.re.finditer(text, pos, endpos):
             groups = m.groups()
 
             path = m.group("pth")
@@ -180,6 +180,41 @@ test.rb:5: undefined method `fake_method' for main:Object (NoMethodError)
         self.assert_link(lnk, "Test.cs", 12)
         self.assert_link_text(line, lnk, 'Test.cs(12,7)')
 
+    def test_parse_bash_and_perl_same_line(self):
+        line = "error at test.sh: line 5: gerp: command not found"
+        links = self.p.parse(line)
+        self.assert_link_count(links, 2)
+        lnk = links[0]
+        self.assert_link(lnk, "error at test.sh", 5)
+        self.assert_link_text(line, lnk, 'error at test.sh: line 5')
+        lnk = links[1]
+        self.assert_link(lnk, "test.sh:", 5)
+        self.assert_link_text(line, lnk, 'test.sh: line 5')
+
+    def test_parse_perl_and_mcs_same_line(self):
+        line = 'Test.cs(12,7): error at test.pl line 3'
+        links = self.p.parse(line)
+        self.assert_link_count(links, 2)
+        lnk = links[0]
+        self.assert_link(lnk, "test.pl", 3)
+        self.assert_link_text(line, lnk, 'test.pl line 3')
+        lnk = links[1]
+        self.assert_link(lnk, "Test.cs", 12)
+        self.assert_link_text(line, lnk, 'Test.cs(12,7)')
+
+    def test_parse_links_ordered_by_parser(self):
+        output = """syntax error at test.pl line 3, near "$fake_var"
+test.c:5:6: error: expected ';' before 'return'
+"""
+        links = self.p.parse(output)
+        self.assert_link_count(links, 2)
+        lnk = links[0]
+        self.assert_link(lnk, "test.c", 5, 6)
+        self.assert_link_text(output, lnk, 'test.c:5:6')
+        lnk = links[1]
+        self.assert_link(lnk, "test.pl", 3)
+        self.assert_link_text(output, lnk, 'test.pl line 3')
+
 if __name__ == '__main__':
     unittest.main()
 
@@ -20,6 +20,8 @@
 __all__ = ('OutputPanel', 'UniqueById')
 
 import os
+import bisect
+from collections import deque
 from weakref import WeakKeyDictionary
 from .capture import *
 import re
@@ -42,6 +44,12 @@ class UniqueById:
         return self.__class__.__shared_state
 
 class OutputPanel(UniqueById):
+    # Maximum number of characters appended to the buffer in one idle
+    FLUSH_BATCH_SIZE = 0x10000
+
+    # Number of lines kept in the panel, the oldest ones are removed
+    MAX_LINES = 20000
+
     def __init__(self, datadir, window):
         if UniqueById.__init__(self, window):
             return
@@ -89,7 +97,13 @@ class OutputPanel(UniqueById):
 
         self.process = None
 
+        # Sorted by start offset
         self.links = []
+        self.link_starts = []
+
+        # Text written but not inserted in the buffer yet, as (text, tag)
+        self.pending = deque()
+        self.flush_id = 0
 
         self.link_parser = linkparsing.LinkParser()
         self.file_lookup = filelookup.FileLookup(window)
@@ -127,18 +141,60 @@ class OutputPanel(UniqueById):
         return False  # don't requeue this handler
 
     def clear(self):
+        if self.flush_id != 0:
+            GLib.source_remove(self.flush_id)
+            self.flush_id = 0
+
+        self.pending.clear()
         self['view'].get_buffer().set_text("")
         self.links = []
+        self.link_starts = []
+        self.file_lookup.clear_cache()
 
     def visible(self):
         panel = self.window.get_bottom_panel()
         return panel.props.visible and panel.item_is_active(self.panel)
 
     def write(self, text, tag = None):
+        # The text is inserted later in batches, so that a tool writing a
+        # lot of lines doesn't make the buffer and the view relayout for
+        # each of them.
+        self.pending.append((text, tag))
+
+        if self.flush_id == 0:
+            self.flush_id = GLib.idle_add(self.flush)
+
+    def flush(self):
+        size = 0
+
+        while self.pending and size < self.FLUSH_BATCH_SIZE:
+            text, tag = self.pending.popleft()
+            parts = [text]
+            size += len(text)
+
+            # merge the following writes that use the same tag
+            while self.pending and self.pending[0][1] is tag and \
+                  size < self.FLUSH_BATCH_SIZE:
+                text = self.pending.popleft()[0]
+                parts.append(text)
+                size += len(text)
+
+            self.insert(''.join(parts), tag)
+
+        self.trim_scrollback()
+        GLib.idle_add(self.scroll_to_end)
+
+        if self.pending:
+            return True
+
+        self.flush_id = 0
+        return False
+
+    def insert(self, text, tag):
         buffer = self['view'].get_buffer()
 
         end_iter = buffer.get_end_iter()
-        insert = buffer.create_mark(None, end_iter, True)
+        offset = end_iter.get_offset()
 
         if tag is None:
             buffer.insert(end_iter, text)
@@ -147,12 +203,12 @@ class OutputPanel(UniqueById):
 
         # find all links and apply the appropriate tag for them
         links = self.link_parser.parse(text)
+        links.sort(key=lambda lnk: lnk.start)
+
         for lnk in links:
-            
-            insert_iter = buffer.get_iter_at_mark(insert)
-            lnk.start = insert_iter.get_offset() + lnk.start
-            lnk.end = insert_iter.get_offset() + lnk.end
-            
+            lnk.start = offset + lnk.start
+            lnk.end = offset + lnk.end
+
             start_iter = buffer.get_iter_at_offset(lnk.start)
             end_iter = buffer.get_iter_at_offset(lnk.end)
 
@@ -161,14 +217,35 @@ class OutputPanel(UniqueById):
             # if the link points to an existing file then it is a valid link
             if self.file_lookup.lookup(lnk.path) is not None:
                 self.links.append(lnk)
+                self.link_starts.append(lnk.start)
                 tag = self.link_tag
             else:
                 tag = self.invalid_link_tag
 
             buffer.apply_tag(tag, start_iter, end_iter)
 
-        buffer.delete_mark(insert)
-        GLib.idle_add(self.scroll_to_end)
+    def trim_scrollback(self):
+        buffer = self['view'].get_buffer()
+        n_lines = buffer.get_line_count()
+
+        # remove lines by large blocks, the links must be shifted each time
+        if n_lines <= self.MAX_LINES + self.MAX_LINES // 10:
+            return
+
+        start_iter = buffer.get_start_iter()
+        end_iter = buffer.get_iter_at_line(n_lines - self.MAX_LINES)
+        removed = end_iter.get_offset()
+
+        buffer.delete(start_iter, end_iter)
+
+        first = bisect.bisect_left(self.link_starts, removed)
+        self.links = self.links[first:]
+
+        for lnk in self.links:
+            lnk.start -= removed
+            lnk.end -= removed
+
+        self.link_starts = [lnk.start for lnk in self.links]
 
     def show(self):
         panel = self.window.get_bottom_panel()
@@ -212,10 +289,11 @@ class OutputPanel(UniqueById):
         iter_at_xy = view.get_iter_at_location(buff_x, buff_y)
         offset = iter_at_xy.get_offset()
 
-        # find the first link that contains the offset
-        for lnk in self.links:
-            if offset >= lnk.start and offset <= lnk.end:
-                return lnk
+        # find the last link starting before the offset
+        i = bisect.bisect_right(self.link_starts, offset) - 1
+
+        if i >= 0 and offset <= self.links[i].end:
+            return self.links[i]
 
         # no link was found at x,y
         return None
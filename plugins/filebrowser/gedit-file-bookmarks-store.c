@@ -31,8 +31,24 @@ struct _GeditFileBookmarksStorePrivate
 {
 	GVolumeMonitor *volume_monitor;
 	GFileMonitor *bookmarks_monitor;
+
+	/* Reading of the bookmarks file, and of the bookmark icons */
+	GCancellable *bookmarks_cancellable;
+	GCancellable *icons_cancellable;
+
+	/* The volume monitor events are handled in one go */
+	guint update_fs_id;
+
+	/* GIcon -> GdkPixbuf, shared by all the rows */
+	GHashTable *icons;
 };
 
+typedef struct
+{
+	GFile *location;
+	gchar *name;
+} Bookmark;
+
 static void remove_node               (GtkTreeModel            *model,
                                        GtkTreeIter             *iter);
 
@@ -50,6 +66,7 @@ static gboolean find_with_flags       (GtkTreeModel            *model,
                                        gpointer                 obj,
                                        guint                    flags,
                                        guint                    notflags);
+static void cancel_pending            (GeditFileBookmarksStore *model);
 
 G_DEFINE_DYNAMIC_TYPE_EXTENDED (GeditFileBookmarksStore,
 				gedit_file_bookmarks_store,
@@ -74,6 +91,14 @@ gedit_file_bookmarks_store_dispose (GObject *object)
 
 	g_clear_object (&obj->priv->bookmarks_monitor);
 
+	cancel_pending (obj);
+
+	if (obj->priv->icons != NULL)
+	{
+		g_hash_table_unref (obj->priv->icons);
+		obj->priv->icons = NULL;
+	}
+
 	G_OBJECT_CLASS (gedit_file_bookmarks_store_parent_class)->dispose (object);
 }
 
@@ -94,6 +119,11 @@ static void
 gedit_file_bookmarks_store_init (GeditFileBookmarksStore *obj)
 {
 	obj->priv = gedit_file_bookmarks_store_get_instance_private (obj);
+
+	obj->priv->icons = g_hash_table_new_full (g_icon_hash,
+						  (GEqualFunc) g_icon_equal,
+						  g_object_unref,
+						  g_object_unref);
 }
 
 /* Private */
@@ -120,6 +150,41 @@ add_node (GeditFileBookmarksStore *model,
 		*iter = newiter;
 }
 
+static GdkPixbuf *
+get_icon_pixbuf (GeditFileBookmarksStore *model,
+		 GIcon                   *icon)
+{
+	GdkPixbuf *pixbuf;
+
+	pixbuf = g_hash_table_lookup (model->priv->icons, icon);
+
+	if (pixbuf == NULL)
+	{
+		pixbuf = gedit_file_browser_utils_pixbuf_from_icon (icon, GTK_ICON_SIZE_MENU);
+
+		if (pixbuf == NULL)
+			return NULL;
+
+		g_hash_table_insert (model->priv->icons, g_object_ref (icon), pixbuf);
+	}
+
+	return g_object_ref (pixbuf);
+}
+
+static GdkPixbuf *
+get_theme_pixbuf (GeditFileBookmarksStore *model,
+		  const gchar             *name)
+{
+	GIcon *icon;
+	GdkPixbuf *pixbuf;
+
+	icon = g_themed_icon_new (name);
+	pixbuf = get_icon_pixbuf (model, icon);
+	g_object_unref (icon);
+
+	return pixbuf;
+}
+
 static gboolean
 add_file (GeditFileBookmarksStore *model,
 	  GFile                   *file,
@@ -137,11 +202,11 @@ add_file (GeditFileBookmarksStore *model,
 		return FALSE;
 
 	if (flags & GEDIT_FILE_BOOKMARKS_STORE_IS_HOME)
-		pixbuf = gedit_file_browser_utils_pixbuf_from_theme ("user-home-symbolic", GTK_ICON_SIZE_MENU);
+		pixbuf = get_theme_pixbuf (model, "user-home-symbolic");
 	else if (flags & GEDIT_FILE_BOOKMARKS_STORE_IS_DESKTOP)
-		pixbuf = gedit_file_browser_utils_pixbuf_from_theme ("user-desktop-symbolic", GTK_ICON_SIZE_MENU);
+		pixbuf = get_theme_pixbuf (model, "user-desktop-symbolic");
 	else if (flags & GEDIT_FILE_BOOKMARKS_STORE_IS_ROOT)
-		pixbuf = gedit_file_browser_utils_pixbuf_from_theme ("drive-harddisk-symbolic", GTK_ICON_SIZE_MENU);
+		pixbuf = get_theme_pixbuf (model, "drive-harddisk-symbolic");
 
 	if (pixbuf == NULL)
 	{
@@ -149,7 +214,7 @@ add_file (GeditFileBookmarksStore *model,
 		if (native)
 			pixbuf = gedit_file_browser_utils_pixbuf_from_file (file, GTK_ICON_SIZE_MENU, TRUE);
 		else
-			pixbuf = gedit_file_browser_utils_pixbuf_from_theme ("folder-symbolic", GTK_ICON_SIZE_MENU);
+			pixbuf = get_theme_pixbuf (model, "folder-symbolic");
 	}
 
 	if (name == NULL)
@@ -236,10 +301,11 @@ init_special_directories (GeditFileBookmarksStore *model)
 }
 
 static void
-get_fs_properties (gpointer    fs,
-		   gchar     **name,
-		   GdkPixbuf **pixbuf,
-		   guint      *flags)
+get_fs_properties (GeditFileBookmarksStore  *model,
+		   gpointer                  fs,
+		   gchar                   **name,
+		   GdkPixbuf               **pixbuf,
+		   guint                    *flags)
 {
 	GIcon *icon = NULL;
 
@@ -271,7 +337,7 @@ get_fs_properties (gpointer    fs,
 
 	if (icon)
 	{
-		*pixbuf = gedit_file_browser_utils_pixbuf_from_icon (icon, GTK_ICON_SIZE_MENU);
+		*pixbuf = get_icon_pixbuf (model, icon);
 		g_object_unref (icon);
 	}
 }
@@ -287,42 +353,78 @@ add_fs (GeditFileBookmarksStore *model,
 	GdkPixbuf *pixbuf;
 	guint fsflags;
 
-	get_fs_properties (fs, &name, &pixbuf, &fsflags);
+	get_fs_properties (model, fs, &name, &pixbuf, &fsflags);
 	add_node (model, pixbuf, name, fs, flags | fsflags, iter);
 
 	if (pixbuf)
 		g_object_unref (pixbuf);
 
 	g_free (name);
-	check_mount_separator (model, GEDIT_FILE_BOOKMARKS_STORE_IS_FS, TRUE);
 }
 
+/* Only touches the row if its name or its icon changed. The pixbufs come
+ * from the icon cache, so comparing them is enough.
+ */
 static void
-process_volume_cb (GVolume                 *volume,
-		   GeditFileBookmarksStore *model)
+update_fs_node (GeditFileBookmarksStore *model,
+		GtkTreeIter             *iter,
+		gpointer                 fs)
+{
+	gchar *name;
+	gchar *old_name;
+	GdkPixbuf *pixbuf;
+	GdkPixbuf *old_pixbuf;
+	guint fsflags;
+
+	get_fs_properties (model, fs, &name, &pixbuf, &fsflags);
+
+	gtk_tree_model_get (GTK_TREE_MODEL (model), iter,
+			    GEDIT_FILE_BOOKMARKS_STORE_COLUMN_ICON, &old_pixbuf,
+			    GEDIT_FILE_BOOKMARKS_STORE_COLUMN_NAME, &old_name,
+			    -1);
+
+	if (pixbuf != old_pixbuf || g_strcmp0 (name, old_name) != 0)
+	{
+		gtk_tree_store_set (GTK_TREE_STORE (model), iter,
+				    GEDIT_FILE_BOOKMARKS_STORE_COLUMN_ICON, pixbuf,
+				    GEDIT_FILE_BOOKMARKS_STORE_COLUMN_NAME, name,
+				    -1);
+	}
+
+	if (pixbuf)
+		g_object_unref (pixbuf);
+
+	if (old_pixbuf)
+		g_object_unref (old_pixbuf);
+
+	g_free (name);
+	g_free (old_name);
+}
+
+static void
+process_volume_cb (GVolume   *volume,
+		   GPtrArray *fs)
 {
 	GMount *mount;
-	guint flags = GEDIT_FILE_BOOKMARKS_STORE_NONE;
 	mount = g_volume_get_mount (volume);
 
 	/* CHECK: should we use the LOCAL/REMOTE thing still? */
 	if (mount)
 	{
 		/* Show mounted volume */
-		add_fs (model, mount, flags, NULL);
-		g_object_unref (mount);
+		g_ptr_array_add (fs, mount);
 	}
 	else if (g_volume_can_mount (volume))
 	{
 		/* We also show the unmounted volume here so users can
 		   mount it if they want to access it */
-		add_fs (model, volume, flags, NULL);
+		g_ptr_array_add (fs, g_object_ref (volume));
 	}
 }
 
 static void
-process_drive_novolumes (GeditFileBookmarksStore *model,
-			 GDrive                  *drive)
+process_drive_novolumes (GPtrArray *fs,
+			 GDrive    *drive)
 {
 	if (g_drive_is_media_removable (drive) &&
 	   !g_drive_is_media_check_automatic (drive) &&
@@ -332,13 +434,13 @@ process_drive_novolumes (GeditFileBookmarksStore *model,
 		   drives where media detection fails. We show the
 		   drive and poll for media when the user activates
 		   it */
-		add_fs (model, drive, GEDIT_FILE_BOOKMARKS_STORE_NONE, NULL);
+		g_ptr_array_add (fs, g_object_ref (drive));
 	}
 }
 
 static void
-process_drive_cb (GDrive                  *drive,
-	          GeditFileBookmarksStore *model)
+process_drive_cb (GDrive    *drive,
+	          GPtrArray *fs)
 {
 	GList *volumes;
 
@@ -347,29 +449,30 @@ process_drive_cb (GDrive                  *drive,
 	if (volumes)
 	{
 		/* Add all volumes for the drive */
-		g_list_foreach (volumes, (GFunc)process_volume_cb, model);
-		g_list_free (volumes);
+		g_list_foreach (volumes, (GFunc)process_volume_cb, fs);
+		g_list_free_full (volumes, g_object_unref);
 	}
 	else
 	{
-		process_drive_novolumes (model, drive);
+		process_drive_novolumes (fs, drive);
 	}
 }
 
 static void
-init_drives (GeditFileBookmarksStore *model)
+get_drives (GeditFileBookmarksStore *model,
+	    GPtrArray               *fs)
 {
 	GList *drives;
 
 	drives = g_volume_monitor_get_connected_drives (model->priv->volume_monitor);
 
-	g_list_foreach (drives, (GFunc)process_drive_cb, model);
+	g_list_foreach (drives, (GFunc)process_drive_cb, fs);
 	g_list_free_full (drives, g_object_unref);
 }
 
 static void
-process_volume_nodrive_cb (GVolume                 *volume,
-			   GeditFileBookmarksStore *model)
+process_volume_nodrive_cb (GVolume   *volume,
+			   GPtrArray *fs)
 {
 	GDrive *drive;
 
@@ -381,23 +484,24 @@ process_volume_nodrive_cb (GVolume                 *volume,
 		return;
 	}
 
-	process_volume_cb (volume, model);
+	process_volume_cb (volume, fs);
 }
 
 static void
-init_volumes (GeditFileBookmarksStore *model)
+get_volumes (GeditFileBookmarksStore *model,
+	     GPtrArray               *fs)
 {
 	GList *volumes;
 
 	volumes = g_volume_monitor_get_volumes (model->priv->volume_monitor);
 
-	g_list_foreach (volumes, (GFunc)process_volume_nodrive_cb, model);
+	g_list_foreach (volumes, (GFunc)process_volume_nodrive_cb, fs);
 	g_list_free_full (volumes, g_object_unref);
 }
 
 static void
-process_mount_novolume_cb (GMount                  *mount,
-			   GeditFileBookmarksStore *model)
+process_mount_novolume_cb (GMount    *mount,
+			   GPtrArray *fs)
 {
 	GVolume *volume;
 
@@ -410,21 +514,132 @@ process_mount_novolume_cb (GMount                  *mount,
 	else if (!g_mount_is_shadowed (mount))
 	{
 		/* Add the mount */
-		add_fs (model, mount, GEDIT_FILE_BOOKMARKS_STORE_NONE, NULL);
+		g_ptr_array_add (fs, g_object_ref (mount));
 	}
 }
 
 static void
-init_mounts (GeditFileBookmarksStore *model)
+get_mounts (GeditFileBookmarksStore *model,
+	    GPtrArray               *fs)
 {
 	GList *mounts;
 
 	mounts = g_volume_monitor_get_mounts (model->priv->volume_monitor);
 
-	g_list_foreach (mounts, (GFunc)process_mount_novolume_cb, model);
+	g_list_foreach (mounts, (GFunc)process_mount_novolume_cb, fs);
 	g_list_free_full (mounts, g_object_unref);
 }
 
+/* Brings the fs rows in line with the volume monitor. Only the rows whose
+ * object appeared, went away or changed are touched, instead of the whole
+ * list being rebuilt on each event.
+ */
+static void
+update_fs (GeditFileBookmarksStore *model)
+{
+	GtkTreeModel *tree_model = GTK_TREE_MODEL (model);
+	GPtrArray *fs;
+	GHashTable *rows;
+	GHashTableIter hiter;
+	GtkTreeIter iter;
+	gpointer row;
+	guint i;
+
+	fs = g_ptr_array_new_with_free_func (g_object_unref);
+
+	/* First go through all the connected drives */
+	get_drives (model, fs);
+
+	/* Then add all volumes, not associated with a drive */
+	get_volumes (model, fs);
+
+	/* Then finally add all mounts that have no volume */
+	get_mounts (model, fs);
+
+	/* The rows there are now, by object */
+	rows = g_hash_table_new_full (g_direct_hash,
+				      g_direct_equal,
+				      NULL,
+				      (GDestroyNotify) gtk_tree_iter_free);
+
+	if (gtk_tree_model_get_iter_first (tree_model, &iter))
+	{
+		do
+		{
+			GObject *obj;
+			guint flags;
+
+			gtk_tree_model_get (tree_model, &iter,
+					    GEDIT_FILE_BOOKMARKS_STORE_COLUMN_OBJECT, &obj,
+					    GEDIT_FILE_BOOKMARKS_STORE_COLUMN_FLAGS, &flags,
+					    -1);
+
+			if (obj == NULL)
+				continue;
+
+			if ((flags & GEDIT_FILE_BOOKMARKS_STORE_IS_FS) &&
+			    !(flags & GEDIT_FILE_BOOKMARKS_STORE_IS_SEPARATOR))
+			{
+				g_hash_table_insert (rows, obj, gtk_tree_iter_copy (&iter));
+			}
+
+			g_object_unref (obj);
+		}
+		while (gtk_tree_model_iter_next (tree_model, &iter));
+	}
+
+	for (i = 0; i < fs->len; i++)
+	{
+		gpointer obj = g_ptr_array_index (fs, i);
+
+		row = g_hash_table_lookup (rows, obj);
+
+		if (row != NULL)
+		{
+			update_fs_node (model, row, obj);
+			g_hash_table_remove (rows, obj);
+		}
+		else
+		{
+			add_fs (model, obj, GEDIT_FILE_BOOKMARKS_STORE_NONE, NULL);
+		}
+	}
+
+	/* What is left went away. The iters persist across removals. */
+	g_hash_table_iter_init (&hiter, rows);
+
+	while (g_hash_table_iter_next (&hiter, NULL, &row))
+	{
+		gtk_tree_store_remove (GTK_TREE_STORE (model), row);
+	}
+
+	check_mount_separator (model, GEDIT_FILE_BOOKMARKS_STORE_IS_FS, fs->len > 0);
+
+	g_hash_table_unref (rows);
+	g_ptr_array_unref (fs);
+}
+
+static gboolean
+update_fs_idle (gpointer data)
+{
+	GeditFileBookmarksStore *model = GEDIT_FILE_BOOKMARKS_STORE (data);
+
+	model->priv->update_fs_id = 0;
+
+	update_fs (model);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+queue_update_fs (GeditFileBookmarksStore *model)
+{
+	if (model->priv->update_fs_id == 0)
+	{
+		model->priv->update_fs_id = g_idle_add (update_fs_idle, model);
+	}
+}
+
 static void
 init_fs (GeditFileBookmarksStore *model)
 {
@@ -449,38 +664,231 @@ init_fs (GeditFileBookmarksStore *model)
 		}
 	}
 
-	/* First go through all the connected drives */
-	init_drives (model);
-
-	/* Then add all volumes, not associated with a drive */
-	init_volumes (model);
+	/* Do not hold up showing the panel */
+	queue_update_fs (model);
+}
 
-	/* Then finally add all mounts that have no volume */
-	init_mounts (model);
+static void
+bookmark_free (Bookmark *bookmark)
+{
+	g_object_unref (bookmark->location);
+	g_free (bookmark->name);
+	g_slice_free (Bookmark, bookmark);
 }
 
 static gboolean
-add_bookmark (GeditFileBookmarksStore *model,
-	      gchar const             *name,
-	      gchar const             *uri)
+has_bookmarks (GeditFileBookmarksStore *model)
 {
-	GFile *file;
-	gboolean ret;
-	guint flags = GEDIT_FILE_BOOKMARKS_STORE_IS_BOOKMARK;
 	GtkTreeIter iter;
 
-	file = g_file_new_for_uri (uri);
+	return find_with_flags (GTK_TREE_MODEL (model), &iter, NULL,
+				GEDIT_FILE_BOOKMARKS_STORE_IS_BOOKMARK,
+				GEDIT_FILE_BOOKMARKS_STORE_IS_SEPARATOR);
+}
+
+static void
+bookmark_info_ready_cb (GObject      *source,
+			GAsyncResult *result,
+			gpointer      user_data)
+{
+	GeditFileBookmarksStore *model = GEDIT_FILE_BOOKMARKS_STORE (user_data);
+	GFile *file = G_FILE (source);
+	GFileInfo *info;
+	GError *error = NULL;
+	GtkTreeIter iter;
+
+	info = g_file_query_info_finish (file, result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED) ||
+	    !find_with_flags (GTK_TREE_MODEL (model), &iter, file,
+			      GEDIT_FILE_BOOKMARKS_STORE_IS_BOOKMARK, 0))
+	{
+		/* Cancelled, or the bookmark was removed meanwhile */
+	}
+	else if (info == NULL)
+	{
+		/* Bookmarks of local files that do not exist are not shown */
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+		{
+			gtk_tree_store_remove (GTK_TREE_STORE (model), &iter);
+
+			check_mount_separator (model,
+					       GEDIT_FILE_BOOKMARKS_STORE_IS_BOOKMARK,
+					       has_bookmarks (model));
+		}
+	}
+	else
+	{
+		GIcon *icon;
+
+		icon = g_file_info_get_symbolic_icon (info);
+
+		if (icon != NULL)
+		{
+			GdkPixbuf *pixbuf;
+
+			pixbuf = get_icon_pixbuf (model, icon);
+
+			if (pixbuf != NULL)
+			{
+				gtk_tree_store_set (GTK_TREE_STORE (model), &iter,
+						    GEDIT_FILE_BOOKMARKS_STORE_COLUMN_ICON, pixbuf,
+						    -1);
+				g_object_unref (pixbuf);
+			}
+		}
+	}
 
-	if (g_file_is_native (file))
+	if (info != NULL)
+		g_object_unref (info);
+
+	if (error != NULL)
+		g_error_free (error);
+
+	g_object_unref (model);
+}
+
+/* The bookmark is shown right away with a generic icon. For local files,
+ * whether it exists and its actual icon are then queried asynchronously,
+ * since even local paths can be on slow network file systems.
+ */
+static void
+add_bookmark (GeditFileBookmarksStore *model,
+	      Bookmark                *bookmark)
+{
+	guint flags = GEDIT_FILE_BOOKMARKS_STORE_IS_BOOKMARK;
+	GdkPixbuf *pixbuf;
+	gchar *name;
+
+	if (g_file_is_native (bookmark->location))
 		flags |= GEDIT_FILE_BOOKMARKS_STORE_IS_LOCAL_BOOKMARK;
 	else
 		flags |= GEDIT_FILE_BOOKMARKS_STORE_IS_REMOTE_BOOKMARK;
 
-	ret = add_file (model, file, name, flags, &iter);
+	if (bookmark->name == NULL)
+		name = gedit_file_browser_utils_file_basename (bookmark->location);
+	else
+		name = g_strdup (bookmark->name);
 
-	g_object_unref (file);
+	pixbuf = get_theme_pixbuf (model, "folder-symbolic");
 
-	return ret;
+	add_node (model, pixbuf, name, G_OBJECT (bookmark->location), flags, NULL);
+
+	if (pixbuf)
+		g_object_unref (pixbuf);
+
+	g_free (name);
+
+	if (flags & GEDIT_FILE_BOOKMARKS_STORE_IS_LOCAL_BOOKMARK)
+	{
+		if (model->priv->icons_cancellable == NULL)
+			model->priv->icons_cancellable = g_cancellable_new ();
+
+		g_file_query_info_async (bookmark->location,
+					 G_FILE_ATTRIBUTE_STANDARD_SYMBOLIC_ICON,
+					 G_FILE_QUERY_INFO_NONE,
+					 G_PRIORITY_LOW,
+					 model->priv->icons_cancellable,
+					 bookmark_info_ready_cb,
+					 g_object_ref (model));
+	}
+}
+
+static gboolean
+bookmark_equal (GeditFileBookmarksStore *model,
+		GtkTreeIter             *iter,
+		Bookmark                *bookmark)
+{
+	GObject *obj;
+	gchar *name;
+	gchar *bookmark_name;
+	gboolean equal;
+
+	gtk_tree_model_get (GTK_TREE_MODEL (model), iter,
+			    GEDIT_FILE_BOOKMARKS_STORE_COLUMN_OBJECT, &obj,
+			    GEDIT_FILE_BOOKMARKS_STORE_COLUMN_NAME, &name,
+			    -1);
+
+	if (bookmark->name == NULL)
+		bookmark_name = gedit_file_browser_utils_file_basename (bookmark->location);
+	else
+		bookmark_name = g_strdup (bookmark->name);
+
+	equal = obj != NULL &&
+		g_file_equal (G_FILE (obj), bookmark->location) &&
+		g_strcmp0 (name, bookmark_name) == 0;
+
+	if (obj != NULL)
+		g_object_unref (obj);
+
+	g_free (name);
+	g_free (bookmark_name);
+
+	return equal;
+}
+
+/* Only replaces the bookmarks from the first one that changed. Bookmarks
+ * are not sorted, so the rows after it have to be added again to keep
+ * the order of the file.
+ */
+static void
+update_bookmarks (GeditFileBookmarksStore *model,
+		  GPtrArray               *bookmarks)
+{
+	GtkTreeModel *tree_model = GTK_TREE_MODEL (model);
+	GPtrArray *rows;
+	GtkTreeIter iter;
+	guint same;
+	guint i;
+
+	rows = g_ptr_array_new_with_free_func ((GDestroyNotify) gtk_tree_iter_free);
+
+	if (gtk_tree_model_get_iter_first (tree_model, &iter))
+	{
+		do
+		{
+			guint flags;
+
+			gtk_tree_model_get (tree_model, &iter,
+					    GEDIT_FILE_BOOKMARKS_STORE_COLUMN_FLAGS, &flags,
+					    -1);
+
+			if ((flags & GEDIT_FILE_BOOKMARKS_STORE_IS_BOOKMARK) &&
+			    !(flags & GEDIT_FILE_BOOKMARKS_STORE_IS_SEPARATOR))
+			{
+				g_ptr_array_add (rows, gtk_tree_iter_copy (&iter));
+			}
+		}
+		while (gtk_tree_model_iter_next (tree_model, &iter));
+	}
+
+	for (same = 0; same < rows->len && same < bookmarks->len; same++)
+	{
+		if (!bookmark_equal (model,
+				     g_ptr_array_index (rows, same),
+				     g_ptr_array_index (bookmarks, same)))
+		{
+			break;
+		}
+	}
+
+	for (i = same; i < rows->len; i++)
+	{
+		gtk_tree_store_remove (GTK_TREE_STORE (model),
+				       g_ptr_array_index (rows, i));
+	}
+
+	for (i = same; i < bookmarks->len; i++)
+	{
+		add_bookmark (model, g_ptr_array_index (bookmarks, i));
+	}
+
+	/* Bookmarks separator */
+	check_mount_separator (model,
+			       GEDIT_FILE_BOOKMARKS_STORE_IS_BOOKMARK,
+			       bookmarks->len > 0);
+
+	g_ptr_array_unref (rows);
 }
 
 static gchar *
@@ -495,23 +903,14 @@ get_legacy_bookmarks_file (void)
 	return g_build_filename (g_get_home_dir (), ".gtk-bookmarks", NULL);
 }
 
-static gboolean
-parse_bookmarks_file (GeditFileBookmarksStore *model,
-		      const gchar             *bookmarks,
-		      gboolean                *added)
+static GPtrArray *
+parse_bookmarks (gchar *contents)
 {
-	GError *error = NULL;
-	gchar *contents;
+	GPtrArray *bookmarks;
 	gchar **lines;
 	gchar **line;
 
-	if (!g_file_get_contents (bookmarks, &contents, NULL, &error))
-	{
-		/* The bookmarks file doesn't exist (which is perfectly fine) */
-		g_error_free (error);
-
-		return FALSE;
-	}
+	bookmarks = g_ptr_array_new_with_free_func ((GDestroyNotify) bookmark_free);
 
 	lines = g_strsplit (contents, "\n", 0);
 
@@ -542,23 +941,83 @@ parse_bookmarks_file (GeditFileBookmarksStore *model,
 			location = g_file_new_for_uri (*line);
 			if (gedit_utils_is_valid_location (location))
 			{
-				*added |= add_bookmark (model, name, *line);
+				Bookmark *bookmark;
+
+				bookmark = g_slice_new (Bookmark);
+				bookmark->location = location;
+				bookmark->name = g_strdup (name);
+
+				g_ptr_array_add (bookmarks, bookmark);
+			}
+			else
+			{
+				g_object_unref (location);
 			}
-			g_object_unref (location);
 		}
 	}
 
 	g_strfreev (lines);
+
+	return bookmarks;
+}
+
+static void load_bookmarks_file (GeditFileBookmarksStore *model,
+				 const gchar             *bookmarks);
+
+static void
+bookmarks_file_loaded_cb (GObject      *source,
+			  GAsyncResult *result,
+			  gpointer      user_data)
+{
+	GeditFileBookmarksStore *model = GEDIT_FILE_BOOKMARKS_STORE (user_data);
+	GFile *file = G_FILE (source);
+	GError *error = NULL;
+	gchar *contents;
+	GPtrArray *bookmarks;
+
+	if (!g_file_load_contents_finish (file, result, &contents, NULL, NULL, &error))
+	{
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		{
+			gchar *path;
+			gchar *legacy;
+
+			/* The bookmarks file doesn't exist (which is perfectly fine) */
+			path = g_file_get_path (file);
+			legacy = get_legacy_bookmarks_file ();
+
+			if (g_strcmp0 (path, legacy) != 0)
+			{
+				/* try the old location (gtk <= 3.4) */
+				load_bookmarks_file (model, legacy);
+			}
+			else
+			{
+				bookmarks = g_ptr_array_new ();
+				update_bookmarks (model, bookmarks);
+				g_ptr_array_unref (bookmarks);
+			}
+
+			g_free (path);
+			g_free (legacy);
+		}
+
+		g_error_free (error);
+		g_object_unref (model);
+
+		return;
+	}
+
+	bookmarks = parse_bookmarks (contents);
+	update_bookmarks (model, bookmarks);
+
+	g_ptr_array_unref (bookmarks);
 	g_free (contents);
 
 	/* Add a watch */
 	if (model->priv->bookmarks_monitor == NULL)
 	{
-		GFile *file;
-
-		file = g_file_new_for_path (bookmarks);
 		model->priv->bookmarks_monitor = g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, NULL);
-		g_object_unref (file);
 
 		g_signal_connect (model->priv->bookmarks_monitor,
 				  "changed",
@@ -566,35 +1025,64 @@ parse_bookmarks_file (GeditFileBookmarksStore *model,
 				  model);
 	}
 
-	return TRUE;
+	g_object_unref (model);
+}
+
+static void
+load_bookmarks_file (GeditFileBookmarksStore *model,
+		     const gchar             *bookmarks)
+{
+	GFile *file;
+
+	file = g_file_new_for_path (bookmarks);
+
+	g_file_load_contents_async (file,
+				    model->priv->bookmarks_cancellable,
+				    bookmarks_file_loaded_cb,
+				    g_object_ref (model));
+
+	g_object_unref (file);
 }
 
 static void
 init_bookmarks (GeditFileBookmarksStore *model)
 {
 	gchar *bookmarks;
-	gboolean added = FALSE;
+
+	/* Only the last read of the file matters */
+	if (model->priv->bookmarks_cancellable != NULL)
+	{
+		g_cancellable_cancel (model->priv->bookmarks_cancellable);
+		g_object_unref (model->priv->bookmarks_cancellable);
+	}
+
+	model->priv->bookmarks_cancellable = g_cancellable_new ();
 
 	bookmarks = get_bookmarks_file ();
+	load_bookmarks_file (model, bookmarks);
+	g_free (bookmarks);
+}
 
-	if (!parse_bookmarks_file (model, bookmarks, &added))
+static void
+cancel_pending (GeditFileBookmarksStore *model)
+{
+	if (model->priv->bookmarks_cancellable != NULL)
 	{
-		g_free (bookmarks);
-
-		/* try the old location (gtk <= 3.4) */
-		bookmarks = get_legacy_bookmarks_file ();
-		parse_bookmarks_file (model, bookmarks, &added);
+		g_cancellable_cancel (model->priv->bookmarks_cancellable);
+		g_clear_object (&model->priv->bookmarks_cancellable);
 	}
 
-	if (added)
+	if (model->priv->icons_cancellable != NULL)
 	{
-		/* Bookmarks separator */
-		add_node (model, NULL, NULL, NULL,
-			  GEDIT_FILE_BOOKMARKS_STORE_IS_BOOKMARK |
-			  GEDIT_FILE_BOOKMARKS_STORE_IS_SEPARATOR, NULL);
+		g_cancellable_cancel (model->priv->icons_cancellable);
+		g_clear_object (&model->priv->icons_cancellable);
 	}
 
-	g_free (bookmarks);
+	if (model->priv->update_fs_id != 0)
+	{
+		g_source_remove (model->priv->update_fs_id);
+		model->priv->update_fs_id = 0;
+	}
 }
 
 static gint flags_order[] = {
@@ -885,6 +1373,9 @@ gedit_file_bookmarks_store_get_location (GeditFileBookmarksStore *model,
 void
 gedit_file_bookmarks_store_refresh (GeditFileBookmarksStore *model)
 {
+	cancel_pending (model);
+	g_hash_table_remove_all (model->priv->icons);
+
 	gtk_tree_store_clear (GTK_TREE_STORE (model));
 	initialize_fill (model);
 }
@@ -894,17 +1385,7 @@ on_fs_changed (GVolumeMonitor          *monitor,
 	       GObject                 *object,
 	       GeditFileBookmarksStore *model)
 {
-	GtkTreeModel *tree_model = GTK_TREE_MODEL (model);
-	guint flags = GEDIT_FILE_BOOKMARKS_STORE_IS_FS;
-	guint noflags = GEDIT_FILE_BOOKMARKS_STORE_IS_SEPARATOR;
-	GtkTreeIter iter;
-
-	/* clear all fs items */
-	while (find_with_flags (tree_model, &iter, NULL, flags, noflags))
-		remove_node (tree_model, &iter);
-
-	/* then reinitialize */
-	init_fs (model);
+	queue_update_fs (model);
 }
 
 static void
@@ -918,13 +1399,15 @@ on_bookmarks_file_changed (GFileMonitor            *monitor,
 	{
 		case G_FILE_MONITOR_EVENT_CHANGED:
 		case G_FILE_MONITOR_EVENT_CREATED:
-			/* Re-initialize bookmarks */
-			remove_bookmarks (model);
+			/* Re-read the bookmarks, only the changed ones are updated */
 			init_bookmarks (model);
 			break;
 		/*  FIXME: shouldn't we also monitor the directory? */
 		case G_FILE_MONITOR_EVENT_DELETED:
 			/* Remove bookmarks */
+			if (model->priv->bookmarks_cancellable != NULL)
+				g_cancellable_cancel (model->priv->bookmarks_cancellable);
+
 			remove_bookmarks (model);
 			g_object_unref (monitor);
 			model->priv->bookmarks_monitor = NULL;
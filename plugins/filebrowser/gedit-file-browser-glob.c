@@ -0,0 +1,285 @@
+/*
+ * gedit-file-browser-glob.c - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gedit-file-browser-glob.h"
+
+/* Most file name globs are a literal with a '*' at one or both ends, like
+ * "*.o" or "*~". Those are matched without going through GPatternSpec:
+ * the suffixes are looked up in a hash table, once for each distinct
+ * suffix length, so that matching a name costs about the same however
+ * many such patterns there are. Only the remaining patterns are matched
+ * one by one with GPatternSpec.
+ */
+
+typedef enum
+{
+	GLOB_LITERAL,
+	GLOB_SUFFIX,
+	GLOB_PREFIX,
+	GLOB_CONTAINS,
+	GLOB_OTHER
+} GlobKind;
+
+struct _GeditFileBrowserGlobSet
+{
+	GHashTable *literals;
+
+	GHashTable *suffixes;
+	GArray *suffix_lengths;
+
+	GPtrArray *prefixes;
+	GPtrArray *contains;
+	GPtrArray *others;
+};
+
+/* Returns the kind of the pattern, and its literal part in @literal for
+ * all the kinds but GLOB_OTHER.
+ */
+static GlobKind
+glob_classify (const gchar  *pattern,
+	       gchar       **literal)
+{
+	gsize len;
+	const gchar *start;
+	const gchar *end;
+
+	len = strlen (pattern);
+	start = pattern;
+	end = pattern + len;
+
+	if (start < end && *start == '*')
+		++start;
+
+	if (start < end && end[-1] == '*')
+		--end;
+
+	/* The literal part must not have any wildcard left */
+	if (strchr (pattern, '?') != NULL ||
+	    memchr (start, '*', end - start) != NULL)
+	{
+		*literal = NULL;
+		return GLOB_OTHER;
+	}
+
+	*literal = g_strndup (start, end - start);
+
+	if (start == pattern && end == pattern + len)
+		return GLOB_LITERAL;
+	else if (start == pattern)
+		return GLOB_PREFIX;
+	else if (end == pattern + len)
+		return GLOB_SUFFIX;
+	else
+		return GLOB_CONTAINS;
+}
+
+static gint
+compare_lengths (gconstpointer a,
+		 gconstpointer b)
+{
+	guint la = *(const guint *) a;
+	guint lb = *(const guint *) b;
+
+	return la < lb ? -1 : (la > lb ? 1 : 0);
+}
+
+GeditFileBrowserGlobSet *
+gedit_file_browser_glob_set_new (const gchar * const *patterns)
+{
+	GeditFileBrowserGlobSet *set;
+	gint i;
+
+	set = g_slice_new (GeditFileBrowserGlobSet);
+
+	set->literals = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	set->suffixes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	set->suffix_lengths = g_array_new (FALSE, FALSE, sizeof (guint));
+	set->prefixes = g_ptr_array_new_with_free_func (g_free);
+	set->contains = g_ptr_array_new_with_free_func (g_free);
+	set->others = g_ptr_array_new_with_free_func ((GDestroyNotify) g_pattern_spec_free);
+
+	for (i = 0; patterns != NULL && patterns[i] != NULL; ++i)
+	{
+		gchar *literal;
+		guint length;
+		guint j;
+
+		switch (glob_classify (patterns[i], &literal))
+		{
+			case GLOB_LITERAL:
+				g_hash_table_add (set->literals, literal);
+				break;
+			case GLOB_SUFFIX:
+				length = strlen (literal);
+
+				for (j = 0; j < set->suffix_lengths->len; ++j)
+				{
+					if (g_array_index (set->suffix_lengths, guint, j) == length)
+						break;
+				}
+
+				if (j == set->suffix_lengths->len)
+					g_array_append_val (set->suffix_lengths, length);
+
+				g_hash_table_add (set->suffixes, literal);
+				break;
+			case GLOB_PREFIX:
+				g_ptr_array_add (set->prefixes, literal);
+				break;
+			case GLOB_CONTAINS:
+				g_ptr_array_add (set->contains, literal);
+				break;
+			case GLOB_OTHER:
+				g_ptr_array_add (set->others, g_pattern_spec_new (patterns[i]));
+				break;
+		}
+	}
+
+	/* So that matching can stop at the first suffix longer than the name */
+	g_array_sort (set->suffix_lengths, compare_lengths);
+
+	return set;
+}
+
+void
+gedit_file_browser_glob_set_free (GeditFileBrowserGlobSet *set)
+{
+	if (set == NULL)
+		return;
+
+	g_hash_table_unref (set->literals);
+	g_hash_table_unref (set->suffixes);
+	g_array_unref (set->suffix_lengths);
+	g_ptr_array_unref (set->prefixes);
+	g_ptr_array_unref (set->contains);
+	g_ptr_array_unref (set->others);
+
+	g_slice_free (GeditFileBrowserGlobSet, set);
+}
+
+gboolean
+gedit_file_browser_glob_set_match (GeditFileBrowserGlobSet *set,
+				   const gchar             *name)
+{
+	gsize name_length;
+	guint i;
+
+	g_return_val_if_fail (set != NULL, FALSE);
+	g_return_val_if_fail (name != NULL, FALSE);
+
+	if (g_hash_table_contains (set->literals, name))
+		return TRUE;
+
+	name_length = strlen (name);
+
+	for (i = 0; i < set->suffix_lengths->len; ++i)
+	{
+		guint length = g_array_index (set->suffix_lengths, guint, i);
+
+		if (length > name_length)
+			break;
+
+		if (g_hash_table_contains (set->suffixes, name + name_length - length))
+			return TRUE;
+	}
+
+	for (i = 0; i < set->prefixes->len; ++i)
+	{
+		if (g_str_has_prefix (name, g_ptr_array_index (set->prefixes, i)))
+			return TRUE;
+	}
+
+	for (i = 0; i < set->contains->len; ++i)
+	{
+		if (strstr (name, g_ptr_array_index (set->contains, i)) != NULL)
+			return TRUE;
+	}
+
+	/* GPatternSpec only reverses the name when a pattern needs it */
+	for (i = 0; i < set->others->len; ++i)
+	{
+		if (g_pattern_match (g_ptr_array_index (set->others, i),
+				     name_length, name, NULL))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/* Whether all the names matched by @new_pattern are also matched by
+ * @old_pattern, in which case the names that did not match before do not
+ * need to be checked again. This only recognizes the simple cases, like
+ * a pattern that is being typed, and returns FALSE when unsure.
+ */
+gboolean
+gedit_file_browser_glob_narrows (const gchar *old_pattern,
+				 const gchar *new_pattern)
+{
+	gchar *old_literal;
+	gchar *new_literal;
+	GlobKind old_kind;
+	GlobKind new_kind;
+	gboolean narrows = FALSE;
+
+	g_return_val_if_fail (old_pattern != NULL, FALSE);
+	g_return_val_if_fail (new_pattern != NULL, FALSE);
+
+	if (strcmp (old_pattern, new_pattern) == 0)
+		return TRUE;
+
+	old_kind = glob_classify (old_pattern, &old_literal);
+	new_kind = glob_classify (new_pattern, &new_literal);
+
+	if (old_kind != GLOB_OTHER && new_kind != GLOB_OTHER)
+	{
+		switch (old_kind)
+		{
+			case GLOB_CONTAINS:
+				/* All the names matched by new_pattern contain
+				 * its literal part */
+				narrows = strstr (new_literal, old_literal) != NULL;
+				break;
+			case GLOB_PREFIX:
+				narrows = (new_kind == GLOB_PREFIX || new_kind == GLOB_LITERAL) &&
+					  g_str_has_prefix (new_literal, old_literal);
+				break;
+			case GLOB_SUFFIX:
+				narrows = (new_kind == GLOB_SUFFIX || new_kind == GLOB_LITERAL) &&
+					  g_str_has_suffix (new_literal, old_literal);
+				break;
+			default:
+				break;
+		}
+	}
+
+	g_free (old_literal);
+	g_free (new_literal);
+
+	return narrows;
+}
+
+/* ex:ts=8:noet: */
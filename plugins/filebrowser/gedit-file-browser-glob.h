@@ -0,0 +1,40 @@
+/*
+ * gedit-file-browser-glob.h - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GEDIT_FILE_BROWSER_GLOB_H__
+#define __GEDIT_FILE_BROWSER_GLOB_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GeditFileBrowserGlobSet GeditFileBrowserGlobSet;
+
+GeditFileBrowserGlobSet	*gedit_file_browser_glob_set_new	(const gchar * const     *patterns);
+void			 gedit_file_browser_glob_set_free	(GeditFileBrowserGlobSet *set);
+gboolean		 gedit_file_browser_glob_set_match	(GeditFileBrowserGlobSet *set,
+								 const gchar             *name);
+
+gboolean		 gedit_file_browser_glob_narrows	(const gchar             *old_pattern,
+								 const gchar             *new_pattern);
+
+G_END_DECLS
+
+#endif /* __GEDIT_FILE_BROWSER_GLOB_H__ */
+/* ex:ts=8:noet: */
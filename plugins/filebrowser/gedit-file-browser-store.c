@@ -32,6 +32,7 @@
 #include "gedit-file-browser-marshal.h"
 #include "gedit-file-browser-enum-types.h"
 #include "gedit-file-browser-error.h"
+#include "gedit-file-browser-glob.h"
 #include "gedit-file-browser-utils.h"
 
 #define NODE_IS_DIR(node)		(FILE_IS_DIR((node)->flags))
@@ -44,6 +45,9 @@
 #define FILE_BROWSER_NODE_DIR(node)	((FileBrowserNodeDir *)(node))
 
 #define DIRECTORY_LOAD_ITEMS_PER_CALLBACK 100
+#define MAX_PARALLEL_DELETES 8
+#define DELETE_BATCH_INTERVAL 100 /* ms */
+#define MAX_EMBLEMED_ICONS 256
 #define STANDARD_ATTRIBUTE_TYPES G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
 				 G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
 			 	 G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
@@ -55,6 +59,7 @@ typedef struct _FileBrowserNode    FileBrowserNode;
 typedef struct _FileBrowserNodeDir FileBrowserNodeDir;
 typedef struct _AsyncData	   AsyncData;
 typedef struct _AsyncNode	   AsyncNode;
+typedef struct _EmblemedIcon	   EmblemedIcon;
 
 typedef gint (*SortFunc) (FileBrowserNode *node1,
 			  FileBrowserNode *node2);
@@ -64,11 +69,23 @@ struct _AsyncData
 	GeditFileBrowserStore *model;
 	GCancellable *cancellable;
 	gboolean trash;
-	GList *files;
-	GList *iter;
+	GQueue *pending;
+	guint n_running;
+	/* Deleted, but not yet removed from the model */
+	GList *deleted;
+	/* Could not be trashed since there is no trash for them */
+	GList *no_trash;
+	gchar *error_message;
+	guint batch_id;
 	gboolean removed;
 };
 
+struct _EmblemedIcon
+{
+	GdkPixbuf *icon;
+	GdkPixbuf *emblem;
+};
+
 struct _AsyncNode
 {
 	FileBrowserNodeDir *dir;
@@ -87,9 +104,17 @@ struct _FileBrowserNode
 {
 	GFile *file;
 	guint flags;
+
+	/* The name, its collation key and, unless it was changed through
+	 * the model, the markup share a single allocation starting at
+	 * name. The markup is the name itself when it needs no escaping. */
 	gchar *name;
+	gchar *collate_key;
 	gchar *markup;
+	guint markup_in_names : 1;
 
+	/* The pixbuf is looked up from it once the row is shown */
+	GIcon *gicon;
 	GdkPixbuf *icon;
 	GdkPixbuf *emblem;
 
@@ -119,10 +144,15 @@ struct _GeditFileBrowserStorePrivate
 	gpointer filter_user_data;
 
 	gchar **binary_patterns;
-	GPtrArray *binary_pattern_specs;
+	GeditFileBrowserGlobSet *binary_globs;
 
 	SortFunc sort_func;
 
+	/* GIcon -> GdkPixbuf */
+	GHashTable *icons;
+	/* EmblemedIcon -> GdkPixbuf */
+	GHashTable *emblemed_icons;
+
 	GSList *async_handles;
 	MountInfo *mount_info;
 };
@@ -137,6 +167,13 @@ static void model_remove_node                               (GeditFileBrowserSto
 
 static void set_virtual_root_from_node                      (GeditFileBrowserStore  *model,
 				                             FileBrowserNode        *node);
+static void model_load_icon                                 (GeditFileBrowserStore  *model,
+							     FileBrowserNode        *node);
+static void on_icon_theme_changed                           (GeditFileBrowserStore  *model);
+static guint emblemed_icon_hash                             (gconstpointer           key);
+static gboolean emblemed_icon_equal                         (gconstpointer           a,
+							     gconstpointer           b);
+static void emblemed_icon_free                              (EmblemedIcon           *key);
 
 static void gedit_file_browser_store_iface_init             (GtkTreeModelIface      *iface);
 static GtkTreeModelFlags gedit_file_browser_store_get_flags (GtkTreeModel           *tree_model);
@@ -252,10 +289,13 @@ gedit_file_browser_store_finalize (GObject *object)
 	/* Free all the nodes */
 	file_browser_node_free (obj, obj->priv->root);
 
+	g_hash_table_destroy (obj->priv->icons);
+	g_hash_table_destroy (obj->priv->emblemed_icons);
+
 	if (obj->priv->binary_patterns != NULL)
 	{
 		g_strfreev (obj->priv->binary_patterns);
-		g_ptr_array_unref (obj->priv->binary_pattern_specs);
+		gedit_file_browser_glob_set_free (obj->priv->binary_globs);
 	}
 
 	/* Cancel any asynchronous operations */
@@ -494,6 +534,21 @@ gedit_file_browser_store_init (GeditFileBrowserStore *obj)
 	/* Default filter mode is hiding the hidden files */
 	obj->priv->filter_mode = gedit_file_browser_store_filter_mode_get_default ();
 	obj->priv->sort_func = model_sort_default;
+
+	obj->priv->icons = g_hash_table_new_full (g_icon_hash,
+						  (GEqualFunc) g_icon_equal,
+						  g_object_unref,
+						  g_object_unref);
+	obj->priv->emblemed_icons = g_hash_table_new_full (emblemed_icon_hash,
+							   emblemed_icon_equal,
+							   (GDestroyNotify) emblemed_icon_free,
+							   g_object_unref);
+
+	g_signal_connect_object (gtk_icon_theme_get_default (),
+				 "changed",
+				 G_CALLBACK (on_icon_theme_changed),
+				 obj,
+				 G_CONNECT_SWAPPED);
 }
 
 static gboolean
@@ -725,6 +780,10 @@ gedit_file_browser_store_get_value (GtkTreeModel *tree_model,
 			g_value_set_uint (value, node->flags);
 			break;
 		case GEDIT_FILE_BROWSER_STORE_COLUMN_ICON:
+			/* Only the rows that are shown need their icon */
+			if (node->icon == NULL)
+				model_load_icon (GEDIT_FILE_BROWSER_STORE (tree_model), node);
+
 			g_value_set_object (value, node->icon);
 			break;
 		case GEDIT_FILE_BROWSER_STORE_COLUMN_NAME:
@@ -1062,31 +1121,12 @@ model_node_update_visibility (GeditFileBrowserStore *model,
 			node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
 			return;
 		}
-		else if (model->priv->binary_patterns != NULL)
+		else if (model->priv->binary_globs != NULL &&
+			 gedit_file_browser_glob_set_match (model->priv->binary_globs,
+							    node->name))
 		{
-			gint i;
-			gssize name_length;
-			gchar *name_reversed;
-
-			name_length = strlen (node->name);
-			name_reversed = g_utf8_strreverse (node->name, name_length);
-
-			for (i = 0; i < model->priv->binary_pattern_specs->len; ++i)
-			{
-				GPatternSpec *spec;
-
-				spec = g_ptr_array_index (model->priv->binary_pattern_specs, i);
-
-				if (g_pattern_match (spec, name_length,
-				                     node->name, name_reversed))
-				{
-					node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
-					g_free (name_reversed);
-					return;
-				}
-			}
-
-			g_free (name_reversed);
+			node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
+			return;
 		}
 	}
 
@@ -1116,18 +1156,7 @@ collate_nodes (FileBrowserNode *node1,
 	}
 	else
 	{
-		gchar *k1, *k2;
-		gint result;
-
-		k1 = g_utf8_collate_key_for_filename (node1->name, -1);
-		k2 = g_utf8_collate_key_for_filename (node2->name, -1);
-
-		result = strcmp (k1, k2);
-
-		g_free (k1);
-		g_free (k2);
-
-		return result;
+		return strcmp (node1->collate_key, node2->collate_key);
 	}
 }
 
@@ -1270,10 +1299,15 @@ row_deleted (GeditFileBrowserStore *model,
 	gtk_tree_path_free (copy);
 }
 
+/* When narrowed is TRUE, the filters are known to only hide more files
+ * than before, so the files that are already filtered are not checked
+ * again.
+ */
 static void
 model_refilter_node (GeditFileBrowserStore  *model,
 		     FileBrowserNode        *node,
-		     GtkTreePath           **path)
+		     GtkTreePath           **path,
+		     gboolean                narrowed)
 {
 	gboolean old_visible;
 	gboolean new_visible;
@@ -1286,6 +1320,9 @@ model_refilter_node (GeditFileBrowserStore  *model,
 	if (node == NULL)
 		return;
 
+	if (narrowed && NODE_IS_FILTERED (node) && !NODE_IS_DIR (node))
+		return;
+
 	old_visible = model_node_visibility (model, node);
 	model_node_update_visibility (model, node);
 
@@ -1313,7 +1350,8 @@ model_refilter_node (GeditFileBrowserStore  *model,
 		{
 			model_refilter_node (model,
 					     (FileBrowserNode *) (item->data),
-					     path);
+					     path,
+					     narrowed);
 		}
 
 		if (in_tree)
@@ -1353,24 +1391,73 @@ model_refilter_node (GeditFileBrowserStore  *model,
 static void
 model_refilter (GeditFileBrowserStore *model)
 {
-	model_refilter_node (model, model->priv->root, NULL);
+	model_refilter_node (model, model->priv->root, NULL, FALSE);
 }
 
 static void
-file_browser_node_set_name (FileBrowserNode *node)
+file_browser_node_free_names (FileBrowserNode *node)
 {
+	if (!node->markup_in_names)
+		g_free (node->markup);
+
 	g_free (node->name);
-	g_free (node->markup);
 
-	if (node->file)
-		node->name = gedit_file_browser_utils_file_basename (node->file);
+	node->name = NULL;
+	node->collate_key = NULL;
+	node->markup = NULL;
+	node->markup_in_names = FALSE;
+}
+
+/* Takes ownership of name. The collation key is computed once here, so
+ * that sorting a directory does not have to compute it on each
+ * comparison. */
+static void
+file_browser_node_set_names (FileBrowserNode *node,
+			     gchar           *name)
+{
+	gchar *key;
+	gchar *markup;
+	gsize name_size;
+	gsize key_size;
+	gsize markup_size;
+	gchar *names;
+
+	file_browser_node_free_names (node);
+
+	if (name == NULL)
+		return;
+
+	key = g_utf8_collate_key_for_filename (name, -1);
+	markup = g_markup_escape_text (name, -1);
+
+	name_size = strlen (name) + 1;
+	key_size = strlen (key) + 1;
+	markup_size = strcmp (markup, name) != 0 ? strlen (markup) + 1 : 0;
+
+	names = g_malloc (name_size + key_size + markup_size);
+
+	node->name = memcpy (names, name, name_size);
+	node->collate_key = memcpy (names + name_size, key, key_size);
+
+	if (markup_size != 0)
+		node->markup = memcpy (names + name_size + key_size, markup, markup_size);
 	else
-		node->name = NULL;
+		node->markup = node->name;
+
+	node->markup_in_names = TRUE;
 
-	if (node->name)
-		node->markup = g_markup_escape_text (node->name, -1);
+	g_free (name);
+	g_free (key);
+	g_free (markup);
+}
+
+static void
+file_browser_node_set_name (FileBrowserNode *node)
+{
+	if (node->file)
+		file_browser_node_set_names (node, gedit_file_browser_utils_file_basename (node->file));
 	else
-		node->markup = NULL;
+		file_browser_node_free_names (node);
 }
 
 static void
@@ -1470,14 +1557,16 @@ file_browser_node_free (GeditFileBrowserStore *model,
 		g_object_unref (node->file);
 	}
 
+	if (node->gicon)
+		g_object_unref (node->gicon);
+
 	if (node->icon)
 		g_object_unref (node->icon);
 
 	if (node->emblem)
 		g_object_unref (node->emblem);
 
-	g_free (node->name);
-	g_free (node->markup);
+	file_browser_node_free_names (node);
 
 	if (NODE_IS_DIR (node))
 		g_slice_free (FileBrowserNodeDir, (FileBrowserNodeDir *)node);
@@ -1693,83 +1782,196 @@ file_browser_node_unload (GeditFileBrowserStore *model,
 	node->flags &= ~GEDIT_FILE_BROWSER_STORE_FLAG_LOADED;
 }
 
+static GdkPixbuf *
+get_cached_icon (GeditFileBrowserStore *model,
+		 GIcon                 *gicon)
+{
+	GdkPixbuf *pixbuf;
+
+	pixbuf = g_hash_table_lookup (model->priv->icons, gicon);
+
+	if (pixbuf != NULL)
+		return pixbuf;
+
+	pixbuf = gedit_file_browser_utils_pixbuf_from_icon (gicon, GTK_ICON_SIZE_MENU);
+
+	if (pixbuf != NULL)
+		g_hash_table_insert (model->priv->icons, g_object_ref (gicon), pixbuf);
+
+	return pixbuf;
+}
+
+static GdkPixbuf *
+get_cached_icon_from_name (GeditFileBrowserStore *model,
+			   const gchar           *name)
+{
+	GIcon *gicon;
+	GdkPixbuf *pixbuf;
+
+	gicon = g_themed_icon_new (name);
+	pixbuf = get_cached_icon (model, gicon);
+	g_object_unref (gicon);
+
+	return pixbuf;
+}
+
+static guint
+emblemed_icon_hash (gconstpointer key)
+{
+	const EmblemedIcon *emblemed = key;
+
+	return g_direct_hash (emblemed->icon) ^ g_direct_hash (emblemed->emblem);
+}
+
+static gboolean
+emblemed_icon_equal (gconstpointer a,
+		     gconstpointer b)
+{
+	const EmblemedIcon *emblemed_a = a;
+	const EmblemedIcon *emblemed_b = b;
+
+	return emblemed_a->icon == emblemed_b->icon &&
+	       emblemed_a->emblem == emblemed_b->emblem;
+}
+
 static void
-model_recomposite_icon_real (GeditFileBrowserStore *tree_model,
-			     FileBrowserNode       *node,
-			     GFileInfo             *info)
+emblemed_icon_free (EmblemedIcon *key)
 {
-	GdkPixbuf *icon;
+	if (key->icon != NULL)
+		g_object_unref (key->icon);
 
-	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model));
-	g_return_if_fail (node != NULL);
+	g_object_unref (key->emblem);
+	g_slice_free (EmblemedIcon, key);
+}
 
-	if (node->file == NULL)
-		return;
+static GdkPixbuf *
+get_emblemed_icon (GeditFileBrowserStore *model,
+		   GdkPixbuf             *icon,
+		   GdkPixbuf             *emblem)
+{
+	EmblemedIcon key = { icon, emblem };
+	EmblemedIcon *new_key;
+	GdkPixbuf *pixbuf;
+	gint icon_size;
 
-	if (info)
-	{
-		GIcon *gicon = g_file_info_get_icon (info);
+	pixbuf = g_hash_table_lookup (model->priv->emblemed_icons, &key);
 
-		if (gicon != NULL)
-			icon = gedit_file_browser_utils_pixbuf_from_icon (gicon, GTK_ICON_SIZE_MENU);
-		else
-			icon = NULL;
+	if (pixbuf != NULL)
+		return pixbuf;
+
+	gtk_icon_size_lookup (GTK_ICON_SIZE_MENU, NULL, &icon_size);
+
+	if (icon == NULL)
+	{
+		pixbuf = gdk_pixbuf_new (gdk_pixbuf_get_colorspace (emblem),
+					 gdk_pixbuf_get_has_alpha (emblem),
+					 gdk_pixbuf_get_bits_per_sample (emblem),
+					 icon_size,
+					 icon_size);
 	}
 	else
 	{
-		icon = gedit_file_browser_utils_pixbuf_from_file (node->file, GTK_ICON_SIZE_MENU, FALSE);
+		pixbuf = gdk_pixbuf_copy (icon);
 	}
 
+	gdk_pixbuf_composite (emblem, pixbuf,
+			      icon_size - 10, icon_size - 10, 10,
+			      10, icon_size - 10, icon_size - 10,
+			      1, 1, GDK_INTERP_NEAREST, 255);
+
+	/* Emblems can be replaced by new pixbufs any number of times */
+	if (g_hash_table_size (model->priv->emblemed_icons) >= MAX_EMBLEMED_ICONS)
+		g_hash_table_remove_all (model->priv->emblemed_icons);
+
+	new_key = g_slice_new (EmblemedIcon);
+	new_key->icon = icon != NULL ? g_object_ref (icon) : NULL;
+	new_key->emblem = g_object_ref (emblem);
+
+	g_hash_table_insert (model->priv->emblemed_icons, new_key, pixbuf);
+
+	return pixbuf;
+}
+
+/* The pixbufs are shared between all the nodes with equal icons, and
+ * between all the nodes with the same emblem on the same icon.
+ */
+static void
+model_load_icon (GeditFileBrowserStore *model,
+		 FileBrowserNode       *node)
+{
+	GdkPixbuf *icon = NULL;
+
+	if (node->file == NULL)
+		return;
+
+	if (node->gicon != NULL)
+		icon = get_cached_icon (model, node->gicon);
+	else if (NODE_IS_DIR (node))
+		icon = get_cached_icon_from_name (model, "folder-symbolic");
+
 	/* Fallback to the same icon as the file browser */
-	if (!icon)
-		icon = gedit_file_browser_utils_pixbuf_from_theme ("text-x-generic", GTK_ICON_SIZE_MENU);
+	if (icon == NULL)
+		icon = get_cached_icon_from_name (model, "text-x-generic");
 
-	if (node->icon)
-		g_object_unref (node->icon);
+	if (node->emblem != NULL)
+		icon = get_emblemed_icon (model, icon, node->emblem);
 
-	if (node->emblem)
+	if (icon != NULL)
+		node->icon = g_object_ref (icon);
+}
+
+static void
+model_unload_icon (FileBrowserNode *node)
+{
+	if (node->icon != NULL)
 	{
-		gint icon_size;
+		g_object_unref (node->icon);
+		node->icon = NULL;
+	}
+}
 
-		gtk_icon_size_lookup (GTK_ICON_SIZE_MENU, NULL, &icon_size);
+/* Only the rows whose icon was loaded have been shown, so only those are
+ * redrawn. Their icon is loaded again when they are drawn.
+ */
+static void
+model_reload_icons (GeditFileBrowserStore *model,
+		    FileBrowserNode       *node)
+{
+	if (node->icon != NULL)
+	{
+		model_unload_icon (node);
 
-		if (icon == NULL)
+		if (node != model->priv->virtual_root &&
+		    model_node_inserted (model, node))
 		{
-			node->icon =
-			    gdk_pixbuf_new (gdk_pixbuf_get_colorspace (node->emblem),
-					    gdk_pixbuf_get_has_alpha (node->emblem),
-					    gdk_pixbuf_get_bits_per_sample (node->emblem),
-					    icon_size,
-					    icon_size);
-		}
-		else
-		{
-			node->icon = gdk_pixbuf_copy (icon);
-			g_object_unref (icon);
-		}
+			GtkTreePath *path;
+			GtkTreeIter iter;
 
-		gdk_pixbuf_composite (node->emblem, node->icon,
-				      icon_size - 10, icon_size - 10, 10,
-				      10, icon_size - 10, icon_size - 10,
-				      1, 1, GDK_INTERP_NEAREST, 255);
+			path = gedit_file_browser_store_get_path_real (model, node);
+			iter.user_data = node;
+
+			gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+			gtk_tree_path_free (path);
+		}
 	}
-	else
+
+	if (NODE_IS_DIR (node))
 	{
-		node->icon = icon;
+		GSList *item;
+
+		for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
+			model_reload_icons (model, (FileBrowserNode *) (item->data));
 	}
 }
 
 static void
-model_recomposite_icon (GeditFileBrowserStore *tree_model,
-			GtkTreeIter           *iter)
+on_icon_theme_changed (GeditFileBrowserStore *model)
 {
-	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model));
-	g_return_if_fail (iter != NULL);
-	g_return_if_fail (iter->user_data != NULL);
+	g_hash_table_remove_all (model->priv->emblemed_icons);
+	g_hash_table_remove_all (model->priv->icons);
 
-	model_recomposite_icon_real (tree_model,
-				     (FileBrowserNode *) (iter->user_data),
-				     NULL);
+	if (model->priv->root != NULL)
+		model_reload_icons (model, model->priv->root);
 }
 
 static FileBrowserNode *
@@ -1779,8 +1981,7 @@ model_create_dummy_node (GeditFileBrowserStore *model,
 	FileBrowserNode *dummy;
 
 	dummy = file_browser_node_new (NULL, parent);
-	dummy->name = g_strdup (_("(Empty)"));
-	dummy->markup = g_markup_escape_text (dummy->name, -1);
+	file_browser_node_set_names (dummy, g_strdup (_("(Empty)")));
 
 	dummy->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_DUMMY;
 	dummy->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
@@ -2123,7 +2324,15 @@ file_browser_node_set_from_info (GeditFileBrowserStore *model,
 		}
 	}
 
-	model_recomposite_icon_real (model, node, info);
+	if (node->gicon != NULL)
+		g_object_unref (node->gicon);
+
+	node->gicon = g_file_info_get_icon (info);
+
+	if (node->gicon != NULL)
+		g_object_ref (node->gicon);
+
+	model_unload_icon (node);
 
 	if (free_info)
 		g_object_unref (info);
@@ -2131,7 +2340,7 @@ file_browser_node_set_from_info (GeditFileBrowserStore *model,
 	if (isadded)
 	{
 		path = gedit_file_browser_store_get_path_real (model, node);
-		model_refilter_node (model, node, &path);
+		model_refilter_node (model, node, &path, FALSE);
 		gtk_tree_path_free (path);
 
 		model_check_dummy (model, node->parent);
@@ -2293,9 +2502,6 @@ model_add_node_from_dir (GeditFileBrowserStore *model,
 		if (node->name == NULL)
 			file_browser_node_set_name (node);
 
-		if (node->icon == NULL)
-			node->icon = gedit_file_browser_utils_pixbuf_from_theme ("folder-symbolic", GTK_ICON_SIZE_MENU);
-
 		model_add_node (model, node, parent);
 	}
 
@@ -2973,8 +3179,11 @@ gedit_file_browser_store_set_value (GeditFileBrowserStore *tree_model,
 		if (!data)
 			data = g_strdup (node->name);
 
-		g_free (node->markup);
-		node->markup = g_strdup (data);
+		if (!node->markup_in_names)
+			g_free (node->markup);
+
+		node->markup = data;
+		node->markup_in_names = FALSE;
 	}
 	else if (column == GEDIT_FILE_BROWSER_STORE_COLUMN_EMBLEM)
 	{
@@ -2992,7 +3201,7 @@ gedit_file_browser_store_set_value (GeditFileBrowserStore *tree_model,
 		else
 			node->emblem = NULL;
 
-		model_recomposite_icon (tree_model, iter);
+		model_unload_icon (node);
 	}
 	else
 	{
@@ -3349,32 +3558,15 @@ gedit_file_browser_store_set_binary_patterns (GeditFileBrowserStore  *model,
 	if (model->priv->binary_patterns != NULL)
 	{
 		g_strfreev (model->priv->binary_patterns);
-		g_ptr_array_unref (model->priv->binary_pattern_specs);
+		gedit_file_browser_glob_set_free (model->priv->binary_globs);
 	}
 
 	model->priv->binary_patterns = g_strdupv ((gchar **) binary_patterns);
 
 	if (binary_patterns == NULL)
-	{
-		model->priv->binary_pattern_specs = NULL;
-	}
+		model->priv->binary_globs = NULL;
 	else
-	{
-		gint i;
-		gssize n_patterns;
-
-		n_patterns = g_strv_length ((gchar **) binary_patterns);
-
-		model->priv->binary_pattern_specs = g_ptr_array_sized_new (n_patterns);
-		g_ptr_array_set_free_func (model->priv->binary_pattern_specs,
-			                   (GDestroyNotify) g_pattern_spec_free);
-
-		for (i = 0; binary_patterns[i] != NULL; ++i)
-		{
-			g_ptr_array_add (model->priv->binary_pattern_specs,
-				         g_pattern_spec_new (binary_patterns[i]));
-		}
-	}
+		model->priv->binary_globs = gedit_file_browser_glob_set_new (binary_patterns);
 
 	model_refilter (model);
 
@@ -3387,6 +3579,18 @@ gedit_file_browser_store_refilter (GeditFileBrowserStore *model)
 	model_refilter (model);
 }
 
+/* Like gedit_file_browser_store_refilter(), for when the filter function
+ * changed in a way that can only hide more files, like a glob that got
+ * more specific. Only the files that are shown are checked again.
+ */
+void
+gedit_file_browser_store_refilter_narrowed (GeditFileBrowserStore *model)
+{
+	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (model));
+
+	model_refilter_node (model, model->priv->root, NULL, TRUE);
+}
+
 GeditFileBrowserStoreFilterMode
 gedit_file_browser_store_filter_mode_get_default (void)
 {
@@ -3538,8 +3742,14 @@ gedit_file_browser_store_rename (GeditFileBrowserStore  *model,
 static void
 async_data_free (AsyncData *data)
 {
+	if (data->batch_id != 0)
+		g_source_remove (data->batch_id);
+
 	g_object_unref (data->cancellable);
-	g_list_free_full (data->files, g_object_unref);
+	g_queue_free_full (data->pending, g_object_unref);
+	g_list_free_full (data->deleted, g_object_unref);
+	g_list_free_full (data->no_trash, g_object_unref);
+	g_free (data->error_message);
 
 	if (!data->removed)
 		data->model->priv->async_handles = g_slist_remove (data->model->priv->async_handles, data);
@@ -3553,106 +3763,274 @@ emit_no_trash (AsyncData *data)
 	/* Emit the no trash error */
 	gboolean ret;
 
-	g_signal_emit (data->model, model_signals[NO_TRASH], 0, data->files, &ret);
+	g_signal_emit (data->model, model_signals[NO_TRASH], 0, data->no_trash, &ret);
 
 	return ret;
 }
 
+/* The deleted files are removed from the model in batches, instead of
+ * each one as soon as it is deleted, so that deleting many files does not
+ * update the tree view in between every two of them.
+ */
 static void
-delete_file_finished (GFile        *file,
-		      GAsyncResult *res,
-		      AsyncData    *data)
+remove_deleted_nodes (AsyncData *data)
 {
-	GError *error = NULL;
-	gboolean ok;
+	GList *item;
 
-	if (data->trash)
+	if (data->batch_id != 0)
 	{
-		ok = g_file_trash_finish (file, res, &error);
+		g_source_remove (data->batch_id);
+		data->batch_id = 0;
 	}
-	else
+
+	if (!data->removed)
 	{
-		ok = g_file_delete_finish (file, res, &error);
+		for (item = data->deleted; item; item = item->next)
+		{
+			FileBrowserNode *node;
+
+			node = model_find_node (data->model, NULL, G_FILE (item->data));
+
+			if (node != NULL)
+				model_remove_node (data->model, node, NULL, TRUE);
+		}
 	}
 
-	if (ok)
+	g_list_free_full (data->deleted, g_object_unref);
+	data->deleted = NULL;
+}
+
+static gboolean
+delete_batch_timeout (AsyncData *data)
+{
+	data->batch_id = 0;
+	remove_deleted_nodes (data);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Takes ownership of @error */
+static void
+delete_file_done (AsyncData *data,
+		  GFile     *file,
+		  GError    *error)
+{
+	data->n_running--;
+
+	if (error == NULL)
 	{
-		/* Remove the file from the model */
-		FileBrowserNode *node = model_find_node (data->model, NULL, file);
+		data->deleted = g_list_prepend (data->deleted, g_object_ref (file));
 
-		if (node != NULL)
+		if (data->batch_id == 0)
 		{
-			model_remove_node (data->model, node, NULL, TRUE);
+			data->batch_id = g_timeout_add (DELETE_BATCH_INTERVAL,
+							(GSourceFunc) delete_batch_timeout,
+							data);
 		}
-
-		/* Process the next file */
-		data->iter = data->iter->next;
 	}
-	else if (!ok && error != NULL)
+	else if (data->trash &&
+		 g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
 	{
-		gint code = error->code;
+		data->no_trash = g_list_prepend (data->no_trash, g_object_ref (file));
+	}
+	else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED) &&
+		 data->error_message == NULL)
+	{
+		/* Only the first error is reported, the other files are
+		 * still deleted */
+		data->error_message = g_strdup (error->message);
+	}
+
+	if (error != NULL)
 		g_error_free (error);
 
-		if (data->trash && code == G_IO_ERROR_NOT_SUPPORTED)
+	delete_files (data);
+}
+
+static void
+trash_file_finished (GFile        *file,
+		     GAsyncResult *res,
+		     AsyncData    *data)
+{
+	GError *error = NULL;
+
+	g_file_trash_finish (file, res, &error);
+	delete_file_done (data, file, error);
+}
+
+static void
+delete_file_finished (GFile        *file,
+		      GAsyncResult *res,
+		      AsyncData    *data)
+{
+	GError *error = NULL;
+
+	g_task_propagate_boolean (G_TASK (res), &error);
+	delete_file_done (data, file, error);
+}
+
+/* Runs in a worker thread. Symbolic links are deleted, not followed. */
+static gboolean
+delete_recursive (GFile         *file,
+		  GCancellable  *cancellable,
+		  GError       **error)
+{
+	GFileEnumerator *enumerator;
+	GError *err = NULL;
+	gboolean ret = TRUE;
+
+	if (g_file_delete (file, cancellable, &err))
+		return TRUE;
+
+	if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_EMPTY))
+	{
+		g_propagate_error (error, err);
+		return FALSE;
+	}
+
+	g_clear_error (&err);
+
+	enumerator = g_file_enumerate_children (file,
+						G_FILE_ATTRIBUTE_STANDARD_NAME,
+						G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+						cancellable,
+						error);
+
+	if (enumerator == NULL)
+		return FALSE;
+
+	while (ret)
+	{
+		GFileInfo *info;
+		GFile *child;
+
+		info = g_file_enumerator_next_file (enumerator, cancellable, &err);
+
+		if (info == NULL)
 		{
-			/* Trash is not supported on this system. Ask the user
-			 * if he wants to delete completely the files instead.
-			 */
-			if (emit_no_trash (data))
+			if (err != NULL)
 			{
-				/* Changes this into a delete job */
-				data->trash = FALSE;
-				data->iter = data->files;
+				g_propagate_error (error, err);
+				ret = FALSE;
 			}
-			else
-			{
-				/* End the job */
-				async_data_free (data);
-				return;
-			}
-		}
-		else if (code == G_IO_ERROR_CANCELLED)
-		{
-			/* Job has been cancelled, end the job */
-			async_data_free (data);
-			return;
+
+			break;
 		}
+
+		child = g_file_get_child (file, g_file_info_get_name (info));
+		ret = delete_recursive (child, cancellable, error);
+
+		g_object_unref (child);
+		g_object_unref (info);
 	}
 
-	/* Continue the job */
-	delete_files (data);
+	g_file_enumerator_close (enumerator, NULL, NULL);
+	g_object_unref (enumerator);
+
+	return ret && g_file_delete (file, cancellable, error);
 }
 
+static void
+delete_file_thread (GTask        *task,
+		    gpointer      source_object,
+		    gpointer      task_data,
+		    GCancellable *cancellable)
+{
+	GError *error = NULL;
+
+	if (delete_recursive (G_FILE (source_object), cancellable, &error))
+		g_task_return_boolean (task, TRUE);
+	else
+		g_task_return_error (task, error);
+}
+
+/* Keeps up to MAX_PARALLEL_DELETES files being deleted at the same time,
+ * and ends the job once they are all done with.
+ */
 static void
 delete_files (AsyncData *data)
 {
-	GFile *file;
+	if (g_cancellable_is_cancelled (data->cancellable))
+	{
+		g_queue_foreach (data->pending, (GFunc) g_object_unref, NULL);
+		g_queue_clear (data->pending);
+	}
 
-	/* Check if our job is done */
-	if (data->iter == NULL)
+	while (data->n_running < MAX_PARALLEL_DELETES &&
+	       !g_queue_is_empty (data->pending))
 	{
-		async_data_free (data);
-		return;
+		GFile *file;
+
+		file = G_FILE (g_queue_pop_head (data->pending));
+		data->n_running++;
+
+		if (data->trash)
+		{
+			g_file_trash_async (file,
+					    G_PRIORITY_DEFAULT,
+					    data->cancellable,
+					    (GAsyncReadyCallback)trash_file_finished,
+					    data);
+		}
+		else
+		{
+			GTask *task;
+
+			/* Directories are deleted with their contents */
+			task = g_task_new (file,
+					   data->cancellable,
+					   (GAsyncReadyCallback)delete_file_finished,
+					   data);
+			g_task_run_in_thread (task, delete_file_thread);
+			g_object_unref (task);
+		}
+
+		g_object_unref (file);
 	}
 
-	file = G_FILE (data->iter->data);
+	if (data->n_running > 0)
+		return;
 
-	if (data->trash)
+	if (data->no_trash != NULL &&
+	    !data->removed &&
+	    !g_cancellable_is_cancelled (data->cancellable))
 	{
-		g_file_trash_async (file,
-				    G_PRIORITY_DEFAULT,
-				    data->cancellable,
-				    (GAsyncReadyCallback)delete_file_finished,
-				    data);
+		data->no_trash = g_list_reverse (data->no_trash);
+
+		/* Trash is not supported on this system. Ask the user
+		 * if he wants to delete completely the files instead.
+		 */
+		if (emit_no_trash (data))
+		{
+			GList *item;
+
+			/* Changes this into a delete job */
+			data->trash = FALSE;
+
+			for (item = data->no_trash; item; item = item->next)
+				g_queue_push_tail (data->pending, item->data);
+
+			g_list_free (data->no_trash);
+			data->no_trash = NULL;
+
+			delete_files (data);
+			return;
+		}
 	}
-	else
+
+	/* End the job */
+	remove_deleted_nodes (data);
+
+	if (data->error_message != NULL && !data->removed)
 	{
-		g_file_delete_async (file,
-				     G_PRIORITY_DEFAULT,
-				     data->cancellable,
-				     (GAsyncReadyCallback)delete_file_finished,
-				     data);
+		g_signal_emit (data->model,
+			       model_signals[ERROR],
+			       0,
+			       GEDIT_FILE_BROWSER_ERROR_DELETE,
+			       data->error_message);
 	}
+
+	async_data_free (data);
 }
 
 GeditFileBrowserStoreResult
@@ -3662,7 +4040,7 @@ gedit_file_browser_store_delete_all (GeditFileBrowserStore *model,
 {
 	FileBrowserNode *node;
 	AsyncData *data;
-	GList *files = NULL;
+	GQueue *files;
 	GList *row;
 	GtkTreeIter iter;
 	GtkTreePath *prev = NULL;
@@ -3677,6 +4055,7 @@ gedit_file_browser_store_delete_all (GeditFileBrowserStore *model,
 	   files/directories that are actually subfiles/directories of
 	   a directory that's also deleted */
 	rows = g_list_sort (g_list_copy (rows), (GCompareFunc)gtk_tree_path_compare);
+	files = g_queue_new ();
 
 	for (row = rows; row; row = row->next)
 	{
@@ -3692,17 +4071,15 @@ gedit_file_browser_store_delete_all (GeditFileBrowserStore *model,
 
 		prev = path;
 		node = (FileBrowserNode *)(iter.user_data);
-		files = g_list_prepend (files, g_object_ref (node->file));
+		g_queue_push_tail (files, g_object_ref (node->file));
 	}
 
-	data = g_slice_new (AsyncData);
+	data = g_slice_new0 (AsyncData);
 
 	data->model = model;
 	data->cancellable = g_cancellable_new ();
-	data->files = files;
+	data->pending = files;
 	data->trash = trash;
-	data->iter = files;
-	data->removed = FALSE;
 
 	model->priv->async_handles = g_slist_prepend (model->priv->async_handles, data);
 
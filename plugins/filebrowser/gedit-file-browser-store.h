@@ -174,6 +174,7 @@ void		 gedit_file_browser_store_set_binary_patterns	(GeditFileBrowserStore
 								 const gchar                     **binary_patterns);
 
 void		 gedit_file_browser_store_refilter		(GeditFileBrowserStore            *model);
+void		 gedit_file_browser_store_refilter_narrowed	(GeditFileBrowserStore            *model);
 GeditFileBrowserStoreFilterMode
 gedit_file_browser_store_filter_mode_get_default		(void);
 
@@ -33,6 +33,7 @@
 
 #include "gedit-file-browser-utils.h"
 #include "gedit-file-browser-error.h"
+#include "gedit-file-browser-glob.h"
 #include "gedit-file-browser-widget.h"
 #include "gedit-file-browser-view.h"
 #include "gedit-file-browser-store.h"
@@ -139,7 +140,7 @@ struct _GeditFileBrowserWidgetPrivate
 	GSList *filter_funcs;
 	gulong filter_id;
 	gulong glob_filter_id;
-	GPatternSpec *filter_pattern;
+	GeditFileBrowserGlobSet *filter_pattern;
 	gchar *filter_pattern_str;
 
 	GList *locations;
@@ -368,6 +369,7 @@ gedit_file_browser_widget_finalize (GObject *object)
 	GeditFileBrowserWidgetPrivate *priv = GEDIT_FILE_BROWSER_WIDGET (object)->priv;
 
 	g_free (priv->filter_pattern_str);
+	gedit_file_browser_glob_set_free (priv->filter_pattern);
 
 	G_OBJECT_CLASS (gedit_file_browser_widget_parent_class)->finalize (object);
 }
@@ -1246,8 +1248,8 @@ filter_glob (GeditFileBrowserWidget *obj,
 	}
 	else
 	{
-		result = g_pattern_match_string (obj->priv->filter_pattern,
-						 name);
+		result = gedit_file_browser_glob_set_match (obj->priv->filter_pattern,
+							    name);
 	}
 
 	g_free (name);
@@ -1592,6 +1594,7 @@ set_filter_pattern_real (GeditFileBrowserWidget *obj,
                         gboolean                 update_entry)
 {
 	GtkTreeModel *model;
+	gboolean narrowed;
 
 	model = gtk_tree_view_get_model (GTK_TREE_VIEW (obj->priv->treeview));
 
@@ -1606,6 +1609,13 @@ set_filter_pattern_real (GeditFileBrowserWidget *obj,
 		return;
 	}
 
+	/* Typing the pattern usually only makes it more specific, in which
+	 * case the files it already hides do not need to be matched again */
+	narrowed = pattern != NULL &&
+		   obj->priv->filter_pattern != NULL &&
+		   gedit_file_browser_glob_narrows (obj->priv->filter_pattern_str,
+						    pattern);
+
 	/* Free the old pattern */
 	g_free (obj->priv->filter_pattern_str);
 
@@ -1620,7 +1630,7 @@ set_filter_pattern_real (GeditFileBrowserWidget *obj,
 
 	if (obj->priv->filter_pattern)
 	{
-		g_pattern_spec_free (obj->priv->filter_pattern);
+		gedit_file_browser_glob_set_free (obj->priv->filter_pattern);
 		obj->priv->filter_pattern = NULL;
 	}
 
@@ -1635,7 +1645,9 @@ set_filter_pattern_real (GeditFileBrowserWidget *obj,
 	}
 	else
 	{
-		obj->priv->filter_pattern = g_pattern_spec_new (pattern);
+		const gchar *patterns[] = { pattern, NULL };
+
+		obj->priv->filter_pattern = gedit_file_browser_glob_set_new (patterns);
 
 		if (obj->priv->glob_filter_id == 0)
 		{
@@ -1655,7 +1667,10 @@ set_filter_pattern_real (GeditFileBrowserWidget *obj,
 
 	if (GEDIT_IS_FILE_BROWSER_STORE (model))
 	{
-		gedit_file_browser_store_refilter (GEDIT_FILE_BROWSER_STORE (model));
+		if (narrowed)
+			gedit_file_browser_store_refilter_narrowed (GEDIT_FILE_BROWSER_STORE (model));
+		else
+			gedit_file_browser_store_refilter (GEDIT_FILE_BROWSER_STORE (model));
 	}
 
 	g_object_notify (G_OBJECT (obj), "filter-pattern");
@@ -36,8 +36,10 @@ struct _GeditModelinePluginPrivate
 {
 	GeditView *view;
 
+	gulong document_load_handler_id;
 	gulong document_loaded_handler_id;
 	gulong document_saved_handler_id;
+	gulong insert_text_handler_id;
 };
 
 enum
@@ -143,11 +145,65 @@ gedit_modeline_plugin_get_property (GObject    *object,
 }
 
 static void
-on_document_loaded_or_saved (GeditDocument *document,
-			     const GError  *error,
-			     GtkSourceView *view)
+stop_watching_load (GeditModelinePlugin *plugin)
 {
-	modeline_parser_apply_modeline (view);
+	if (plugin->priv->insert_text_handler_id != 0)
+	{
+		GtkTextBuffer *doc;
+
+		doc = gtk_text_view_get_buffer (GTK_TEXT_VIEW (plugin->priv->view));
+
+		g_signal_handler_disconnect (doc, plugin->priv->insert_text_handler_id);
+		plugin->priv->insert_text_handler_id = 0;
+	}
+}
+
+/* The text is inserted a chunk at a time while loading: apply the modelines
+ * of the first lines as soon as they are there, instead of when the whole
+ * document has already been displayed with the default settings.
+ */
+static void
+on_insert_text (GtkTextBuffer       *buffer,
+		GtkTextIter         *location,
+		const gchar         *text,
+		gint                 len,
+		GeditModelinePlugin *plugin)
+{
+	if (gtk_text_buffer_get_line_count (buffer) <= 10)
+		return;
+
+	gedit_debug_message (DEBUG_PLUGINS, "Head of the document loaded");
+
+	stop_watching_load (plugin);
+
+	modeline_parser_apply_head_modeline (GTK_SOURCE_VIEW (plugin->priv->view));
+}
+
+static void
+on_document_load (GeditDocument       *document,
+		  GFile               *location,
+		  const GeditEncoding *encoding,
+		  gint                 line_pos,
+		  gint                 column_pos,
+		  gboolean             create,
+		  GeditModelinePlugin *plugin)
+{
+	stop_watching_load (plugin);
+
+	plugin->priv->insert_text_handler_id =
+		g_signal_connect_after (document, "insert-text",
+					G_CALLBACK (on_insert_text),
+					plugin);
+}
+
+static void
+on_document_loaded_or_saved (GeditDocument       *document,
+			     const GError        *error,
+			     GeditModelinePlugin *plugin)
+{
+	stop_watching_load (plugin);
+
+	modeline_parser_apply_modeline (GTK_SOURCE_VIEW (plugin->priv->view));
 }
 
 static void
@@ -164,14 +220,18 @@ gedit_modeline_plugin_activate (GeditViewActivatable *activatable)
 
 	doc = gtk_text_view_get_buffer (GTK_TEXT_VIEW (plugin->priv->view));
 
+	plugin->priv->document_load_handler_id =
+		g_signal_connect (doc, "load",
+				  G_CALLBACK (on_document_load),
+				  plugin);
 	plugin->priv->document_loaded_handler_id =
 		g_signal_connect (doc, "loaded",
 				  G_CALLBACK (on_document_loaded_or_saved),
-				  plugin->priv->view);
+				  plugin);
 	plugin->priv->document_saved_handler_id =
 		g_signal_connect (doc, "saved",
 				  G_CALLBACK (on_document_loaded_or_saved),
-				  plugin->priv->view);
+				  plugin);
 }
 
 static void
@@ -186,6 +246,9 @@ gedit_modeline_plugin_deactivate (GeditViewActivatable *activatable)
 
 	doc = gtk_text_view_get_buffer (GTK_TEXT_VIEW (plugin->priv->view));
 
+	stop_watching_load (plugin);
+
+	g_signal_handler_disconnect (doc, plugin->priv->document_load_handler_id);
 	g_signal_handler_disconnect (doc, plugin->priv->document_loaded_handler_id);
 	g_signal_handler_disconnect (doc, plugin->priv->document_saved_handler_id);
 }
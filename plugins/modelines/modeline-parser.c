@@ -674,109 +674,147 @@ free_modeline_options (ModelineOptions *options)
 	g_slice_free (ModelineOptions, options);
 }
 
-void
-modeline_parser_apply_modeline (GtkSourceView *view)
+/* Parses the lines between start and end, the first of them being
+ * first_line (counted starting at one). The text is fetched once and
+ * split in place, instead of fetching each line separately.
+ */
+static void
+parse_lines (GtkTextBuffer     *buffer,
+	     const GtkTextIter *start,
+	     const GtkTextIter *end,
+	     gint               first_line,
+	     gint               line_count,
+	     ModelineOptions   *options)
 {
-	ModelineOptions options;
-	GtkTextBuffer *buffer;
-	GtkTextIter iter, liter;
-	gint line_count;
-	GSettings *settings;
+	gchar *text;
+	gchar *line;
+	gchar *p;
+	gint line_number;
 
-	options.language_id = NULL;
-	options.set = MODELINE_SET_NONE;
+	text = gtk_text_buffer_get_text (buffer, start, end, TRUE);
 
-	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
-	gtk_text_buffer_get_start_iter (buffer, &iter);
+	line = text;
+	line_number = first_line;
 
-	line_count = gtk_text_buffer_get_line_count (buffer);
-
-	/* Parse the modelines on the 10 first lines... */
-	while ((gtk_text_iter_get_line (&iter) < 10) &&
-	       !gtk_text_iter_is_end (&iter))
+	for (p = text; ; p++)
 	{
-		gchar *line;
+		if (*p == '\n' || *p == '\r' || *p == '\0')
+		{
+			gboolean last = (*p == '\0');
 
-		liter = iter;
-		gtk_text_iter_forward_to_line_end (&iter);
-		line = gtk_text_buffer_get_text (buffer, &liter, &iter, TRUE);
+			if (*p == '\r' && *(p + 1) == '\n')
+			{
+				*(p++) = '\0';
+			}
 
-		parse_modeline (line,
-				1 + gtk_text_iter_get_line (&iter),
-				line_count,
-				&options);
+			*p = '\0';
 
-		gtk_text_iter_forward_line (&iter);
+			parse_modeline (line, line_number, line_count, options);
 
-		g_free (line);
+			if (last)
+				break;
+
+			line = p + 1;
+			line_number++;
+		}
 	}
 
-	/* ...and on the 10 last ones (modelines are not allowed in between) */
-	if (!gtk_text_iter_is_end (&iter))
-	{
-		gint cur_line;
-		guint remaining_lines;
+	g_free (text);
+}
 
-		/* we are on the 11th line (count from 0) */
-		cur_line = gtk_text_iter_get_line (&iter);
-		/* g_assert (10 == cur_line); */
+/* Modelines are only allowed on the 10 first and the 10 last lines */
+static void
+parse_buffer (GtkTextBuffer   *buffer,
+	      gboolean         head_only,
+	      ModelineOptions *options)
+{
+	GtkTextIter start, end;
+	gint line_count;
 
-		remaining_lines = line_count - cur_line - 1;
+	line_count = gtk_text_buffer_get_line_count (buffer);
 
-		if (remaining_lines > 10)
-		{
-			gtk_text_buffer_get_end_iter (buffer, &iter);
-			gtk_text_iter_backward_lines (&iter, 9);
-		}
-	}
+	gtk_text_buffer_get_start_iter (buffer, &start);
 
-	while (!gtk_text_iter_is_end (&iter))
+	if (head_only || line_count > 20)
 	{
-		gchar *line;
+		end = start;
+		gtk_text_iter_forward_lines (&end, 9);
 
-		liter = iter;
-		gtk_text_iter_forward_to_line_end (&iter);
-		line = gtk_text_buffer_get_text (buffer, &liter, &iter, TRUE);
+		if (!gtk_text_iter_ends_line (&end))
+			gtk_text_iter_forward_to_line_end (&end);
 
-		parse_modeline (line,
-				1 + gtk_text_iter_get_line (&iter),
-				line_count,
-				&options);
+		/* While loading, the end of the document is not known yet:
+		 * do not let the head lines match the rules for the last
+		 * lines.
+		 */
+		parse_lines (buffer, &start, &end, 1,
+			     head_only ? G_MAXINT : line_count,
+			     options);
 
-		gtk_text_iter_forward_line (&iter);
+		if (head_only)
+			return;
 
-		g_free (line);
+		gtk_text_buffer_get_iter_at_line (buffer, &start, line_count - 10);
 	}
 
-	/* Try to set language */
-	if (has_option (&options, MODELINE_SET_LANGUAGE) && options.language_id)
+	gtk_text_buffer_get_end_iter (buffer, &end);
+
+	parse_lines (buffer, &start, &end,
+		     1 + gtk_text_iter_get_line (&start),
+		     line_count,
+		     options);
+}
+
+static void
+set_language (GtkTextBuffer   *buffer,
+	      ModelineOptions *options)
+{
+	if (g_ascii_strcasecmp (options->language_id, "text") == 0)
+	{
+		gedit_document_set_language (GEDIT_DOCUMENT (buffer),
+		                             NULL);
+	}
+	else
 	{
-		if (g_ascii_strcasecmp (options.language_id, "text") == 0)
+	        GtkSourceLanguageManager *manager;
+	        GtkSourceLanguage *language;
+
+	        manager = gtk_source_language_manager_get_default ();
+
+		language = gtk_source_language_manager_get_language
+				(manager, options->language_id);
+		if (language != NULL)
 		{
 			gedit_document_set_language (GEDIT_DOCUMENT (buffer),
-			                             NULL);
+			                             language);
 		}
 		else
 		{
-		        GtkSourceLanguageManager *manager;
-		        GtkSourceLanguage *language;
+			gedit_debug_message (DEBUG_PLUGINS,
+					     "Unknown language `%s'",
+					     options->language_id);
+		}
+	}
+}
 
-		        manager = gtk_source_language_manager_get_default ();
+void
+modeline_parser_apply_modeline (GtkSourceView *view)
+{
+	ModelineOptions options;
+	GtkTextBuffer *buffer;
+	GSettings *settings;
 
-			language = gtk_source_language_manager_get_language
-					(manager, options.language_id);
-			if (language != NULL)
-			{
-				gedit_document_set_language (GEDIT_DOCUMENT (buffer),
-				                             language);
-			}
-			else
-			{
-				gedit_debug_message (DEBUG_PLUGINS,
-						     "Unknown language `%s'",
-						     options.language_id);
-			}
-		}
+	options.language_id = NULL;
+	options.set = MODELINE_SET_NONE;
+
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+
+	parse_buffer (buffer, FALSE, &options);
+
+	/* Try to set language */
+	if (has_option (&options, MODELINE_SET_LANGUAGE) && options.language_id)
+	{
+		set_language (buffer, &options);
 	}
 
 	ModelineOptions *previous = g_object_get_data (G_OBJECT (buffer),
@@ -884,4 +922,61 @@ modeline_parser_apply_modeline (GtkSourceView *view)
 	g_free (options.language_id);
 }
 
+/* Applies the modelines found on the first lines while the document is
+ * still being loaded, so that the view is set up before the rest of the
+ * text comes in. Nothing is restored or recorded here: the whole document
+ * is handled by modeline_parser_apply_modeline() once it is loaded, and
+ * finds at least the same options.
+ */
+void
+modeline_parser_apply_head_modeline (GtkSourceView *view)
+{
+	ModelineOptions options;
+	GtkTextBuffer *buffer;
+
+	options.language_id = NULL;
+	options.set = MODELINE_SET_NONE;
+
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+
+	parse_buffer (buffer, TRUE, &options);
+
+	if (has_option (&options, MODELINE_SET_LANGUAGE) && options.language_id)
+	{
+		set_language (buffer, &options);
+	}
+
+	if (has_option (&options, MODELINE_SET_INSERT_SPACES))
+	{
+		gtk_source_view_set_insert_spaces_instead_of_tabs (view, options.insert_spaces);
+	}
+
+	if (has_option (&options, MODELINE_SET_TAB_WIDTH))
+	{
+		gtk_source_view_set_tab_width (view, options.tab_width);
+	}
+
+	if (has_option (&options, MODELINE_SET_INDENT_WIDTH))
+	{
+		gtk_source_view_set_indent_width (view, options.indent_width);
+	}
+
+	if (has_option (&options, MODELINE_SET_WRAP_MODE))
+	{
+		gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), options.wrap_mode);
+	}
+
+	if (has_option (&options, MODELINE_SET_RIGHT_MARGIN_POSITION))
+	{
+		gtk_source_view_set_right_margin_position (view, options.right_margin_position);
+	}
+
+	if (has_option (&options, MODELINE_SET_SHOW_RIGHT_MARGIN))
+	{
+		gtk_source_view_set_show_right_margin (view, options.display_right_margin);
+	}
+
+	g_free (options.language_id);
+}
+
 /* vi:ts=8 */
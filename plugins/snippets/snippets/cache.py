@@ -0,0 +1,145 @@
+#    Gedit snippets plugin
+#    Copyright (C) 2014  The gedit Team
+#
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+import os
+import marshal
+import tempfile
+
+import xml.etree.ElementTree as et
+from .helper import snippets_debug
+
+# Keeps the parsed contents of the snippets libraries, so that they don't
+# have to be parsed again as long as their files did not change. Each
+# entry is keyed on the library path and stores the modification time and
+# size of the file it was built from, the attributes of the root element
+# and, once the library has been loaded, the attributes and properties of
+# each snippet.
+class SnippetsCache:
+        MAGIC = b'GSNC'
+        VERSION = 1
+
+        def __init__(self, path):
+                self.path = path
+                self.entries = {}
+                self.dirty = False
+
+                self.read()
+
+        def read(self):
+                try:
+                        with open(self.path, 'rb') as f:
+                                if f.read(len(self.MAGIC)) != self.MAGIC:
+                                        return
+
+                                data = marshal.load(f)
+                except (IOError, OSError, EOFError, ValueError, TypeError):
+                        return
+
+                if not isinstance(data, dict) or data.get('version') != self.VERSION:
+                        return
+
+                self.entries = data['files']
+                snippets_debug('Read snippets cache: ', self.path)
+
+        def save(self):
+                if not self.dirty:
+                        return
+
+                dirname = os.path.dirname(self.path)
+
+                try:
+                        if not os.path.isdir(dirname):
+                                os.makedirs(dirname, 0o755)
+
+                        fd, tmp = tempfile.mkstemp(prefix='.snippets-cache', dir=dirname)
+
+                        with os.fdopen(fd, 'wb') as f:
+                                f.write(self.MAGIC)
+                                marshal.dump({'version': self.VERSION, 'files': self.entries}, f)
+
+                        os.replace(tmp, self.path)
+                        self.dirty = False
+                except (IOError, OSError):
+                        # The cache is only an optimization
+                        snippets_debug('Could not write snippets cache: ', self.path)
+
+        def _stamp(self, path):
+                try:
+                        st = os.stat(path)
+                except OSError:
+                        return None
+
+                return (st.st_mtime_ns, st.st_size)
+
+        def lookup(self, path):
+                entry = self.entries.get(path)
+
+                if entry is None or entry['stamp'] != self._stamp(path):
+                        return None
+
+                return entry
+
+        def store_root(self, path, attrib):
+                stamp = self._stamp(path)
+
+                if stamp is None:
+                        return
+
+                entry = self.entries.get(path)
+
+                if entry is None or entry['stamp'] != stamp or entry['root'] != attrib:
+                        self.entries[path] = {'stamp': stamp, 'root': dict(attrib), 'snippets': None}
+                        self.dirty = True
+
+        def store_snippets(self, path, root_attrib, elements):
+                stamp = self._stamp(path)
+
+                if stamp is None:
+                        return
+
+                snippets = []
+
+                for element in elements:
+                        props = [(child.tag, child.text) for child in element]
+                        snippets.append((dict(element.attrib), props))
+
+                self.entries[path] = {'stamp': stamp, 'root': dict(root_attrib), 'snippets': snippets}
+                self.dirty = True
+
+        def forget(self, path):
+                if path in self.entries:
+                        del self.entries[path]
+                        self.dirty = True
+
+        # Rebuilds the elements the library would have created by parsing
+        # its file.
+        def build_elements(self, entry):
+                root = et.Element('snippets', entry['root'])
+                elements = []
+
+                for attrib, props in entry['snippets']:
+                        element = et.SubElement(root, 'snippet', attrib)
+
+                        for tag, text in props:
+                                child = et.SubElement(element, tag)
+                                child.text = text
+
+                        elements.append(element)
+
+                return root, elements
+
+# ex:ts=8:et:
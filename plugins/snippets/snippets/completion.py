@@ -101,16 +101,22 @@ class Provider(GObject.Object, GtkSource.CompletionProvider):
         def get_proposals(self, word):
                 if self.proposals:
                         proposals = self.proposals
+
+                        # Filter based on the current word
+                        if word:
+                                proposals = (x for x in proposals if x['tag'].startswith(word))
+                elif word:
+                        # Only walks the tab trigger index down the word
+                        proposals = Library().complete_tag(word, None)
+
+                        if self.language_id:
+                                proposals += Library().complete_tag(word, self.language_id)
                 else:
                         proposals = Library().get_snippets(None)
 
                         if self.language_id:
                                 proposals += Library().get_snippets(self.language_id)
 
-                # Filter based on the current word
-                if word:
-                        proposals = (x for x in proposals if x['tag'].startswith(word))
-
                 return [Proposal(x) for x in proposals]
 
         def do_populate(self, context):
@@ -25,6 +25,7 @@ from gi.repository import Gdk, Gtk
 
 import xml.etree.ElementTree as et
 from .helper import *
+from .cache import SnippetsCache
 
 class NamespacedId:
         def __init__(self, namespace, id):
@@ -266,11 +267,73 @@ class SnippetsTreeBuilder(et.TreeBuilder):
 
                 return result
 
+# Prefix tree on the tab triggers of a language, so that completing a word
+# only walks the characters of the word instead of testing every snippet.
+# Each node is a [children, snippets] pair.
+class TagTrie:
+        def __init__(self):
+                self.root = [{}, []]
+
+        def add(self, tag, snippet):
+                node = self.root
+
+                for c in tag:
+                        children = node[0]
+
+                        if not c in children:
+                                children[c] = [{}, []]
+
+                        node = children[c]
+
+                node[1].append(snippet)
+
+        def remove(self, tag, snippet):
+                path = []
+                node = self.root
+
+                for c in tag:
+                        if not c in node[0]:
+                                return
+
+                        path.append((node, c))
+                        node = node[0][c]
+
+                try:
+                        node[1].remove(snippet)
+                except ValueError:
+                        return
+
+                # Prune the nodes that lead nowhere anymore
+                while path and not node[0] and not node[1]:
+                        parent, c = path.pop()
+                        del parent[0][c]
+                        node = parent
+
+        def complete(self, prefix):
+                node = self.root
+
+                for c in prefix:
+                        node = node[0].get(c)
+
+                        if node is None:
+                                return []
+
+                result = []
+                stack = [node]
+
+                while stack:
+                        node = stack.pop()
+                        result.extend(node[1])
+                        stack.extend(node[0].values())
+
+                return result
+
 class LanguageContainer:
         def __init__(self, language):
                 self.language = language
                 self.snippets = []
                 self.snippets_by_prop = {'tag': {}, 'accelerator': {}, 'drop-targets': {}}
+                self.tag_trie = TagTrie()
                 self.accel_group = Gtk.AccelGroup()
                 self._refs = 0
 
@@ -299,6 +362,9 @@ class LanguageContainer:
                         else:
                                 snippets[val] = [snippet]
 
+                        if prop == 'tag':
+                                self.tag_trie.add(val, snippet)
+
         def _remove_prop(self, snippet, prop, value=0):
                 if value == 0:
                         value = snippet[prop]
@@ -323,6 +389,9 @@ class LanguageContainer:
                         except:
                                 True
 
+                        if prop == 'tag':
+                                self.tag_trie.remove(val, snippet)
+
         def append(self, snippet):
                 tag = snippet['tag']
                 accelerator = snippet['accelerator']
@@ -375,6 +444,9 @@ class LanguageContainer:
                         else:
                                 return []
 
+        def complete_tag(self, prefix):
+                return self.tag_trie.complete(prefix)
+
         def ref(self):
                 self._refs += 1
 
@@ -410,6 +482,7 @@ class SnippetsSystemFile:
                         self.language = self.language.lower()
 
         def _set_root(self, element):
+                self.root_attrib = dict(element.attrib)
                 self.set_language(element)
 
         def _preprocess_element(self, element):
@@ -492,6 +565,9 @@ class SnippetsSystemFile:
                 snippets_debug("Loading library (" + str(self.language) + "): " + \
                                 self.path)
 
+                if self.load_cached():
+                        return
+
                 self.loaded = False
                 self.ok = False
                 self.loading_elements = []
@@ -506,24 +582,54 @@ class SnippetsSystemFile:
                                         del self.loading_elements[:]
                                         return
 
+                # Store the elements before adding the snippets, which may
+                # normalize them
+                Library().cache.store_snippets(self.path, self.root_attrib,
+                                               self.loading_elements)
+
                 for element in self.loading_elements:
                         snippet = Library().add_snippet(self, element)
 
                 del self.loading_elements[:]
                 self.ok = True
 
+        def load_cached(self):
+                entry = Library().cache.lookup(self.path)
+
+                if entry is None or entry['snippets'] is None:
+                        return False
+
+                root, elements = Library().cache.build_elements(entry)
+
+                self._set_root(root)
+                self.loaded = True
+
+                for element in elements:
+                        Library().add_snippet(self, element)
+
+                self.ok = True
+                return True
+
         # This function will get the language for a file by just inspecting the
         # root element of the file. This is provided so that a cache can be built
         # for which file contains which language.
         # It returns the name of the language
         def ensure_language(self):
                 if not self.loaded:
+                        entry = Library().cache.lookup(self.path)
+
+                        if entry is not None:
+                                self.set_language(et.Element('snippets', entry['root']))
+                                self.ok = True
+                                return
+
                         self.ok = False
 
                         for element in self.parse_xml(256):
                                 if element[1]:
                                         if element[0].tag == 'snippets':
                                                 self.set_language(element[0])
+                                                Library().cache.store_root(self.path, element[0].attrib)
                                                 self.ok = True
 
                                         break
@@ -663,6 +769,11 @@ class Library(Singleton):
                 self.overridden = {}
                 self.loaded_ids = []
 
+                # The cache lives next to the user snippets, in the gedit
+                # configuration directory
+                self.cache = SnippetsCache(os.path.join(os.path.dirname(userdir),
+                                                        'snippets.cache'))
+
                 self.loaded = False
 
         def add_accelerator_callback(self, cb):
@@ -817,6 +928,7 @@ class Library(Singleton):
 
                 if library.path and os.path.isfile(library.path):
                         os.unlink(library.path)
+                        self.cache.forget(library.path)
 
                 try:
                         self.libraries[library.language].remove(library)
@@ -921,6 +1033,8 @@ class Library(Singleton):
                                 for library in self.libraries[lang]:
                                         library.ensure()
 
+                self.cache.save()
+
         def ensure_files(self):
                 if self.loaded:
                         return
@@ -979,6 +1093,18 @@ class Library(Singleton):
 
                 return list(self.containers[language].snippets)
 
+        # Get snippets whose tab trigger starts with prefix
+        def complete_tag(self, prefix, language=None):
+                self.ensure_files()
+                language = self.normalize_language(language)
+
+                if not language in self.libraries:
+                        return []
+
+                self.ensure(language)
+
+                return self.containers[language].complete_tag(prefix)
+
         # Get snippets for a given accelerator
         def from_accelerator(self, accelerator, language=None):
                 return self._from_prop('accelerator', accelerator, language)
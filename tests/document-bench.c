@@ -0,0 +1,589 @@
+/*
+ * document-bench.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2014 - The gedit Team
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+/* Measures how fast files of various kinds and sizes are loaded and
+ * saved, run with "make bench". Each result is printed as a line of JSON
+ * so that the numbers can be compared between runs:
+ *
+ *   {"operation":"load","corpus":"ascii","size":1048576,...}
+ *
+ * For each run the wall time, the growth of the memory allocated with
+ * malloc and the peak resident set size are reported. The wall time is
+ * the best of the iterations, the other numbers are the ones of the last
+ * iteration. The allocated memory is only known where mallinfo() is
+ * available, and the peak can only be reset on Linux, elsewhere it is
+ * the peak of the whole process.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gedit-document.h"
+#include <gio/gio.h>
+#include <gtk/gtk.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#if defined (HAVE_MALLINFO2) || defined (HAVE_MALLINFO)
+#include <malloc.h>
+#endif
+
+typedef enum
+{
+	CORPUS_ASCII,
+	CORPUS_UTF8,
+	CORPUS_LATIN1,
+	CORPUS_UTF16,
+	CORPUS_CRLF,
+	CORPUS_GZIP,
+	CORPUS_LONG_LINE,
+	CORPUS_SHORT_LINES
+} CorpusType;
+
+typedef struct
+{
+	CorpusType   type;
+	const gchar *name;
+	const gchar *suffix;
+	const gchar *charset;
+} Corpus;
+
+static const Corpus corpora[] =
+{
+	{ CORPUS_ASCII, "ascii", ".txt", "UTF-8" },
+	{ CORPUS_UTF8, "utf8", ".txt", "UTF-8" },
+	{ CORPUS_LATIN1, "latin1", ".txt", "ISO-8859-1" },
+	{ CORPUS_UTF16, "utf16", ".txt", "UTF-16" },
+	{ CORPUS_CRLF, "crlf", ".txt", "UTF-8" },
+	{ CORPUS_GZIP, "gzip", ".txt.gz", "UTF-8" },
+	{ CORPUS_LONG_LINE, "long-line", ".txt", "UTF-8" },
+	{ CORPUS_SHORT_LINES, "short-lines", ".txt", "UTF-8" }
+};
+
+static const gchar *ascii_words[] =
+{
+	"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog",
+	"static", "void", "gint", "return", "buffer", "iter", "window", "{", "}"
+};
+
+static const gchar *utf8_words[] =
+{
+	"héllo", "wörld", "ñandú", "çava", "日本語", "テキスト", "ελληνικά",
+	"кириллица", "emoji", "€uro", "naïve", "straße"
+};
+
+static const gchar *latin1_words[] =
+{
+	"héllo", "wörld", "ñandú", "çava", "naïve", "straße", "façade",
+	"déjà", "vu", "über", "señor"
+};
+
+static gchar *opt_sizes = NULL;
+static gint opt_iterations = 3;
+static gchar *opt_output = NULL;
+static gchar *opt_corpus = NULL;
+
+static GOptionEntry options[] =
+{
+	{ "sizes", 's', 0, G_OPTION_ARG_STRING, &opt_sizes,
+	  "Comma separated list of file sizes in KiB (default: 64,1024,16384)", "SIZES" },
+	{ "iterations", 'n', 0, G_OPTION_ARG_INT, &opt_iterations,
+	  "Number of times each file is loaded and saved (default: 3)", "N" },
+	{ "corpus", 'c', 0, G_OPTION_ARG_STRING, &opt_corpus,
+	  "Only run the given corpus", "NAME" },
+	{ "output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output,
+	  "Write the results to FILE instead of stdout", "FILE" },
+	{ NULL }
+};
+
+/* Allocated memory */
+
+/* Returns the bytes allocated with malloc and not freed yet, or -1 */
+static gint64
+get_allocated_bytes (void)
+{
+#if defined (HAVE_MALLINFO2)
+	struct mallinfo2 info = mallinfo2 ();
+
+	return (gint64) info.uordblks + (gint64) info.hblkhd;
+#elif defined (HAVE_MALLINFO)
+	/* The counters wrap around past 2 GiB, which the runs stay below */
+	struct mallinfo info = mallinfo ();
+
+	return (gint64) (guint) info.uordblks + (gint64) (guint) info.hblkhd;
+#else
+	return -1;
+#endif
+}
+
+/* Peak resident set size */
+
+static void
+reset_peak_rss (void)
+{
+	static gboolean warned = FALSE;
+	FILE *clear_refs;
+	gboolean reset = FALSE;
+
+	/* Resets VmHWM on Linux. This file can not be replaced like
+	 * g_file_set_contents() does, it must be written in place. */
+	clear_refs = fopen ("/proc/self/clear_refs", "w");
+
+	if (clear_refs != NULL)
+	{
+		reset = fputs ("5", clear_refs) >= 0;
+		reset = fclose (clear_refs) == 0 && reset;
+	}
+
+	if (!reset && !warned)
+	{
+		g_printerr ("Could not reset the peak resident set size: %s\n",
+		            g_strerror (errno));
+		warned = TRUE;
+	}
+}
+
+static glong
+get_peak_rss (void)
+{
+	gchar *status;
+	glong peak = -1;
+
+	if (g_file_get_contents ("/proc/self/status", &status, NULL, NULL))
+	{
+		gchar *hwm = strstr (status, "VmHWM:");
+
+		if (hwm != NULL)
+		{
+			peak = strtol (hwm + strlen ("VmHWM:"), NULL, 10);
+		}
+
+		g_free (status);
+	}
+
+	if (peak < 0)
+	{
+		struct rusage usage;
+
+		getrusage (RUSAGE_SELF, &usage);
+		peak = usage.ru_maxrss;
+	}
+
+	return peak;
+}
+
+/* Corpus generation */
+
+static void
+append_words (GString      *text,
+              GRand        *rand,
+              const gchar **words,
+              gint          n_words,
+              gsize         size,
+              const gchar  *newline)
+{
+	gsize line_start = text->len;
+
+	while (text->len < size)
+	{
+		if (text->len - line_start > 72)
+		{
+			g_string_append (text, newline);
+			line_start = text->len;
+		}
+		else
+		{
+			if (text->len != line_start)
+			{
+				g_string_append_c (text, ' ');
+			}
+
+			g_string_append (text, words[g_rand_int_range (rand, 0, n_words)]);
+		}
+	}
+}
+
+/* Returns the contents of the file in UTF-8, the size is the one of the
+ * text before it is converted and compressed. */
+static gchar *
+generate_text (const Corpus *corpus,
+               gsize         size)
+{
+	GString *text;
+	GRand *rand;
+
+	text = g_string_sized_new (size + 16);
+	rand = g_rand_new_with_seed (size);
+
+	switch (corpus->type)
+	{
+		case CORPUS_ASCII:
+		case CORPUS_GZIP:
+			append_words (text, rand, ascii_words, G_N_ELEMENTS (ascii_words), size, "\n");
+			break;
+		case CORPUS_UTF8:
+		case CORPUS_UTF16:
+			append_words (text, rand, utf8_words, G_N_ELEMENTS (utf8_words), size, "\n");
+			break;
+		case CORPUS_LATIN1:
+			append_words (text, rand, latin1_words, G_N_ELEMENTS (latin1_words), size, "\n");
+			break;
+		case CORPUS_CRLF:
+			append_words (text, rand, ascii_words, G_N_ELEMENTS (ascii_words), size, "\r\n");
+			break;
+		case CORPUS_LONG_LINE:
+			append_words (text, rand, ascii_words, G_N_ELEMENTS (ascii_words), size, " ");
+			break;
+		case CORPUS_SHORT_LINES:
+			while (text->len < size)
+			{
+				g_string_append_printf (text, "%c\n", 'a' + g_rand_int_range (rand, 0, 26));
+			}
+			break;
+	}
+
+	g_rand_free (rand);
+
+	return g_string_free (text, FALSE);
+}
+
+static GFile *
+write_corpus (const gchar  *dir,
+              const Corpus *corpus,
+              gsize         size)
+{
+	GFile *file;
+	GFileOutputStream *file_stream;
+	GOutputStream *stream;
+	gchar *text;
+	gchar *contents;
+	gsize length;
+	gchar *filename;
+	gchar *path;
+	GError *error = NULL;
+
+	text = generate_text (corpus, size);
+
+	if (g_strcmp0 (corpus->charset, "UTF-8") != 0)
+	{
+		contents = g_convert (text, -1, corpus->charset, "UTF-8", NULL, &length, &error);
+		g_assert_no_error (error);
+		g_free (text);
+	}
+	else
+	{
+		contents = text;
+		length = strlen (text);
+	}
+
+	filename = g_strdup_printf ("%s-%" G_GSIZE_FORMAT "%s", corpus->name, size, corpus->suffix);
+	path = g_build_filename (dir, filename, NULL);
+	file = g_file_new_for_path (path);
+
+	file_stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, &error);
+	g_assert_no_error (error);
+
+	if (corpus->type == CORPUS_GZIP)
+	{
+		GZlibCompressor *compressor;
+
+		compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+		stream = g_converter_output_stream_new (G_OUTPUT_STREAM (file_stream),
+		                                        G_CONVERTER (compressor));
+
+		g_object_unref (compressor);
+		g_object_unref (file_stream);
+	}
+	else
+	{
+		stream = G_OUTPUT_STREAM (file_stream);
+	}
+
+	g_output_stream_write_all (stream, contents, length, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	g_output_stream_close (stream, NULL, &error);
+	g_assert_no_error (error);
+
+	g_object_unref (stream);
+	g_free (contents);
+	g_free (filename);
+	g_free (path);
+
+	return file;
+}
+
+/* Measurements */
+
+typedef struct
+{
+	gint64 wall;
+	gint64 allocated;
+	glong  peak_rss;
+} Result;
+
+static gboolean operation_completed;
+
+static void
+on_operation_done (GeditDocument *document,
+                   GError        *error,
+                   gpointer       user_data)
+{
+	g_assert_no_error (error);
+
+	operation_completed = TRUE;
+}
+
+static gint64 allocated_at_begin;
+
+static void
+measure_begin (gint64 *begin)
+{
+	reset_peak_rss ();
+
+	allocated_at_begin = get_allocated_bytes ();
+
+	*begin = g_get_monotonic_time ();
+}
+
+static void
+measure_end (Result *result,
+             gint64  begin,
+             gint    iteration)
+{
+	gint64 wall = g_get_monotonic_time () - begin;
+
+	if (iteration == 0 || wall < result->wall)
+	{
+		result->wall = wall;
+	}
+
+	if (allocated_at_begin >= 0)
+	{
+		result->allocated = get_allocated_bytes () - allocated_at_begin;
+	}
+	else
+	{
+		result->allocated = -1;
+	}
+
+	result->peak_rss = get_peak_rss ();
+}
+
+static void
+wait_for_operation (void)
+{
+	while (!operation_completed)
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+}
+
+static GeditDocument *
+load (GFile        *file,
+      const Corpus *corpus)
+{
+	GeditDocument *document;
+
+	document = gedit_document_new ();
+
+	g_signal_connect (document, "loaded", G_CALLBACK (on_operation_done), NULL);
+
+	operation_completed = FALSE;
+	gedit_document_load (document, file,
+	                     gedit_encoding_get_from_charset (corpus->charset),
+	                     0, 0, FALSE);
+	wait_for_operation ();
+
+	return document;
+}
+
+static void
+save (GeditDocument *document,
+      GFile         *file)
+{
+	gulong id;
+
+	id = g_signal_connect (document, "saved", G_CALLBACK (on_operation_done), NULL);
+
+	operation_completed = FALSE;
+	gedit_document_save_as (document, file,
+	                        gedit_document_get_encoding (document),
+	                        gedit_document_get_newline_type (document),
+	                        gedit_document_get_compression_type (document),
+	                        0);
+	wait_for_operation ();
+
+	g_signal_handler_disconnect (document, id);
+}
+
+static void
+print_result (FILE         *output,
+              const gchar  *operation,
+              const Corpus *corpus,
+              gsize         size,
+              const Result *result)
+{
+	fprintf (output,
+	         "{\"operation\":\"%s\",\"corpus\":\"%s\",\"size\":%" G_GSIZE_FORMAT ","
+	         "\"iterations\":%d,\"wall_us\":%" G_GINT64_FORMAT ","
+	         "\"allocated_bytes\":%" G_GINT64_FORMAT ",\"peak_rss_kb\":%ld}\n",
+	         operation, corpus->name, size,
+	         opt_iterations, result->wall,
+	         result->allocated, result->peak_rss);
+
+	fflush (output);
+}
+
+static void
+bench_corpus (FILE         *output,
+              const gchar  *dir,
+              const Corpus *corpus,
+              gsize         size)
+{
+	GFile *file;
+	GFile *saved;
+	gchar *path;
+	gchar *saved_path;
+	Result load_result = { 0 };
+	Result save_result = { 0 };
+	gint i;
+
+	file = write_corpus (dir, corpus, size);
+
+	path = g_file_get_path (file);
+	saved_path = g_strconcat (path, ".saved", corpus->suffix, NULL);
+	saved = g_file_new_for_path (saved_path);
+	g_free (saved_path);
+	g_free (path);
+
+	for (i = 0; i < opt_iterations; i++)
+	{
+		GeditDocument *document;
+		gint64 begin;
+
+		measure_begin (&begin);
+		document = load (file, corpus);
+		measure_end (&load_result, begin, i);
+
+		measure_begin (&begin);
+		save (document, saved);
+		measure_end (&save_result, begin, i);
+
+		g_object_unref (document);
+	}
+
+	print_result (output, "load", corpus, size, &load_result);
+	print_result (output, "save", corpus, size, &save_result);
+
+	g_file_delete (file, NULL, NULL);
+	g_file_delete (saved, NULL, NULL);
+
+	g_object_unref (file);
+	g_object_unref (saved);
+}
+
+int main (int   argc,
+          char *argv[])
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gchar **sizes;
+	gchar *dir;
+	FILE *output = stdout;
+	guint i;
+
+	gtk_init (&argc, &argv);
+
+	context = g_option_context_new ("- benchmark loading and saving documents");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+
+		return 1;
+	}
+
+	g_option_context_free (context);
+
+	if (opt_iterations < 1)
+	{
+		opt_iterations = 1;
+	}
+
+	if (opt_output != NULL)
+	{
+		output = fopen (opt_output, "w");
+
+		if (output == NULL)
+		{
+			g_printerr ("Could not open %s\n", opt_output);
+			return 1;
+		}
+	}
+
+	dir = g_dir_make_tmp ("gedit-bench-XXXXXX", &error);
+	g_assert_no_error (error);
+
+	sizes = g_strsplit (opt_sizes != NULL ? opt_sizes : "64,1024,16384", ",", 0);
+
+	for (i = 0; i < G_N_ELEMENTS (corpora); i++)
+	{
+		gchar **size;
+
+		if (opt_corpus != NULL && g_strcmp0 (opt_corpus, corpora[i].name) != 0)
+		{
+			continue;
+		}
+
+		for (size = sizes; *size != NULL; size++)
+		{
+			gsize kib = g_ascii_strtoull (*size, NULL, 10);
+
+			if (kib > 0)
+			{
+				bench_corpus (output, dir, &corpora[i], kib * 1024);
+			}
+		}
+	}
+
+	g_strfreev (sizes);
+
+	g_rmdir (dir);
+	g_free (dir);
+
+	if (output != stdout)
+	{
+		fclose (output);
+	}
+
+	return 0;
+}
+/* ex:ts=8:noet: */